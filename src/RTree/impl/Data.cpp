@@ -25,4 +25,9 @@ namespace RTree
         return m_region;
     }
 
+    void Data::setRegion(const Region &region)
+    {
+        m_region = region;
+    }
+
 } // namespace RTree
\ No newline at end of file
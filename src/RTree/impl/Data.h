@@ -19,6 +19,8 @@ namespace RTree {
         Data *clone() const;
         id_type getIdentifier() const;
         const Region &getRegion() const;
+        // Moves the entry; only for the tree holding it, which keeps its nodes in step
+        void setRegion(const Region &region);
 
     private:
         id_type m_id;
@@ -2,6 +2,7 @@
 #include "Region.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstring>
 #include <limits>
 #include <stdexcept>
@@ -9,11 +10,9 @@
 namespace RTree
 {
 
-    Region::Region(uint32_t dimension) : m_dimension(dimension)
+    Region::Region(uint32_t dimension)
     {
-
-        m_pLow = new double[dimension];
-        m_pHigh = new double[dimension];
+        allocate(dimension);
 
         for (uint32_t i = 0; i < dimension; ++i)
         {
@@ -22,24 +21,22 @@ namespace RTree
         }
     }
 
-    Region::Region(const double *low, const double *high, uint32_t dimension) : m_dimension(dimension)
+    Region::Region(const double *low, const double *high, uint32_t dimension)
     {
-        m_pLow = new double[dimension];
-        m_pHigh = new double[dimension];
+        allocate(dimension);
 
         memcpy(m_pLow, low, dimension * sizeof(double));
         memcpy(m_pHigh, high, dimension * sizeof(double));
     }
 
-    Region::Region(const Point &low, const Point &high) : m_dimension(low.getDimension())
+    Region::Region(const Point &low, const Point &high)
     {
         if (low.getDimension() != high.getDimension())
         {
             throw std::invalid_argument("Points must have the same dimension");
         }
 
-        m_pLow = new double[m_dimension];
-        m_pHigh = new double[m_dimension];
+        allocate(low.getDimension());
 
         for (uint32_t i = 0; i < m_dimension; ++i)
         {
@@ -48,19 +45,32 @@ namespace RTree
         }
     }
 
-    Region::Region(const Region &other) : m_dimension(other.m_dimension)
+    Region::Region(const Region &other)
+    {
+        allocate(other.m_dimension);
+
+        memcpy(m_pLow, other.m_pLow, 2 * m_dimension * sizeof(double));
+    }
+
+    Region::Region(Region &&other) noexcept
     {
-        m_pLow = new double[m_dimension];
-        m_pHigh = new double[m_dimension];
+        if (other.isInline())
+        {
+            allocate(other.m_dimension);
+            memcpy(m_pLow, other.m_pLow, 2 * m_dimension * sizeof(double));
+            return;
+        }
 
-        memcpy(m_pLow, other.m_pLow, m_dimension * sizeof(double));
-        memcpy(m_pHigh, other.m_pHigh, m_dimension * sizeof(double));
+        // Steal the heap block and leave other as an empty inline region
+        m_dimension = other.m_dimension;
+        m_pLow = other.m_pLow;
+        m_pHigh = other.m_pHigh;
+        other.allocate(0);
     }
 
     Region::~Region()
     {
-        delete[] m_pLow;
-        delete[] m_pHigh;
+        release();
     }
 
     Region &Region::operator=(const Region &other)
@@ -69,19 +79,61 @@ namespace RTree
         {
             if (m_dimension != other.m_dimension)
             {
-                delete[] m_pLow;
-                delete[] m_pHigh;
-                m_dimension = other.m_dimension;
-                m_pLow = new double[m_dimension];
-                m_pHigh = new double[m_dimension];
+                release();
+                allocate(other.m_dimension);
             }
 
-            memcpy(m_pLow, other.m_pLow, m_dimension * sizeof(double));
-            memcpy(m_pHigh, other.m_pHigh, m_dimension * sizeof(double));
+            memcpy(m_pLow, other.m_pLow, 2 * m_dimension * sizeof(double));
+        }
+        return *this;
+    }
+
+    Region &Region::operator=(Region &&other) noexcept
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        if (other.isInline())
+        {
+            if (m_dimension != other.m_dimension)
+            {
+                release();
+                allocate(other.m_dimension);
+            }
+            memcpy(m_pLow, other.m_pLow, 2 * m_dimension * sizeof(double));
+            return *this;
         }
+
+        release();
+        m_dimension = other.m_dimension;
+        m_pLow = other.m_pLow;
+        m_pHigh = other.m_pHigh;
+        other.allocate(0);
         return *this;
     }
 
+    void Region::allocate(uint32_t dimension)
+    {
+        m_dimension = dimension;
+        m_pLow = dimension <= kInlineDimensions ? m_inlineCoords : new double[2 * dimension];
+        m_pHigh = m_pLow + dimension;
+    }
+
+    void Region::release()
+    {
+        if (!isInline())
+        {
+            delete[] m_pLow;
+        }
+    }
+
+    bool Region::isInline() const
+    {
+        return m_pLow == m_inlineCoords;
+    }
+
     bool Region::operator==(const Region &other) const
     {
         if (m_dimension != other.m_dimension)
@@ -254,7 +306,8 @@ namespace RTree
         if (out.m_dimension != m_dimension)
         {
             // Adjust the dimension of out
-            out = Region(m_dimension);
+            out.release();
+            out.allocate(m_dimension);
         }
 
         for (uint32_t i = 0; i < m_dimension; ++i)
@@ -287,4 +340,14 @@ namespace RTree
         return m_dimension;
     }
 
+    const double *Region::getLowCoordinates() const
+    {
+        return m_pLow;
+    }
+
+    const double *Region::getHighCoordinates() const
+    {
+        return m_pHigh;
+    }
+
 } // namespace RTree
\ No newline at end of file
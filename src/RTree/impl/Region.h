@@ -16,9 +16,11 @@ namespace RTree {
         Region(const double *low, const double *high, uint32_t dimension);
         Region(const Point &low, const Point &high);
         Region(const Region &other);
+        Region(Region &&other) noexcept;
         ~Region();
 
         Region &operator=(const Region &other);
+        Region &operator=(Region &&other) noexcept;
         bool operator==(const Region &other) const;
 
         bool intersects(const Region &other) const;
@@ -38,10 +40,24 @@ namespace RTree {
         double getHigh(uint32_t index) const;
         uint32_t getDimension() const;
 
+        // Unchecked access to all getDimension() bounds, for the batched kernels
+        const double *getLowCoordinates() const;
+        const double *getHighCoordinates() const;
+
+        // Regions up to this dimension keep their coordinates inside the object
+        static constexpr uint32_t kInlineDimensions = 3;
+
     private:
         uint32_t m_dimension;
+        // Low and high bounds are contiguous (m_pHigh == m_pLow + m_dimension), either in
+        // m_inlineCoords or, above kInlineDimensions, in one heap block owned by the region
         double *m_pLow;
         double *m_pHigh;
+        double m_inlineCoords[2 * kInlineDimensions];
+
+        void allocate(uint32_t dimension);
+        void release();
+        bool isInline() const;
     };
 }
 
@@ -0,0 +1,44 @@
+//
+// Sink for query results, fed while the tree is being traversed.
+//
+
+#ifndef VISITOR_H
+#define VISITOR_H
+
+namespace RTree
+{
+    class Data;
+
+    // Implement visitData to receive every entry a query matches, in traversal order.
+    // Entries are owned by the tree and stay valid until the next insert or remove.
+    class Visitor
+    {
+    public:
+        virtual ~Visitor() = default;
+        virtual void visitData(Data *data) = 0;
+    };
+
+    // Writes every visited entry to an output iterator, e.g. std::back_inserter(results)
+    template <typename OutputIt>
+    class OutputIteratorVisitor : public Visitor
+    {
+    public:
+        explicit OutputIteratorVisitor(OutputIt out) : m_out(out) {}
+
+        void visitData(Data *data) override
+        {
+            *m_out = data;
+            ++m_out;
+        }
+
+        OutputIt getIterator() const
+        {
+            return m_out;
+        }
+
+    private:
+        OutputIt m_out;
+    };
+}
+
+#endif //VISITOR_H
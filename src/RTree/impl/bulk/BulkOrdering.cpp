@@ -0,0 +1,204 @@
+#include "BulkOrdering.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "HilbertCurve.h"
+#include "src/RTree/impl/concurrency/ParallelSort.h"
+#include "src/RTree/impl/concurrency/ThreadPool.h"
+
+namespace RTree::bulk
+{
+    namespace
+    {
+        // Orders items by one coordinate of their centers, then by index
+        struct AxisLess
+        {
+            const double *centers;
+            uint32_t dimension;
+            uint32_t axis;
+
+            bool operator()(size_t a, size_t b) const
+            {
+                const double ca = centers[a * dimension + axis];
+                const double cb = centers[b * dimension + axis];
+                return ca < cb || (ca == cb && a < b);
+            }
+        };
+
+        // Slab boundaries along one axis: P nodes are spread over S = ceil(P^(1/k)) slabs, k axes remaining
+        size_t slabSize(size_t count, uint32_t nodeCapacity, uint32_t axesLeft)
+        {
+            const size_t nodes = (count + nodeCapacity - 1) / nodeCapacity;
+            const size_t slabs = ceilRoot(nodes, axesLeft);
+            return static_cast<size_t>(nodeCapacity) * ((nodes + slabs - 1) / slabs);
+        }
+
+        void tileAxis(const double *centers, uint32_t dimension, uint32_t nodeCapacity,
+                      size_t *first, size_t *last, uint32_t axis)
+        {
+            const size_t count = last - first;
+            std::sort(first, last, AxisLess{centers, dimension, axis});
+
+            // The last axis only needs the sort; so does a run that already fits in one node
+            if (axis + 1 >= dimension || count <= nodeCapacity)
+            {
+                return;
+            }
+
+            const size_t size = slabSize(count, nodeCapacity, dimension - axis);
+            for (size_t begin = 0; begin < count; begin += size)
+            {
+                tileAxis(centers, dimension, nodeCapacity, first + begin, first + std::min(begin + size, count),
+                         axis + 1);
+            }
+        }
+    }
+
+    void sortTileRecursive(const double *centers, uint32_t dimension, uint32_t nodeCapacity,
+                           size_t *first, size_t *last, ThreadPool *pool)
+    {
+        // Sort the whole range by the first axis on all threads, then tile the slabs independently
+        const size_t count = last - first;
+        parallelSort(pool, first, last, AxisLess{centers, dimension, 0});
+        if (dimension <= 1 || count <= nodeCapacity)
+        {
+            return;
+        }
+
+        const size_t size = slabSize(count, nodeCapacity, dimension);
+        const size_t slabs = (count + size - 1) / size;
+        parallelFor(pool, slabs, [&](size_t begin, size_t end)
+                    {
+                        for (size_t slab = begin; slab < end; ++slab)
+                        {
+                            tileAxis(centers, dimension, nodeCapacity, first + slab * size,
+                                     first + std::min((slab + 1) * size, count), 1);
+                        }
+                    });
+    }
+
+    void hilbertSort(const double *centers, uint32_t dimension, size_t *first, size_t *last, ThreadPool *pool)
+    {
+        const size_t count = last - first;
+        if (count < 2 || dimension == 0)
+        {
+            return;
+        }
+
+        // Grid over the bounding box of the centers
+        std::vector<double> low(dimension, std::numeric_limits<double>::max());
+        std::vector<double> high(dimension, std::numeric_limits<double>::lowest());
+        for (size_t *it = first; it != last; ++it)
+        {
+            for (uint32_t d = 0; d < dimension; ++d)
+            {
+                low[d] = std::min(low[d], centers[*it * dimension + d]);
+                high[d] = std::max(high[d], centers[*it * dimension + d]);
+            }
+        }
+
+        const uint32_t bits = hilbertBitsPerDimension(dimension);
+        const uint32_t words = hilbertKeyWords(dimension);
+        const double cells = static_cast<double>((uint64_t{1} << bits) - 1);
+        std::vector<double> scale(dimension);
+        for (uint32_t d = 0; d < dimension; ++d)
+        {
+            const double extent = high[d] - low[d];
+            scale[d] = extent > 0 ? cells / extent : 0.0;
+        }
+
+        // Keys of items [begin, end) of the range; each worker brings its own scratch coordinates
+        auto computeKeys = [&](size_t begin, size_t end, auto &&storeKey)
+        {
+            std::vector<uint32_t> coords(dimension);
+            for (size_t i = begin; i < end; ++i)
+            {
+                for (uint32_t d = 0; d < dimension; ++d)
+                {
+                    const double cell = (centers[first[i] * dimension + d] - low[d]) * scale[d];
+                    coords[d] = static_cast<uint32_t>(std::clamp(cell, 0.0, cells));
+                }
+                hilbertKey(coords.data(), dimension, bits, storeKey(i));
+            }
+        };
+
+        if (words == 1)
+        {
+            // Single-word keys sort as (key, index) pairs, no indirection in the comparisons
+            std::vector<std::pair<uint64_t, size_t>> keyed(count);
+            parallelFor(pool, count, [&](size_t begin, size_t end)
+                        {
+                            computeKeys(begin, end, [&](size_t i)
+                                        {
+                                            keyed[i].second = first[i];
+                                            return &keyed[i].first;
+                                        });
+                        });
+            parallelSort(pool, keyed.begin(), keyed.end(), std::less<>());
+            for (size_t i = 0; i < count; ++i)
+            {
+                first[i] = keyed[i].second;
+            }
+            return;
+        }
+
+        // Wider keys, compared word by word from the most significant one
+        std::vector<uint64_t> keys(count * words);
+        std::vector<size_t> positions(count);
+        parallelFor(pool, count, [&](size_t begin, size_t end)
+                    {
+                        computeKeys(begin, end, [&](size_t i)
+                                    {
+                                        positions[i] = i;
+                                        return keys.data() + i * words;
+                                    });
+                    });
+        parallelSort(pool, positions.begin(), positions.end(), [&keys, words, first](size_t a, size_t b)
+                     {
+                         const auto keyA = keys.begin() + a * words;
+                         const auto keyB = keys.begin() + b * words;
+                         if (std::equal(keyA, keyA + words, keyB))
+                         {
+                             return first[a] < first[b];
+                         }
+                         return std::lexicographical_compare(keyA, keyA + words, keyB, keyB + words);
+                     });
+        std::vector<size_t> sorted(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            sorted[i] = first[positions[i]];
+        }
+        std::copy(sorted.begin(), sorted.end(), first);
+    }
+
+    size_t ceilRoot(size_t n, uint32_t k)
+    {
+        auto power = [k](size_t base)
+        {
+            double result = 1.0;
+            for (uint32_t i = 0; i < k; ++i)
+            {
+                result *= static_cast<double>(base);
+            }
+            return result;
+        };
+
+        // pow() is only a guess, fix it up so the exact integer property holds
+        size_t root = static_cast<size_t>(std::llround(std::pow(static_cast<double>(n), 1.0 / k)));
+        root = std::max<size_t>(root, 1);
+        while (power(root) < static_cast<double>(n))
+        {
+            ++root;
+        }
+        while (root > 1 && power(root - 1) >= static_cast<double>(n))
+        {
+            --root;
+        }
+        return root;
+    }
+}
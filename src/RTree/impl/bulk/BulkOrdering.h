@@ -0,0 +1,38 @@
+//
+// Orderings used by the bulk loaders: entries are sorted so that consecutive runs
+// of one node's worth of entries are spatially close, then packed in that order.
+//
+
+#ifndef BULKORDERING_H
+#define BULKORDERING_H
+#include <cstddef>
+#include <cstdint>
+
+namespace RTree
+{
+    class ThreadPool;
+}
+
+namespace RTree::bulk
+{
+    // Both orderings break ties by index, so the result does not depend on whether, and on how
+    // many threads of, pool were used to compute it.
+
+    // Sort-Tile-Recursive (Leutenegger et al.): sorts [first, last) by the first axis,
+    // cuts it into vertical slabs of whole nodes, and recursively tiles every slab by the
+    // remaining axes. Afterwards each consecutive run of nodeCapacity indices is one tile.
+    // centers holds dimension coordinates per item, indexed by the values in [first, last).
+    void sortTileRecursive(const double *centers, uint32_t dimension, uint32_t nodeCapacity,
+                           size_t *first, size_t *last, ThreadPool *pool = nullptr);
+
+    // Sorts [first, last) along the Hilbert curve through the items' centers, quantised on a grid
+    // spanning their bounding box. Consecutive runs of indices are then spatially close, which
+    // keeps packed nodes compact on clustered data where straight tiles cut through clusters.
+    void hilbertSort(const double *centers, uint32_t dimension, size_t *first, size_t *last,
+                     ThreadPool *pool = nullptr);
+
+    // Smallest s with s^k >= n, the number of slabs per axis STR uses
+    size_t ceilRoot(size_t n, uint32_t k);
+}
+
+#endif //BULKORDERING_H
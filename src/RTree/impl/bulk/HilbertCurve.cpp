@@ -0,0 +1,166 @@
+#include "HilbertCurve.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace RTree::bulk
+{
+    namespace
+    {
+        // Skilling, "Programming the Hilbert curve" (2004): turns the axes into the transposed
+        // Hilbert index, bit b of the index for axis i sitting in bit b of coords[i]
+        void axesToTranspose(uint32_t *coords, uint32_t dimension, uint32_t bits)
+        {
+            const uint32_t top = 1u << (bits - 1);
+
+            // Inverse undo. Written without branches: on random input the bit test is a coin
+            // flip, and mispredicting it would cost more than the rest of the key.
+            for (uint32_t q = top; q > 1; q >>= 1)
+            {
+                const uint32_t p = q - 1;
+                for (uint32_t i = 0; i < dimension; ++i)
+                {
+                    // set: all ones when bit q of axis i is set, i.e. invert the low bits of axis 0,
+                    // otherwise exchange the low bits of axes 0 and i
+                    const uint32_t set = 0u - ((coords[i] & q) != 0);
+                    const uint32_t t = (coords[0] ^ coords[i]) & p & ~set;
+                    coords[0] ^= (p & set) | t;
+                    coords[i] ^= t;
+                }
+            }
+
+            // Gray encode
+            for (uint32_t i = 1; i < dimension; ++i)
+            {
+                coords[i] ^= coords[i - 1];
+            }
+            uint32_t t = 0;
+            for (uint32_t q = top; q > 1; q >>= 1)
+            {
+                t ^= (q - 1) & (0u - ((coords[dimension - 1] & q) != 0));
+            }
+            for (uint32_t i = 0; i < dimension; ++i)
+            {
+                coords[i] ^= t;
+            }
+        }
+
+        // The plane curve is walked with a state machine instead: the state is which of the four
+        // rotations/reflections the current sub-square has, and a table advances it by 4 bits of
+        // x and y at once, so a 32-bit key takes 8 lookups.
+        struct HilbertTable2D
+        {
+            // Entry [state][x nibble << 4 | y nibble]: 8 key bits, next state in bits 8-9
+            uint16_t step[4][256];
+
+            HilbertTable2D()
+            {
+                for (uint32_t state = 0; state < 4; ++state)
+                {
+                    for (uint32_t nibbles = 0; nibbles < 256; ++nibbles)
+                    {
+                        uint32_t current = state;
+                        uint32_t digits = 0;
+                        for (int b = 3; b >= 0; --b)
+                        {
+                            // state bit 0: swap x and y, bit 1: complement both
+                            uint32_t rx = (nibbles >> (4 + b)) & 1u;
+                            uint32_t ry = (nibbles >> b) & 1u;
+                            if (current & 2u)
+                            {
+                                rx ^= 1u;
+                                ry ^= 1u;
+                            }
+                            if (current & 1u)
+                            {
+                                std::swap(rx, ry);
+                            }
+                            digits = (digits << 2) | ((3u * rx) ^ ry);
+                            if (ry == 0)
+                            {
+                                current ^= rx ? 3u : 1u;
+                            }
+                        }
+                        step[state][nibbles] = static_cast<uint16_t>(digits | (current << 8));
+                    }
+                }
+            }
+        };
+
+        uint64_t hilbertKey2D(uint32_t x, uint32_t y, uint32_t bits)
+        {
+            static const HilbertTable2D table;
+
+            // Pad to whole nibbles with low zero bits; the padded key is the real one followed by
+            // a fixed suffix, which the final shift drops again
+            const uint32_t padding = (4 - bits % 4) % 4;
+            const uint32_t nibbles = (bits + padding) / 4;
+            const uint64_t px = static_cast<uint64_t>(x) << padding;
+            const uint64_t py = static_cast<uint64_t>(y) << padding;
+
+            uint64_t key = 0;
+            uint32_t state = 0;
+            for (uint32_t n = nibbles; n-- > 0;)
+            {
+                const uint32_t index = static_cast<uint32_t>(((px >> (4 * n)) & 0xF) << 4 | ((py >> (4 * n)) & 0xF));
+                const uint16_t entry = table.step[state][index];
+                key = (key << 8) | (entry & 0xFF);
+                state = entry >> 8;
+            }
+            return key >> (2 * padding);
+        }
+
+        // Spread the low 21 bits of x so that bit b lands on bit 3b
+        uint64_t spreadBy2(uint64_t x)
+        {
+            x &= 0x1FFFFFull;
+            x = (x | (x << 32)) & 0x001F00000000FFFFull;
+            x = (x | (x << 16)) & 0x001F0000FF0000FFull;
+            x = (x | (x << 8)) & 0x100F00F00F00F00Full;
+            x = (x | (x << 4)) & 0x10C30C30C30C30C3ull;
+            x = (x | (x << 2)) & 0x1249249249249249ull;
+            return x;
+        }
+    }
+
+    uint32_t hilbertBitsPerDimension(uint32_t dimension)
+    {
+        return std::clamp<uint32_t>(64 / std::max<uint32_t>(dimension, 1), 8, 32);
+    }
+
+    uint32_t hilbertKeyWords(uint32_t dimension)
+    {
+        return (dimension * hilbertBitsPerDimension(dimension) + 63) / 64;
+    }
+
+    void hilbertKey(uint32_t *coords, uint32_t dimension, uint32_t bits, uint64_t *key)
+    {
+        if (dimension == 2 && bits <= 32)
+        {
+            key[0] = hilbertKey2D(coords[0], coords[1], bits);
+            return;
+        }
+
+        axesToTranspose(coords, dimension, bits);
+
+        // Interleave the transposed words, axis 0 taking the most significant bit of every group.
+        // Three axes use magic-number spreading instead of a loop per bit.
+        if (dimension == 3 && bits <= 21)
+        {
+            key[0] = (spreadBy2(coords[0]) << 2) | (spreadBy2(coords[1]) << 1) | spreadBy2(coords[2]);
+            return;
+        }
+
+        const uint32_t words = (dimension * bits + 63) / 64;
+        std::fill(key, key + words, 0);
+        for (uint32_t b = 0; b < bits; ++b)
+        {
+            for (uint32_t i = 0; i < dimension; ++i)
+            {
+                const uint64_t bit = (coords[i] >> b) & 1u;
+                const uint32_t position = b * dimension + (dimension - 1 - i);
+                key[words - 1 - position / 64] |= bit << (position % 64);
+            }
+        }
+    }
+}
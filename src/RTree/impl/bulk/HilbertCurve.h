@@ -0,0 +1,24 @@
+//
+// Hilbert curve keys of integer grid points in any number of dimensions.
+//
+
+#ifndef HILBERTCURVE_H
+#define HILBERTCURVE_H
+#include <cstddef>
+#include <cstdint>
+
+namespace RTree::bulk
+{
+    // Grid resolution per axis: as many bits as fit a 64-bit key, between 8 and 32.
+    // Above 8 dimensions the key spills into more words rather than losing resolution.
+    uint32_t hilbertBitsPerDimension(uint32_t dimension);
+
+    // Number of 64-bit words of a key, most significant word first
+    uint32_t hilbertKeyWords(uint32_t dimension);
+
+    // Hilbert index of the grid point coords (each < 2^bits) written to key[0..hilbertKeyWords).
+    // coords is used as scratch space and holds garbage afterwards.
+    void hilbertKey(uint32_t *coords, uint32_t dimension, uint32_t bits, uint64_t *key);
+}
+
+#endif //HILBERTCURVE_H
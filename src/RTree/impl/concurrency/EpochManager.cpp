@@ -0,0 +1,138 @@
+#include "EpochManager.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace RTree
+{
+    EpochManager::Guard::Guard(EpochManager *manager) : m_manager(manager)
+    {
+    }
+
+    EpochManager::Guard::~Guard()
+    {
+        if (m_manager != nullptr)
+        {
+            m_manager->unpin();
+        }
+    }
+
+    EpochManager::Guard::Guard(Guard &&other) noexcept : m_manager(other.m_manager)
+    {
+        other.m_manager = nullptr;
+    }
+
+    EpochManager::~EpochManager()
+    {
+        for (auto &[epoch, reclaim] : m_retired)
+        {
+            reclaim();
+        }
+    }
+
+    uint64_t EpochManager::nextInstanceId()
+    {
+        static std::atomic<uint64_t> counter{0};
+        return ++counter;
+    }
+
+    EpochManager::Slot &EpochManager::localSlot()
+    {
+        struct Cache
+        {
+            uint64_t manager = 0;
+            Slot *slot = nullptr;
+        };
+        thread_local Cache cache;
+        if (cache.manager == m_instanceId)
+        {
+            return *cache.slot;
+        }
+
+        std::lock_guard<std::mutex> lock(m_slotsMutex);
+        const std::thread::id self = std::this_thread::get_id();
+        auto it = std::find_if(m_slots.begin(), m_slots.end(), [self](const Slot &slot)
+                               { return slot.owner == self; });
+        Slot *slot;
+        if (it != m_slots.end())
+        {
+            slot = &*it;
+        }
+        else
+        {
+            slot = &m_slots.emplace_back();
+            slot->owner = self;
+        }
+        cache = {m_instanceId, slot};
+        return *slot;
+    }
+
+    EpochManager::Guard EpochManager::pin()
+    {
+        Slot &slot = localSlot();
+        if (slot.depth++ == 0)
+        {
+            // Sequentially consistent so that a writer scanning the slots either sees this pin or
+            // has already published everything this reader is about to load
+            slot.epoch.store(m_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        }
+        return Guard(this);
+    }
+
+    void EpochManager::unpin()
+    {
+        Slot &slot = localSlot();
+        if (--slot.depth == 0)
+        {
+            slot.epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    void EpochManager::retire(std::function<void()> reclaim)
+    {
+        m_retired.emplace_back(m_epoch.load(std::memory_order_relaxed), std::move(reclaim));
+    }
+
+    void EpochManager::advance()
+    {
+        m_epoch.fetch_add(1, std::memory_order_seq_cst);
+    }
+
+    size_t EpochManager::collect()
+    {
+        // Oldest epoch a reader still has pinned; anything retired before it is unreachable
+        uint64_t oldest = std::numeric_limits<uint64_t>::max();
+        {
+            std::lock_guard<std::mutex> lock(m_slotsMutex);
+            for (const Slot &slot : m_slots)
+            {
+                const uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+                if (epoch != 0)
+                {
+                    oldest = std::min(oldest, epoch);
+                }
+            }
+        }
+
+        size_t reclaimed = 0;
+        auto keep = std::partition(m_retired.begin(), m_retired.end(), [oldest](const auto &retired)
+                                   { return retired.first >= oldest; });
+        for (auto it = keep; it != m_retired.end(); ++it)
+        {
+            it->second();
+            ++reclaimed;
+        }
+        m_retired.erase(keep, m_retired.end());
+        return reclaimed;
+    }
+
+    size_t EpochManager::pendingCount() const
+    {
+        return m_retired.size();
+    }
+
+    uint64_t EpochManager::getEpoch() const
+    {
+        return m_epoch.load(std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,85 @@
+//
+// Epoch-based reclamation: memory unlinked by a writer is freed once no reader can still see it.
+//
+
+#ifndef EPOCHMANAGER_H
+#define EPOCHMANAGER_H
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace RTree
+{
+    // Readers pin the current epoch for as long as they hold pointers into shared structures.
+    // A writer that unlinks an object retires it with the epoch of the moment; advance() then moves
+    // the epoch on, and collect() runs the reclaim functions of everything retired before the oldest
+    // epoch still pinned. Readers never wait, pinning is two atomic stores.
+    class EpochManager
+    {
+    public:
+        // Unpins the reader's epoch when it goes out of scope
+        class Guard
+        {
+        public:
+            explicit Guard(EpochManager *manager);
+            ~Guard();
+
+            Guard(Guard &&other) noexcept;
+            Guard &operator=(Guard &&other) = delete;
+            Guard(const Guard &) = delete;
+            Guard &operator=(const Guard &) = delete;
+
+        private:
+            EpochManager *m_manager;
+        };
+
+        EpochManager() = default;
+        // Runs every pending reclaim function; no reader may be pinned any more
+        ~EpochManager();
+
+        EpochManager(const EpochManager &) = delete;
+        EpochManager &operator=(const EpochManager &) = delete;
+
+        // Called by readers, from any number of threads; pins nest on one thread
+        Guard pin();
+
+        // The remaining methods are for the writer, one thread at a time
+        void retire(std::function<void()> reclaim);
+        void advance();
+        // Reclaims what no pinned reader can reach, returns how many were reclaimed
+        size_t collect();
+
+        size_t pendingCount() const;
+        uint64_t getEpoch() const;
+
+    private:
+        // One per reader thread, padded so readers of different threads do not share a line
+        struct alignas(64) Slot
+        {
+            std::atomic<uint64_t> epoch{0}; // 0 while the thread is not pinned
+            uint32_t depth = 0;             // Nested pins, touched by the owner thread only
+            std::thread::id owner;
+        };
+
+        std::atomic<uint64_t> m_epoch{1};
+        // Slots are never removed, so references to them stay valid
+        std::deque<Slot> m_slots;
+        std::mutex m_slotsMutex;
+        // Distinguishes this manager in the per-thread slot cache, even after its address is reused
+        const uint64_t m_instanceId = nextInstanceId();
+
+        std::vector<std::pair<uint64_t, std::function<void()>>> m_retired;
+
+        static uint64_t nextInstanceId();
+        Slot &localSlot();
+        void unpin();
+    };
+}
+
+#endif //EPOCHMANAGER_H
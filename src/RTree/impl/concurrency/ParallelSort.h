@@ -0,0 +1,68 @@
+//
+// Sorting on a ThreadPool: sorted runs per worker, then pairwise merges.
+//
+
+#ifndef PARALLELSORT_H
+#define PARALLELSORT_H
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "ThreadPool.h"
+
+namespace RTree
+{
+    // Same result as std::sort(first, last, comp) whenever comp is a total order (ties broken
+    // deterministically), so parallel and sequential callers produce identical sequences.
+    // Without a pool, or for short ranges, this is std::sort.
+    template <typename RandomIt, typename Compare>
+    void parallelSort(ThreadPool *pool, RandomIt first, RandomIt last, Compare comp)
+    {
+        // Below this many items per run, spreading the sort costs more than it saves
+        constexpr size_t kMinRun = 1 << 14;
+
+        const size_t count = last - first;
+        const size_t runs = pool == nullptr ? 1 : std::min<size_t>(pool->getThreadCount(), count / kMinRun);
+        if (runs <= 1)
+        {
+            std::sort(first, last, comp);
+            return;
+        }
+
+        std::vector<size_t> bounds(runs + 1);
+        for (size_t r = 0; r <= runs; ++r)
+        {
+            bounds[r] = count * r / runs;
+        }
+
+        pool->parallelFor(runs, [&](size_t begin, size_t end)
+                          {
+                              for (size_t r = begin; r < end; ++r)
+                              {
+                                  std::sort(first + bounds[r], first + bounds[r + 1], comp);
+                              }
+                          });
+
+        // Merge neighbouring runs, doubling their width every round
+        for (size_t width = 1; width < runs; width *= 2)
+        {
+            const size_t merges = (runs + 2 * width - 1) / (2 * width);
+            pool->parallelFor(merges, [&](size_t begin, size_t end)
+                              {
+                                  for (size_t m = begin; m < end; ++m)
+                                  {
+                                      const size_t low = m * 2 * width;
+                                      const size_t middle = std::min(low + width, runs);
+                                      const size_t high = std::min(low + 2 * width, runs);
+                                      if (middle < high)
+                                      {
+                                          std::inplace_merge(first + bounds[low], first + bounds[middle],
+                                                             first + bounds[high], comp);
+                                      }
+                                  }
+                              });
+        }
+    }
+}
+
+#endif //PARALLELSORT_H
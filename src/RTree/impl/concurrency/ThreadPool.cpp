@@ -0,0 +1,58 @@
+#include "ThreadPool.h"
+
+namespace RTree
+{
+    ThreadPool::ThreadPool(unsigned threadCount)
+    {
+        if (threadCount == 0)
+        {
+            threadCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        m_workers.reserve(threadCount);
+        for (unsigned i = 0; i < threadCount; ++i)
+        {
+            m_workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopping = true;
+        }
+        m_wakeUp.notify_all();
+
+        // Workers drain the queue before they exit
+        for (std::thread &worker : m_workers)
+        {
+            worker.join();
+        }
+    }
+
+    unsigned ThreadPool::getThreadCount() const
+    {
+        return static_cast<unsigned>(m_workers.size());
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_wakeUp.wait(lock, [this]()
+                              { return m_stopping || !m_tasks.empty(); });
+                if (m_tasks.empty())
+                {
+                    return;
+                }
+                task = std::move(m_tasks.front());
+                m_tasks.pop_front();
+            }
+            task();
+        }
+    }
+}
@@ -0,0 +1,91 @@
+//
+// Fixed set of worker threads running submitted tasks.
+//
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace RTree
+{
+    class ThreadPool
+    {
+    public:
+        // threadCount 0 means one worker per hardware thread
+        explicit ThreadPool(unsigned threadCount);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        unsigned getThreadCount() const;
+
+        // Queue task for the next idle worker; the future reports completion and rethrows
+        template <typename Task>
+        std::future<void> submit(Task &&task)
+        {
+            auto packaged = std::make_shared<std::packaged_task<void()>>(std::forward<Task>(task));
+            std::future<void> done = packaged->get_future();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tasks.emplace_back([packaged]()
+                                     { (*packaged)(); });
+            }
+            m_wakeUp.notify_one();
+            return done;
+        }
+
+        // Calls fn(begin, end) on contiguous ranges covering [0, count), one range per worker,
+        // and waits for all of them. Must not be called from a task of this pool.
+        template <typename Fn>
+        void parallelFor(size_t count, Fn &&fn)
+        {
+            const size_t ranges = std::min<size_t>(count, m_workers.size());
+            std::vector<std::future<void>> pending;
+            pending.reserve(ranges);
+            for (size_t r = 0; r < ranges; ++r)
+            {
+                const size_t begin = count * r / ranges;
+                const size_t end = count * (r + 1) / ranges;
+                pending.push_back(submit([&fn, begin, end]()
+                                         { fn(begin, end); }));
+            }
+            for (std::future<void> &done : pending)
+            {
+                done.get();
+            }
+        }
+
+    private:
+        std::vector<std::thread> m_workers;
+        std::deque<std::function<void()>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_wakeUp;
+        bool m_stopping = false;
+
+        void workerLoop();
+    };
+
+    // parallelFor on pool, or fn(0, count) on the calling thread when there is no pool
+    template <typename Fn>
+    void parallelFor(ThreadPool *pool, size_t count, Fn &&fn)
+    {
+        if (pool == nullptr || pool->getThreadCount() <= 1 || count <= 1)
+        {
+            fn(size_t{0}, count);
+            return;
+        }
+        pool->parallelFor(count, std::forward<Fn>(fn));
+    }
+}
+
+#endif //THREADPOOL_H
@@ -0,0 +1,481 @@
+//
+// Compile-time dimension R-tree. Mirrors RTree::RTree with the quadratic split,
+// but every node, entry and region is specialised on D and Scalar.
+//
+
+#ifndef FIXEDRTREE_H
+#define FIXEDRTREE_H
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stack>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "FixedRegion.h"
+#include "src/RTree/impl/common.h"
+#include "src/RTree/impl/metric/MetricManager.h"
+
+namespace RTree::fixed
+{
+    template <uint32_t D, typename Scalar = double>
+    class RTree
+    {
+    public:
+        using RegionType = Region<D, Scalar>;
+        using PointType = Point<D, Scalar>;
+
+        struct Entry
+        {
+            RegionType region;
+            id_type id;
+        };
+
+        explicit RTree(uint32_t nodeCapacity) : m_nodeCapacity(nodeCapacity), m_root(new Node(true)) {}
+
+        ~RTree()
+        {
+            destroy(m_root);
+        }
+
+        RTree(const RTree &) = delete;
+        RTree &operator=(const RTree &) = delete;
+
+        void insert(const RegionType &mbr, id_type id)
+        {
+            auto insertStartTime = std::chrono::high_resolution_clock::now();
+
+            insert_impl(m_root, Entry{mbr, id});
+
+            // If the root node splits, grow the tree by one level
+            if (shouldSplit(m_root))
+            {
+                Node *sibling = split(m_root);
+                Node *newRoot = new Node(false);
+                newRoot->children.push_back(m_root);
+                newRoot->children.push_back(sibling);
+                newRoot->mbr = m_root->mbr;
+                newRoot->mbr.combine(sibling->mbr);
+                m_root = newRoot;
+            }
+
+            auto insertEndTime = std::chrono::high_resolution_clock::now();
+            metricManager.record_insertion_time(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                    insertEndTime - insertStartTime)
+                                                    .count());
+        }
+
+        bool remove(const RegionType &mbr, id_type id)
+        {
+            if (!remove_impl(m_root, mbr, id))
+            {
+                return false;
+            }
+
+            // A root with a single child adds a level and nothing else, and a childless internal
+            // root has nowhere to send the next insert: it becomes an empty leaf again
+            while (!m_root->leaf && m_root->children.size() <= 1)
+            {
+                Node *oldRoot = m_root;
+                m_root = oldRoot->children.empty() ? new Node(true) : oldRoot->children[0];
+                oldRoot->children.clear();
+                delete oldRoot;
+            }
+            return true;
+        }
+
+        // Returned entries are owned by the tree and stay valid until the next insert or remove
+        std::vector<const Entry *> intersectionQuery(const RegionType &query)
+        {
+            auto startTime = std::chrono::high_resolution_clock::now();
+            std::vector<const Entry *> result;
+            search(m_root, query, result);
+            auto endTime = std::chrono::high_resolution_clock::now();
+            metricManager.record_range_query_time(!result.empty(),
+                                                  std::chrono::duration_cast<std::chrono::microseconds>(
+                                                      endTime - startTime)
+                                                      .count());
+            return result;
+        }
+
+        std::vector<const Entry *> containmentQuery(const RegionType &query)
+        {
+            std::vector<const Entry *> intersectedResults;
+            search(m_root, query, intersectedResults);
+
+            std::vector<const Entry *> containedResults;
+            for (const Entry *entry : intersectedResults)
+            {
+                if (query.contains(entry->region))
+                {
+                    containedResults.push_back(entry);
+                }
+            }
+            return containedResults;
+        }
+
+        std::vector<const Entry *> pointQuery(const PointType &point)
+        {
+            auto startTime = std::chrono::high_resolution_clock::now();
+            std::vector<const Entry *> intersectedResults;
+            search(m_root, RegionType::fromPoint(point), intersectedResults);
+            auto endTime = std::chrono::high_resolution_clock::now();
+
+            std::vector<const Entry *> pointResults;
+            for (const Entry *entry : intersectedResults)
+            {
+                if (entry->region.contains(point))
+                {
+                    pointResults.push_back(entry);
+                }
+            }
+
+            metricManager.record_point_query_time(!pointResults.empty(),
+                                                  std::chrono::duration_cast<std::chrono::microseconds>(
+                                                      endTime - startTime)
+                                                      .count());
+            return pointResults;
+        }
+
+        static constexpr uint32_t getDimension()
+        {
+            return D;
+        }
+
+        uint32_t getNodeCapacity() const
+        {
+            return m_nodeCapacity;
+        }
+
+        uint32_t getHeight() const
+        {
+            uint32_t height = 1;
+            for (const Node *node = m_root; !node->leaf && !node->children.empty(); node = node->children.front())
+            {
+                ++height;
+            }
+            return height;
+        }
+
+        void construction_finished()
+        {
+            std::vector<double> node_capacity_percent = {};
+            std::vector<double> internal_capacity_percent = {};
+            std::stack<const Node *> s;
+            s.push(m_root);
+
+            while (!s.empty())
+            {
+                const Node *node = s.top();
+                s.pop();
+                if (node->leaf)
+                {
+                    node_capacity_percent.push_back(static_cast<double>(node->entries.size()) /
+                                                    static_cast<double>(m_nodeCapacity));
+                    continue;
+                }
+                if (node != m_root)
+                {
+                    internal_capacity_percent.push_back(static_cast<double>(node->children.size()) /
+                                                        static_cast<double>(m_nodeCapacity));
+                }
+                for (const Node *child : node->children)
+                {
+                    s.push(child);
+                }
+            }
+
+            metricManager.record_post_construction_metrics(getHeight(), node_capacity_percent);
+            metricManager.record_internal_node_metrics(internal_capacity_percent);
+        }
+
+        void print_construction_metrics(std::string name) const
+        {
+            metricManager.print_construction_metrics(name);
+        }
+
+        void print_point_query_metrics(std::string name) const
+        {
+            metricManager.print_point_query_metrics(name);
+        }
+
+        void print_range_query_metrics(std::string name, double window)
+        {
+            metricManager.print_range_query_metrics(name, window);
+        }
+
+    private:
+        struct Node
+        {
+            explicit Node(bool leaf) : leaf(leaf) {}
+
+            bool leaf;
+            RegionType mbr;
+            std::vector<Entry> entries;   // leaf nodes only
+            std::vector<Node *> children; // internal nodes only
+        };
+
+        uint32_t m_nodeCapacity;
+        Node *m_root;
+        MetricManager metricManager;
+
+        static void destroy(Node *node)
+        {
+            for (Node *child : node->children)
+            {
+                destroy(child);
+            }
+            delete node;
+        }
+
+        static const RegionType &regionOf(const Entry &entry)
+        {
+            return entry.region;
+        }
+
+        static const RegionType &regionOf(const Node *child)
+        {
+            return child->mbr;
+        }
+
+        bool shouldSplit(const Node *node) const
+        {
+            return (node->leaf ? node->entries.size() : node->children.size()) > m_nodeCapacity;
+        }
+
+        void insert_impl(Node *node, const Entry &entry)
+        {
+            node->mbr.combine(entry.region);
+
+            if (node->leaf)
+            {
+                node->entries.push_back(entry);
+                return;
+            }
+
+            Node *child = chooseSubtree(node, entry.region);
+            insert_impl(child, entry);
+
+            if (shouldSplit(child))
+            {
+                node->children.push_back(split(child));
+            }
+        }
+
+        static Node *chooseSubtree(const Node *node, const RegionType &mbr)
+        {
+            double minEnlargement = std::numeric_limits<double>::max();
+            double bestArea = std::numeric_limits<double>::max();
+            Node *bestChild = nullptr;
+
+            for (Node *child : node->children)
+            {
+                // Primary criterion: minimum expansion, secondary: smaller area
+                double area = child->mbr.getArea();
+                double enlargement = child->mbr.getCombinedArea(mbr) - area;
+                if (bestChild == nullptr || enlargement < minEnlargement ||
+                    (enlargement == minEnlargement && area < bestArea))
+                {
+                    minEnlargement = enlargement;
+                    bestArea = area;
+                    bestChild = child;
+                }
+            }
+            return bestChild;
+        }
+
+        bool remove_impl(Node *node, const RegionType &mbr, id_type id)
+        {
+            bool found = false;
+
+            if (node->leaf)
+            {
+                for (auto it = node->entries.begin(); it != node->entries.end(); ++it)
+                {
+                    if (it->id == id)
+                    {
+                        node->entries.erase(it);
+                        found = true;
+                        break;
+                    }
+                }
+            }
+            else
+            {
+                for (auto it = node->children.begin(); it != node->children.end(); ++it)
+                {
+                    Node *child = *it;
+                    if (child->mbr.intersects(mbr) && remove_impl(child, mbr, id))
+                    {
+                        found = true;
+                        if (isEmpty(child))
+                        {
+                            destroy(child);
+                            node->children.erase(it);
+                        }
+                        break;
+                    }
+                }
+            }
+
+            if (found)
+            {
+                recalculateMBR(node);
+            }
+            return found;
+        }
+
+        static bool isEmpty(const Node *node)
+        {
+            return node->leaf ? node->entries.empty() : node->children.empty();
+        }
+
+        static void recalculateMBR(Node *node)
+        {
+            node->mbr = RegionType();
+            for (const Entry &entry : node->entries)
+            {
+                node->mbr.combine(entry.region);
+            }
+            for (const Node *child : node->children)
+            {
+                node->mbr.combine(child->mbr);
+            }
+        }
+
+        static void search(const Node *node, const RegionType &query, std::vector<const Entry *> &results)
+        {
+            if (node->leaf)
+            {
+                for (const Entry &entry : node->entries)
+                {
+                    if (entry.region.intersects(query))
+                    {
+                        results.push_back(&entry);
+                    }
+                }
+                return;
+            }
+
+            for (const Node *child : node->children)
+            {
+                if (child->mbr.intersects(query))
+                {
+                    search(child, query, results);
+                }
+            }
+        }
+
+        // Quadratic split of the overflowing node; the second group moves into the returned sibling
+        Node *split(Node *node)
+        {
+            auto startTime = std::chrono::high_resolution_clock::now();
+
+            Node *sibling = new Node(node->leaf);
+            if (node->leaf)
+            {
+                quadraticSplit(node->entries, sibling->entries);
+            }
+            else
+            {
+                quadraticSplit(node->children, sibling->children);
+            }
+            recalculateMBR(node);
+            recalculateMBR(sibling);
+
+            const auto endTime = std::chrono::high_resolution_clock::now();
+            metricManager.record_split_time(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                endTime - startTime)
+                                                .count());
+            return sibling;
+        }
+
+        // Guttman's quadratic split, same seeds and assignment order as QuadraticSplitStrategy
+        template <typename Item>
+        void quadraticSplit(std::vector<Item> &group1, std::vector<Item> &group2) const
+        {
+            std::vector<Item> remaining = std::move(group1);
+            group1.clear();
+
+            // Overlapping regions waste a negative area, any pair must still beat none; the
+            // first pair stands in when none does (NaN areas), so the seeds always differ
+            size_t seed1 = 0;
+            size_t seed2 = 1;
+            double maxWastedArea = -std::numeric_limits<double>::max();
+            for (size_t i = 0; i < remaining.size(); ++i)
+            {
+                for (size_t j = i + 1; j < remaining.size(); ++j)
+                {
+                    const RegionType &region1 = regionOf(remaining[i]);
+                    const RegionType &region2 = regionOf(remaining[j]);
+                    double wastedArea = region1.getCombinedArea(region2) - region1.getArea() - region2.getArea();
+                    if (wastedArea > maxWastedArea)
+                    {
+                        maxWastedArea = wastedArea;
+                        seed1 = i;
+                        seed2 = j;
+                    }
+                }
+            }
+
+            group1.push_back(remaining[seed1]);
+            group2.push_back(remaining[seed2]);
+            RegionType mbr1 = regionOf(remaining[seed1]);
+            RegionType mbr2 = regionOf(remaining[seed2]);
+
+            // seed2 > seed1, so erase it first to keep seed1's index valid
+            remaining.erase(remaining.begin() + seed2);
+            remaining.erase(remaining.begin() + seed1);
+
+            const uint32_t minEntries = m_nodeCapacity / 2;
+
+            while (!remaining.empty())
+            {
+                // If one group has too few entries, assign all remaining to it
+                if (group1.size() + remaining.size() <= minEntries ||
+                    group2.size() + remaining.size() <= minEntries)
+                {
+                    bool toFirst = group1.size() + remaining.size() <= minEntries;
+                    std::vector<Item> &group = toFirst ? group1 : group2;
+                    RegionType &mbr = toFirst ? mbr1 : mbr2;
+                    for (auto &item : remaining)
+                    {
+                        mbr.combine(regionOf(item));
+                        group.push_back(std::move(item));
+                    }
+                    remaining.clear();
+                    break;
+                }
+
+                // Select the entry with the strongest preference for one group
+                double maxDiff = -std::numeric_limits<double>::max();
+                size_t selectedIndex = 0;
+                bool toFirst = true;
+                const double area1 = mbr1.getArea();
+                const double area2 = mbr2.getArea();
+
+                for (size_t i = 0; i < remaining.size(); ++i)
+                {
+                    const RegionType &region = regionOf(remaining[i]);
+                    double growth1 = mbr1.getCombinedArea(region) - area1;
+                    double growth2 = mbr2.getCombinedArea(region) - area2;
+                    double diff = std::abs(growth1 - growth2);
+                    if (diff > maxDiff)
+                    {
+                        maxDiff = diff;
+                        selectedIndex = i;
+                        toFirst = growth1 < growth2;
+                    }
+                }
+
+                (toFirst ? mbr1 : mbr2).combine(regionOf(remaining[selectedIndex]));
+                (toFirst ? group1 : group2).push_back(std::move(remaining[selectedIndex]));
+                remaining.erase(remaining.begin() + selectedIndex);
+            }
+        }
+    };
+}
+
+#endif //FIXEDRTREE_H
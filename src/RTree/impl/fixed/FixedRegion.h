@@ -0,0 +1,175 @@
+//
+// Compile-time dimension counterpart of RTree::Region.
+//
+
+#ifndef FIXEDREGION_H
+#define FIXEDREGION_H
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace RTree::fixed
+{
+    // Coordinates of a point in a D-dimensional space, stored inline
+    template <uint32_t D, typename Scalar = double>
+    using Point = std::array<Scalar, D>;
+
+    // Axis aligned box whose dimension is a template parameter, so every loop below
+    // has a constant trip count and the coordinates live inside the object.
+    // Accessors are unchecked: the dimension is known at compile time.
+    template <uint32_t D, typename Scalar = double>
+    class Region
+    {
+        static_assert(D > 0, "Region dimension must be positive");
+
+    public:
+        using PointType = Point<D, Scalar>;
+
+        // Default constructed regions are "inverted" so combining anything into them yields that thing
+        Region()
+        {
+            m_low.fill(std::numeric_limits<Scalar>::max());
+            m_high.fill(std::numeric_limits<Scalar>::lowest());
+        }
+
+        Region(const PointType &low, const PointType &high) : m_low(low), m_high(high) {}
+
+        Region(const Scalar *low, const Scalar *high)
+        {
+            for (uint32_t i = 0; i < D; ++i)
+            {
+                m_low[i] = low[i];
+                m_high[i] = high[i];
+            }
+        }
+
+        static Region fromPoint(const PointType &point)
+        {
+            return Region(point, point);
+        }
+
+        bool operator==(const Region &other) const
+        {
+            return m_low == other.m_low && m_high == other.m_high;
+        }
+
+        bool intersects(const Region &other) const
+        {
+            for (uint32_t i = 0; i < D; ++i)
+            {
+                if (m_low[i] > other.m_high[i] || m_high[i] < other.m_low[i])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool contains(const Region &other) const
+        {
+            for (uint32_t i = 0; i < D; ++i)
+            {
+                if (m_low[i] > other.m_low[i] || m_high[i] < other.m_high[i])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        bool contains(const PointType &point) const
+        {
+            for (uint32_t i = 0; i < D; ++i)
+            {
+                if (point[i] < m_low[i] || point[i] > m_high[i])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        double getArea() const
+        {
+            double area = 1.0;
+            for (uint32_t i = 0; i < D; ++i)
+            {
+                area *= static_cast<double>(m_high[i] - m_low[i]);
+            }
+            return area;
+        }
+
+        double getMargin() const
+        {
+            double margin = 0.0;
+            for (uint32_t i = 0; i < D; ++i)
+            {
+                margin += static_cast<double>(m_high[i] - m_low[i]);
+            }
+            return margin * 2.0;
+        }
+
+        // Area of the box covering both this region and other, without materialising it
+        double getCombinedArea(const Region &other) const
+        {
+            double area = 1.0;
+            for (uint32_t i = 0; i < D; ++i)
+            {
+                area *= static_cast<double>(std::max(m_high[i], other.m_high[i]) -
+                                            std::min(m_low[i], other.m_low[i]));
+            }
+            return area;
+        }
+
+        double getMinDistance(const PointType &point) const
+        {
+            double dist = 0.0;
+            for (uint32_t i = 0; i < D; ++i)
+            {
+                double d = 0.0;
+                if (point[i] < m_low[i])
+                {
+                    d = static_cast<double>(m_low[i] - point[i]);
+                }
+                else if (point[i] > m_high[i])
+                {
+                    d = static_cast<double>(point[i] - m_high[i]);
+                }
+                dist += d * d;
+            }
+            return std::sqrt(dist);
+        }
+
+        void combine(const Region &other)
+        {
+            for (uint32_t i = 0; i < D; ++i)
+            {
+                m_low[i] = std::min(m_low[i], other.m_low[i]);
+                m_high[i] = std::max(m_high[i], other.m_high[i]);
+            }
+        }
+
+        Scalar getLow(uint32_t index) const
+        {
+            return m_low[index];
+        }
+
+        Scalar getHigh(uint32_t index) const
+        {
+            return m_high[index];
+        }
+
+        static constexpr uint32_t getDimension()
+        {
+            return D;
+        }
+
+    private:
+        PointType m_low;
+        PointType m_high;
+    };
+}
+
+#endif //FIXEDREGION_H
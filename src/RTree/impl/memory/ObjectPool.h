@@ -0,0 +1,165 @@
+//
+// Slab allocator handing out fixed-size slots from contiguous chunks.
+//
+
+#ifndef OBJECTPOOL_H
+#define OBJECTPOOL_H
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace RTree
+{
+    // Objects are placement-constructed into slots of large chunks, freed slots go on an
+    // intrusive free list and are reused by the next create(). Object addresses are stable
+    // for the lifetime of the object. Destroying the pool frees every chunk at once; the
+    // destructors of objects still alive are run by a linear sweep over the chunks unless
+    // trivial teardown was requested.
+    template <typename T>
+    class ObjectPool
+    {
+    public:
+        explicit ObjectPool(size_t slotsPerChunk = 1024) : m_slotsPerChunk(slotsPerChunk) {}
+
+        ~ObjectPool()
+        {
+            clear();
+        }
+
+        ObjectPool(const ObjectPool &) = delete;
+        ObjectPool &operator=(const ObjectPool &) = delete;
+
+        template <typename... Args>
+        T *create(Args &&...args)
+        {
+            if (m_freeList == nullptr)
+            {
+                grow();
+            }
+
+            Slot *slot = m_freeList;
+            m_freeList = slot->next;
+            T *object = new (slot->storage) T(std::forward<Args>(args)...);
+            slot->live = true;
+            ++m_liveCount;
+            return object;
+        }
+
+        // Take count slots without constructing anything in them, for callers that construct the
+        // objects themselves, possibly on several threads. Every slot must be placement-constructed
+        // before it is destroyed or the pool is cleared.
+        void allocate(size_t count, T **slots)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (m_freeList == nullptr)
+                {
+                    grow();
+                }
+
+                Slot *slot = m_freeList;
+                m_freeList = slot->next;
+                slot->live = true;
+                slots[i] = reinterpret_cast<T *>(slot->storage);
+            }
+            m_liveCount += count;
+        }
+
+        void destroy(T *object)
+        {
+            if (object == nullptr)
+            {
+                return;
+            }
+
+            object->~T();
+            Slot *slot = reinterpret_cast<Slot *>(object);
+            slot->live = false;
+            slot->next = m_freeList;
+            m_freeList = slot;
+            --m_liveCount;
+        }
+
+        // Destroy every live object and give all chunks back to the system
+        void clear()
+        {
+            if constexpr (!std::is_trivially_destructible_v<T>)
+            {
+                if (!m_trivialTeardown)
+                {
+                    for (Slot *chunk : m_chunks)
+                    {
+                        for (size_t i = 0; i < m_slotsPerChunk; ++i)
+                        {
+                            if (chunk[i].live)
+                            {
+                                reinterpret_cast<T *>(chunk[i].storage)->~T();
+                            }
+                        }
+                    }
+                }
+            }
+
+            for (Slot *chunk : m_chunks)
+            {
+                ::operator delete(chunk);
+            }
+            m_chunks.clear();
+            m_freeList = nullptr;
+            m_liveCount = 0;
+        }
+
+        // Skip destructors of live objects on clear(). Only valid when T's destructor
+        // releases nothing, e.g. Data whose Region fits the inline coordinate buffer.
+        void setTrivialTeardown(bool trivialTeardown)
+        {
+            m_trivialTeardown = trivialTeardown;
+        }
+
+        size_t liveCount() const
+        {
+            return m_liveCount;
+        }
+
+        size_t chunkCount() const
+        {
+            return m_chunks.size();
+        }
+
+    private:
+        struct Slot
+        {
+            // storage must stay the first member so a T* converts back to its Slot*
+            union
+            {
+                alignas(T) unsigned char storage[sizeof(T)];
+                Slot *next;
+            };
+            bool live;
+        };
+
+        size_t m_slotsPerChunk;
+        std::vector<Slot *> m_chunks;
+        Slot *m_freeList = nullptr;
+        size_t m_liveCount = 0;
+        bool m_trivialTeardown = false;
+
+        void grow()
+        {
+            auto *chunk = static_cast<Slot *>(::operator new(m_slotsPerChunk * sizeof(Slot)));
+            m_chunks.push_back(chunk);
+
+            // Thread the new slots onto the free list in address order
+            for (size_t i = 0; i < m_slotsPerChunk; ++i)
+            {
+                chunk[i].live = false;
+                chunk[i].next = (i + 1 < m_slotsPerChunk) ? &chunk[i + 1] : m_freeList;
+            }
+            m_freeList = chunk;
+        }
+    };
+}
+
+#endif //OBJECTPOOL_H
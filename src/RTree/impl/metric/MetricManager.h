@@ -4,8 +4,16 @@
 
 #ifndef METRICMANAGER_H
 #define METRICMANAGER_H
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <numeric>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 // insertion order test. vs z-order
@@ -37,12 +45,15 @@
 
 class MetricManager {
     // construction
-    long split_op_count = 0;
-    long long total_split_time = 0;
-    long long max_split_time = 0;
+    // Atomic so that ConcurrentRTree writers can record splits and inserts from many threads
+    std::atomic<long> split_op_count{0};
+    std::atomic<long long> total_split_time{0};
+    std::atomic<long long> max_split_time{0};
 
-    long long total_insert_time = 0;
-    long long max_insert_time = 0;
+    std::atomic<long long> total_insert_time{0};
+    std::atomic<long long> max_insert_time{0};
+
+    long long bulk_load_time = 0;
 
     // post construction
     long tree_height = 0;
@@ -51,14 +62,75 @@ class MetricManager {
     double min_leaf_node_capacity_percent = 0;
     double mean_leaf_node_capacity = 0;
     double median_leaf_node_capacity = 0;
+    long total_internal_nodes = 0;
+    double mean_internal_node_capacity = 0;
+    // Frozen node box encodings: exact, 16-bit and 8-bit quantized, see BoxEncoding
+    double mean_internal_node_bytes[3] = {0, 0, 0};
+    double quantization_false_positive_rate[3] = {0, 0, 0};
 
     // query cost
     // total, min, max,mean, median
-    std::vector<long long> positive_point_query_time = {};
-    std::vector<long long> negative_point_query_time = {};
+    // Queries may run on many threads at once, so every thread records into its own set of
+    // vectors; the print methods merge them and must not run concurrently with queries.
+    struct QueryTimes {
+        std::thread::id owner;
+        std::vector<long long> positive_point_query_time = {};
+        std::vector<long long> negative_point_query_time = {};
+
+        std::vector<long long> positive_range_query_time = {};
+        std::vector<long long> negative_range_query_time = {};
+
+        std::vector<long long> knn_query_time = {};
+    };
+
+    // Guards query_times itself; a thread only ever touches the contents of its own entry
+    std::mutex query_times_mutex;
+    std::vector<std::unique_ptr<QueryTimes>> query_times = {};
+    // Keys this manager in the per-thread cache below, even after its address is reused
+    const uint64_t instance_id = next_instance_id();
+
+    static uint64_t next_instance_id() {
+        static std::atomic<uint64_t> counter{0};
+        return ++counter;
+    }
+
+    QueryTimes &local_query_times() {
+        // Every manager this thread has recorded into, so that alternating between trees stays
+        // off the mutex. Ids are never reused: entries of destroyed managers are never looked up.
+        thread_local std::unordered_map<uint64_t, QueryTimes *> cache;
+        auto cached = cache.find(instance_id);
+        if (cached != cache.end()) {
+            return *cached->second;
+        }
+
+        std::lock_guard<std::mutex> lock(query_times_mutex);
+        const std::thread::id self = std::this_thread::get_id();
+        auto it = std::find_if(query_times.begin(), query_times.end(),
+                               [self](const std::unique_ptr<QueryTimes> &times) { return times->owner == self; });
+        if (it == query_times.end()) {
+            query_times.push_back(std::make_unique<QueryTimes>());
+            query_times.back()->owner = self;
+            it = query_times.end() - 1;
+        }
+        cache.emplace(instance_id, it->get());
+        return **it;
+    }
 
-    std::vector<long long> positive_range_query_time = {};
-    std::vector<long long> negative_range_query_time = {};
+    // All threads' times of one kind, e.g. merged(&QueryTimes::knn_query_time)
+    std::vector<long long> merged(std::vector<long long> QueryTimes::*times) const {
+        std::vector<long long> all;
+        for (const auto &thread_times : query_times) {
+            const std::vector<long long> &v = (*thread_times).*times;
+            all.insert(all.end(), v.begin(), v.end());
+        }
+        return all;
+    }
+
+    static void raise_to(std::atomic<long long>& maximum, const long long value) {
+        long long current = maximum.load(std::memory_order_relaxed);
+        while (current < value && !maximum.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+        }
+    }
 
     static double mean(const std::vector<double>& v) {
         if (v.empty()) return 0.0;
@@ -143,19 +215,21 @@ public:
     MetricManager() = default;
     ~MetricManager() = default;
 
+    MetricManager(const MetricManager &) = delete;
+    MetricManager &operator=(const MetricManager &) = delete;
+
     void increment_split_count();
     void record_insertion_time(const long long time) {
         total_insert_time += time;
-        if(max_insert_time < time) {
-            max_insert_time = time;
-        }
+        raise_to(max_insert_time, time);
+    }
+    void record_bulk_load_time(const long long time) {
+        bulk_load_time += time;
     }
     void record_split_time(const long long time) {
         split_op_count++;
         total_split_time += time;
-        if(max_split_time < time) {
-            max_split_time = time;
-        }
+        raise_to(max_split_time, time);
     }
 
     void record_post_construction_metrics(long height, std::vector<double>& capacity_percent) {
@@ -167,6 +241,19 @@ public:
         this->median_leaf_node_capacity = median(capacity_percent);
     }
 
+    void record_internal_node_metrics(std::vector<double>& capacity_percent) {
+        this->total_internal_nodes = capacity_percent.size();
+        this->mean_internal_node_capacity = mean(capacity_percent);
+    }
+
+    // Per encoding, the bytes of every internal node and the rate of child boxes that let a point
+    // through only because they are quantized
+    void record_node_encoding_metrics(size_t encoding, std::vector<double>& node_bytes,
+                                      double false_positive_rate) {
+        this->mean_internal_node_bytes[encoding] = mean(node_bytes);
+        this->quantization_false_positive_rate[encoding] = false_positive_rate;
+    }
+
     void print_construction_metrics(std::string name) const {
         std::cout<< " Total split count - "<< name << ": " << split_op_count << std::endl;
         std::cout<< " Total split time - "<< name << ": " << total_split_time << std::endl;
@@ -174,39 +261,58 @@ public:
         std::cout<< " Max split time - "<< name << ": " << max_split_time << std::endl;
         std::cout<< " Total insert time - "<< name << ": " << total_insert_time << std::endl;
         std::cout<< " Max insert time - "<< name << ": " << max_insert_time << std::endl;
+        std::cout<< " Bulk load time - "<< name << ": " << bulk_load_time << std::endl;
         std::cout<< " Tree height - "<< name << ": " << tree_height << std::endl;
         std::cout<< " Total leaf nodes - "<< name << ": " << total_leaf_nodes << std::endl;
         // std::cout<< " Max leaf node capacity percent - "<< name << ": " << max_leaf_node_capacity_percent << std::endl;
         // std::cout<< " Min leaf node capacity percent - "<< name << ": " << min_leaf_node_capacity_percent << std::endl;
         std::cout<< " Mean leaf node capacity percent - "<< name << ": " << mean_leaf_node_capacity << std::endl;
         std::cout<< " Median leaf node capacity percent - "<< name << ": " << median_leaf_node_capacity << std::endl;
+        std::cout<< " Total internal nodes - "<< name << ": " << total_internal_nodes << std::endl;
+        std::cout<< " Mean internal node capacity percent - "<< name << ": " << mean_internal_node_capacity << std::endl;
+        std::cout<< " Mean internal node bytes exact - "<< name << ": " << mean_internal_node_bytes[0] << std::endl;
+        std::cout<< " Mean internal node bytes 16-bit - "<< name << ": " << mean_internal_node_bytes[1] << std::endl;
+        std::cout<< " Mean internal node bytes 8-bit - "<< name << ": " << mean_internal_node_bytes[2] << std::endl;
+        std::cout<< " False positive rate 16-bit - "<< name << ": " << quantization_false_positive_rate[1] << std::endl;
+        std::cout<< " False positive rate 8-bit - "<< name << ": " << quantization_false_positive_rate[2] << std::endl;
     }
 
+    // The query recorders are safe to call from any number of threads at once
     void record_point_query_time(bool positive, const long long time) {
+        QueryTimes &times = local_query_times();
         if(positive) {
-            positive_point_query_time.push_back(time);
+            times.positive_point_query_time.push_back(time);
         } else {
-            negative_point_query_time.push_back(time);
+            times.negative_point_query_time.push_back(time);
         }
     }
 
     void record_range_query_time(bool positive, const long long time) {
+        QueryTimes &times = local_query_times();
         if(positive) {
-            positive_range_query_time.push_back(time);
+            times.positive_range_query_time.push_back(time);
         } else {
-            negative_range_query_time.push_back(time);
+            times.negative_range_query_time.push_back(time);
         }
     }
 
+    void record_knn_query_time(const long long time) {
+        local_query_times().knn_query_time.push_back(time);
+    }
+
     void reset_query_metrics() {
-        positive_point_query_time.clear();
-        negative_point_query_time.clear();
-        positive_range_query_time.clear();
-        negative_range_query_time.clear();
+        for (auto &times : query_times) {
+            times->positive_point_query_time.clear();
+            times->negative_point_query_time.clear();
+            times->positive_range_query_time.clear();
+            times->negative_range_query_time.clear();
+            times->knn_query_time.clear();
+        }
     }
 
     void print_point_query_metrics(std::string name) const {
         // total, min, max, mean, median
+        const std::vector<long long> positive_point_query_time = merged(&QueryTimes::positive_point_query_time);
         std::cout << " Total point query time - " << name << ": " <<  total(positive_point_query_time) << std::endl;
         std::cout << " mean point query time - " << name << ": " << total(positive_point_query_time) / positive_point_query_time.size() << std::endl;
         std::cout << " median point query time - " << name << ": "<< median(positive_point_query_time) << std::endl;
@@ -216,6 +322,7 @@ public:
 
     void print_range_query_metrics(std::string name, double window) {
         // total, min, max, mean, median
+        const std::vector<long long> positive_range_query_time = merged(&QueryTimes::positive_range_query_time);
         std::cout << " Total range query time -" << name << window << ": "<< total(positive_range_query_time) << std::endl;
         std::cout << " mean range query time -" << name << window << ": "<< total(positive_range_query_time) / positive_range_query_time.size() << std::endl;
         std::cout << " median range query time -" << name << window << ": "<< median(positive_range_query_time) << std::endl;
@@ -223,6 +330,19 @@ public:
         std::cout << " max range query time -" << name << window << ": "<< max(positive_range_query_time) << std::endl;
         reset_query_metrics();
     }
+
+    void print_knn_query_metrics(std::string name, unsigned k) {
+        // total, min, max, mean, median
+        const std::vector<long long> knn_query_time = merged(&QueryTimes::knn_query_time);
+        std::cout << " Total knn query time -" << name << k << ": "<< total(knn_query_time) << std::endl;
+        std::cout << " mean knn query time -" << name << k << ": "<< total(knn_query_time) / std::max<size_t>(knn_query_time.size(), 1) << std::endl;
+        std::cout << " median knn query time -" << name << k << ": "<< median(knn_query_time) << std::endl;
+        std::cout << " min knn query time -" << name << k << ": "<< min(knn_query_time) << std::endl;
+        std::cout << " max knn query time -" << name << k << ": "<< max(knn_query_time) << std::endl;
+        for (auto &times : query_times) {
+            times->knn_query_time.clear();
+        }
+    }
 };
 
 
@@ -1,31 +1,29 @@
 #include "InternalNode.h"
 #include <algorithm>
+#include <chrono>
 #include <limits>
 
 #include "LeafNode.h"
 #include "src/RTree/impl/Data.h"
 #include "src/RTree/impl/strategy/SplitStrategy.h"
+#include "src/RTree/impl/tree/RTree.h"
 
 namespace RTree
 {
     class LeafNode;
     class SplitStrategy;
 
-    InternalNode::InternalNode(uint32_t capacity,
+    InternalNode::InternalNode(uint32_t dimension,
+        uint32_t capacity,
         const SplitStrategy *splitStrategy,
         MetricManager* metric_manager)
-        : Node(splitStrategy, metric_manager), m_capacity(capacity), m_mbr(0)
+        : Node(splitStrategy, metric_manager), m_capacity(capacity), m_childMBRs(dimension, capacity + 1), m_mbr(0)
     {
         // Initialize MBR as invalid region
     }
 
-    InternalNode::~InternalNode()
-    {
-        for (Node *child : m_children)
-        {
-            delete child;
-        }
-    }
+    // Children are owned by the tree's node pools, not by their parent
+    InternalNode::~InternalNode() = default;
 
     bool InternalNode::isLeaf() const
     {
@@ -44,60 +42,31 @@ namespace RTree
 
         // Insert data
         child->insert(data);
-        total_entries++;
+
+        // R* reinsertion below the child may have moved it to a sibling, in which case
+        // that sibling's parent already holds its MBR and decides about splitting it
+        auto it = std::find(m_children.begin(), m_children.end(), child);
+        if (it == m_children.end())
+        {
+            // Reinsertion only ever shrinks what is left here, so the MBR must be rescanned
+            recalculateMBR();
+            return;
+        }
+        const size_t index = it - m_children.begin();
 
         // Check if splitting is needed
         if (child->shouldSplit())
         {
             auto [original, newChild] = child->split();
+            updateChild(index);
             if (newChild)
             {
                 addChild(newChild);
             }
+            return;
         }
 
-        // Update MBR
-        recalculateMBR();
-    }
-
-    bool InternalNode::remove(id_type id, const Region &mbr)
-    {
-        // Find all child nodes that might contain this data
-        bool found = false;
-        for (Node *child : m_children)
-        {
-            if (child->getMBR().intersects(mbr))
-            {
-                if (child->remove(id, mbr))
-                {
-                    found = true;
-                    total_entries--;
-                    break; // Found and removed, no need to continue searching
-                }
-            }
-        }
-
-        if (found)
-        {
-            // Data removed, need to update MBR
-            recalculateMBR();
-
-            // Check if there are empty child nodes that can be deleted
-            auto it = std::remove_if(m_children.begin(), m_children.end(),
-                                     [](Node *child)
-                                     {
-                                         if (child->isEmpty())
-                                         {
-                                             delete child;
-                                             return true;
-                                         }
-                                         return false;
-                                     });
-
-            m_children.erase(it, m_children.end());
-        }
-
-        return found;
+        updateChild(index);
     }
 
     bool InternalNode::isEmpty()
@@ -113,21 +82,49 @@ namespace RTree
         return m_children.size();
     }
 
-    std::vector<Data *> InternalNode::search(const Region &query)
+    void InternalNode::search(const Region &query, Visitor &visitor)
     {
-        std::vector<Data *> results;
+        // Filter on the contiguous child MBR columns, only qualifying children are touched
+        m_childMBRs.forEachIntersecting(query, [&](size_t i)
+                                        { m_children[i]->search(query, visitor); });
+    }
+
+    void InternalNode::searchBatch(const Region *queries, const uint32_t *active, size_t count,
+                                   std::vector<std::vector<Data *>> &results)
+    {
+        // Find which children every active query reaches
+        std::vector<std::pair<uint32_t, uint32_t>> hits; // (child, query)
+        for (size_t j = 0; j < count; ++j)
+        {
+            m_childMBRs.forEachIntersecting(queries[active[j]], [&](size_t i)
+                                            { hits.emplace_back(static_cast<uint32_t>(i), active[j]); });
+        }
 
-        // Search all child nodes intersecting with the query region
-        for (Node *child : m_children)
+        // Group the hits by child, keeping the query order, and descend once per child
+        std::vector<size_t> offsets(m_children.size() + 1, 0);
+        for (const auto &hit : hits)
+        {
+            ++offsets[hit.first + 1];
+        }
+        for (size_t i = 0; i < m_children.size(); ++i)
+        {
+            offsets[i + 1] += offsets[i];
+        }
+        std::vector<uint32_t> partition(hits.size());
+        std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+        for (const auto &hit : hits)
         {
-            if (child->getMBR().intersects(query))
+            partition[next[hit.first]++] = hit.second;
+        }
+
+        for (size_t i = 0; i < m_children.size(); ++i)
+        {
+            if (offsets[i + 1] > offsets[i])
             {
-                std::vector<Data *> childResults = child->search(query);
-                results.insert(results.end(), childResults.begin(), childResults.end());
+                m_children[i]->searchBatch(queries, partition.data() + offsets[i], offsets[i + 1] - offsets[i],
+                                           results);
             }
         }
-
-        return results;
     }
 
     bool InternalNode::shouldSplit() const
@@ -136,6 +133,10 @@ namespace RTree
     }
 
     std::pair<Node *, Node *> InternalNode::split() {
+        return splitChildren(true);
+    }
+
+    std::pair<Node *, Node *> InternalNode::splitChildren(bool reparent) {
         auto startTime = std::chrono::high_resolution_clock::now();
 
         if (m_children.size() <= 2) {
@@ -146,28 +147,33 @@ namespace RTree
         auto [group1, group2] = m_splitStrategy->splitInternalChildren(m_children, m_capacity);
 
         // Create new node
-        auto *newNode = new InternalNode(m_capacity, m_splitStrategy, metric_manager);
-
-        // TODO: Might remove this, since no reinsert function on internal node
-        if (m_tree != nullptr)
-        {
-            newNode->setTree(m_tree);
-        }
+        InternalNode *newNode = m_tree->createInternalNode();
 
         // Clear current node's children (but don't delete them, as they will be reassigned)
         std::vector<Node *> originalChildren = std::move(m_children);
         m_children.clear();
+        m_childMBRs.clear();
 
         // Add first group of children to current node
         for (auto *child : group1)
         {
             m_children.push_back(child);
+            m_childMBRs.push_back(child->getMBR());
         }
 
-        // Add second group of children to new node
+        // Add second group of children to new node, its MBR is built once below
         for (auto *child : group2)
         {
-            newNode->addChild(child);
+            if (child->getTree() != m_tree)
+            {
+                child->setTree(m_tree);
+            }
+            if (reparent)
+            {
+                child->setParent(newNode);
+            }
+            newNode->m_children.push_back(child);
+            newNode->m_childMBRs.push_back(child->getMBR());
         }
 
         // Recalculate MBR
@@ -186,78 +192,82 @@ namespace RTree
 
     void InternalNode::addChild(Node *child)
     {
-        // Propagate the tree pointer to the child node
-        if (m_tree != nullptr && child != nullptr)
+        // Propagate the tree pointer to the child node. Only written when it differs: a writer of
+        // a ConcurrentRTree may be reading it below the child while this node splits.
+        if (m_tree != nullptr && child != nullptr && child->getTree() != m_tree)
         {
             child->setTree(m_tree);
         }
 
+        child->setParent(this);
         m_children.push_back(child);
-        recalculateMBR();
+        m_childMBRs.push_back(child->getMBR());
+        expandMBR(child->getMBR());
     }
 
-    void InternalNode::recalculateMBR()
+    bool InternalNode::refreshChild(const Node *child)
     {
-        if (m_children.empty())
+        auto it = std::find(m_children.begin(), m_children.end(), child);
+        if (it == m_children.end())
         {
-            m_mbr = Region(0); // Create empty region
-            return;
+            return false;
         }
 
-        // Use the MBR of the first child as initial value
-        m_mbr = m_children[0]->getMBR();
+        m_childMBRs.set(it - m_children.begin(), child->getMBR());
+        return true;
+    }
 
-        // Combine MBRs of all other children
-        for (size_t i = 1; i < m_children.size(); ++i)
+    void InternalNode::updateChild(size_t index)
+    {
+        const bool wasOnBoundary = m_childMBRs.touchesBoundary(index, m_mbr);
+        m_childMBRs.set(index, m_children[index]->getMBR());
+        if (wasOnBoundary)
         {
-            Region mbr = m_children[i]->getMBR();
-            m_mbr.combine(mbr);
+            recalculateMBR();
+        }
+        else
+        {
+            expandMBR(m_children[index]->getMBR());
         }
     }
 
-    Node *InternalNode::chooseSubtree(const Region &mbr) const
+    void InternalNode::removeChild(size_t index)
     {
-        if (m_children.empty())
+        const bool wasOnBoundary = m_childMBRs.touchesBoundary(index, m_mbr);
+        m_children.erase(m_children.begin() + index);
+        m_childMBRs.erase(index);
+        if (wasOnBoundary)
         {
-            return nullptr;
+            recalculateMBR();
         }
+    }
 
-        // Use unified selection criteria for all children
-        double minEnlargement = std::numeric_limits<double>::max();
-        Node *bestChild = nullptr;
+    void InternalNode::recalculateMBR()
+    {
+        m_mbr = m_childMBRs.bounds();
+    }
 
-        for (Node *child : m_children)
+    void InternalNode::expandMBR(const Region &region)
+    {
+        if (m_mbr.getDimension() == 0)
         {
-            // Calculate area increase after combining regions
-            Region combined = child->getMBR();
-            double originalArea = combined.getArea();
-            combined.combine(mbr);
-            double enlargement = combined.getArea() - originalArea;
-
-            // Primary criterion: minimum expansion
-            if (bestChild == nullptr || enlargement < minEnlargement)
-            {
-                minEnlargement = enlargement;
-                bestChild = child;
-            }
-            // Secondary criterion: if expansion is the same, choose the smaller area
-            else if (enlargement == minEnlargement)
-            {
-                if (child->getMBR().getArea() < bestChild->getMBR().getArea())
-                {
-                    bestChild = child;
-                }
-            }
+            m_mbr = region;
+            return;
         }
+        m_mbr.combine(region);
+    }
 
-        // If the best child is an internal node, recurse into it
-        if (!bestChild->isLeaf())
+    Node *InternalNode::chooseSubtree(const Region &mbr) const
+    {
+        if (m_children.empty())
         {
-            return static_cast<InternalNode *>(bestChild)->chooseSubtree(mbr);
+            return nullptr;
         }
 
-        // Otherwise return the leaf node found
-        return bestChild;
+        // Least enlargement, then smallest area, evaluated on the child MBR columns.
+        // Only the immediate child is chosen: the descent continues through its own insert,
+        // so every node on the path updates its MBR and handles its children's splits.
+        return m_children[m_childMBRs.chooseLeastEnlargement(mbr)];
     }
 
     uint32_t InternalNode::getHeight() const
@@ -7,6 +7,7 @@
 #include <cstdint>
 #include <vector>
 
+#include "MBRColumns.h"
 #include "Node.h"
 #include "src/RTree/impl/common.h"
 #include "src/RTree/impl/Region.h"
@@ -19,7 +20,8 @@ namespace RTree
     class InternalNode : public Node
     {
     public:
-        InternalNode(uint32_t capacity,
+        InternalNode(uint32_t dimension,
+            uint32_t capacity,
             const SplitStrategy *splitStrategy,
             MetricManager* metricManager);
         ~InternalNode() override;
@@ -27,11 +29,12 @@ namespace RTree
         bool isLeaf() const override;
         const Region &getMBR() const override;
         void insert(Data *data) override;
-        bool remove(id_type id, const Region &mbr) override;
         bool isEmpty() override;
         std::vector<Node *> children() override;
         unsigned long size() override;
-        std::vector<Data *> search(const Region &query) override;
+        void search(const Region &query, Visitor &visitor) override;
+        void searchBatch(const Region *queries, const uint32_t *active, size_t count,
+                         std::vector<std::vector<Data *>> &results) override;
         bool shouldSplit() const override;
         std::pair<Node *, Node *> split() override;
         uint32_t getHeight() const override;
@@ -41,13 +44,31 @@ namespace RTree
     private:
         uint32_t m_capacity;
         std::vector<Node *> m_children;
+        // m_childMBRs[i] mirrors m_children[i]->getMBR()
+        MBRColumns m_childMBRs;
         Region m_mbr;
-        uint32_t total_entries = 0; // Track total entries in subtree
 
+        // split() itself; without reparent the moved children keep their parent pointers, as
+        // a copy-on-write writer needs for children still shared with published versions
+        std::pair<Node *, Node *> splitChildren(bool reparent);
         void recalculateMBR();
+        // Grows m_mbr to cover region, never shrinks it
+        void expandMBR(const Region &region);
         Node *chooseSubtree(const Region &mbr) const;
+        // Re-reads child's MBR into its column; false if child is no longer one of ours
+        bool refreshChild(const Node *child);
+        // Re-reads child index's MBR and brings m_mbr up to date, rescanning the columns only
+        // when the old MBR was on its boundary
+        void updateChild(size_t index);
+        // Erases child index, rescanning the MBR only when the child was on its boundary
+        void removeChild(size_t index);
 
         friend class RTree;
+        friend class NearestNeighborCursor;
+        friend class ConcurrentRTree;
+        friend class SnapshotRTree;
+        friend class SpatialJoin;
+        friend class FrozenRTree;
     };
 
 }
@@ -1,26 +1,25 @@
 #include "LeafNode.h"
 
 #include <algorithm>
+#include <chrono>
 #include <iostream>
+#include <tuple>
 #include "src/RTree/impl/Data.h"
+#include "src/RTree/impl/Visitor.h"
 #include "src/RTree/impl/strategy/SplitStrategy.h"
 #include "src/RTree/impl/tree/RTree.h"
 
 namespace RTree
 {
 
-    LeafNode::LeafNode(uint32_t capacity, const SplitStrategy *splitStrategy, MetricManager* metric_manager)
-        : Node(splitStrategy, metric_manager), m_capacity(capacity), m_mbr(0) {
+    LeafNode::LeafNode(uint32_t dimension, uint32_t capacity, const SplitStrategy *splitStrategy,
+        MetricManager* metric_manager)
+        : Node(splitStrategy, metric_manager), m_capacity(capacity), m_entryMBRs(dimension, capacity + 1), m_mbr(0) {
         // Initialize MBR as an invalid region with dimension
     }
 
-    LeafNode::~LeafNode()
-    {
-        for (Data *data : m_entries)
-        {
-            delete data;
-        }
-    }
+    // Entries are owned by the tree's data pool, not by their leaf
+    LeafNode::~LeafNode() = default;
 
     bool LeafNode::isLeaf() const
     {
@@ -35,8 +34,9 @@ namespace RTree
     void LeafNode::insert(Data *data)
     {
         // Add data to this leaf
-        m_entries.push_back(data);
-        recalculateMBR();
+        appendEntry(data);
+        m_tree->indexEntry(data->getIdentifier(), this);
+        expandMBR(data->getRegion());
 
         // Check if this node needs to split
         if (shouldSplit())
@@ -51,23 +51,6 @@ namespace RTree
         }
     }
 
-    bool LeafNode::remove(id_type id, const Region &mbr)
-    {
-        auto it = std::find_if(m_entries.begin(), m_entries.end(),
-                               [id](const Data *data)
-                               { return data->getIdentifier() == id; });
-
-        if (it != m_entries.end())
-        {
-            delete *it;
-            m_entries.erase(it);
-            recalculateMBR();
-            return true;
-        }
-
-        return false;
-    }
-
     bool LeafNode::isEmpty()
     {
         return m_entries.empty();
@@ -82,19 +65,21 @@ namespace RTree
     }
 
 
-    std::vector<Data *> LeafNode::search(const Region &query)
+    void LeafNode::search(const Region &query, Visitor &visitor)
     {
-        std::vector<Data *> results;
+        m_entryMBRs.forEachIntersecting(query, [&](size_t i)
+                                        { visitor.visitData(m_entries[i]); });
+    }
 
-        for (Data *data : m_entries)
+    void LeafNode::searchBatch(const Region *queries, const uint32_t *active, size_t count,
+                               std::vector<std::vector<Data *>> &results)
+    {
+        for (size_t j = 0; j < count; ++j)
         {
-            if (data->getRegion().intersects(query))
-            {
-                results.push_back(data);
-            }
+            std::vector<Data *> &queryResults = results[active[j]];
+            m_entryMBRs.forEachIntersecting(queries[active[j]], [&](size_t i)
+                                            { queryResults.push_back(m_entries[i]); });
         }
-
-        return results;
     }
 
     bool LeafNode::shouldSplit() const
@@ -115,16 +100,19 @@ namespace RTree
         std::vector<Data *> group1;
         std::vector<Data *> group2;
         std::tie(group1, group2) = m_splitStrategy->splitLeafEntries(m_entries, m_capacity);
-        LeafNode *newNode = new LeafNode(m_capacity, m_splitStrategy, metric_manager);
+        LeafNode *newNode = m_tree->createLeafNode();
 
-        m_entries.clear();
+        clearEntries();
         for (auto *entry : group1)
         {
-            m_entries.push_back(entry);
+            appendEntry(entry);
         }
+        // Moved entries go straight into the new node: its MBR is built once below and it
+        // must not overflow or reinsert on the way
         for (auto *entry : group2)
         {
-            newNode->insert(entry);
+            newNode->appendEntry(entry);
+            m_tree->indexEntry(entry->getIdentifier(), newNode);
         }
         recalculateMBR();
         newNode->recalculateMBR();
@@ -140,20 +128,17 @@ namespace RTree
 
     void LeafNode::recalculateMBR()
     {
-        if (m_entries.empty())
-        {
-            m_mbr = Region(0); // Create empty region
-            return;
-        }
-
-        // Use the region of the first data as initial value
-        m_mbr = m_entries[0]->getRegion();
+        m_mbr = m_entryMBRs.bounds();
+    }
 
-        // Combine regions of all other data
-        for (size_t i = 1; i < m_entries.size(); ++i)
+    void LeafNode::expandMBR(const Region &region)
+    {
+        if (m_mbr.getDimension() == 0)
         {
-            m_mbr.combine(m_entries[i]->getRegion());
+            m_mbr = region;
+            return;
         }
+        m_mbr.combine(region);
     }
 
     uint32_t LeafNode::getHeight() const
@@ -166,32 +151,21 @@ namespace RTree
         const double REINSERT_PERCENTAGE = reinsertFactor; // Typically 30% of entries
         size_t numToReinsert = std::max(size_t(1), size_t(m_entries.size() * REINSERT_PERCENTAGE));
 
-        // Calculate center of the node's MBR
-        Region nodeMBR = this->getMBR();
-        std::vector<double> nodeCenter(nodeMBR.getDimension());
-
-        for (uint32_t d = 0; d < nodeMBR.getDimension(); ++d)
-        {
-            nodeCenter[d] = (nodeMBR.getLow(d) + nodeMBR.getHigh(d)) / 2.0;
-        }
-
-        // Calculate distances from center for each entry
+        // Calculate distances from the center of the node's MBR for each entry
+        const Region &nodeMBR = this->getMBR();
         std::vector<std::pair<size_t, double>> distances;
+        distances.reserve(m_entries.size());
         for (size_t i = 0; i < m_entries.size(); ++i)
         {
-            Region entryMBR = m_entries[i]->getRegion();
-            std::vector<double> entryCenter(entryMBR.getDimension());
-
-            for (uint32_t d = 0; d < entryMBR.getDimension(); ++d)
-            {
-                entryCenter[d] = (entryMBR.getLow(d) + entryMBR.getHigh(d)) / 2.0;
-            }
+            const Region &entryMBR = m_entries[i]->getRegion();
 
             // Calculate squared distance from node center
             double dist = 0.0;
             for (uint32_t d = 0; d < entryMBR.getDimension(); ++d)
             {
-                double diff = entryCenter[d] - nodeCenter[d];
+                double nodeCenter = (nodeMBR.getLow(d) + nodeMBR.getHigh(d)) / 2.0;
+                double entryCenter = (entryMBR.getLow(d) + entryMBR.getHigh(d)) / 2.0;
+                double diff = entryCenter - nodeCenter;
                 dist += diff * diff;
             }
 
@@ -217,7 +191,7 @@ namespace RTree
             auto it = std::find(m_entries.begin(), m_entries.end(), entry);
             if (it != m_entries.end())
             {
-                m_entries.erase(it);
+                eraseEntry(it - m_entries.begin());
             }
         }
 
@@ -228,4 +202,49 @@ namespace RTree
         return entriesToReinsert;
     }
 
+    void LeafNode::appendEntry(Data *data)
+    {
+        m_entries.push_back(data);
+        m_ids.push_back(data->getIdentifier());
+        m_entryMBRs.push_back(data->getRegion());
+    }
+
+    void LeafNode::eraseEntry(size_t index)
+    {
+        m_entries.erase(m_entries.begin() + index);
+        m_ids.erase(m_ids.begin() + index);
+        m_entryMBRs.erase(index);
+    }
+
+    void LeafNode::clearEntries()
+    {
+        m_entries.clear();
+        m_ids.clear();
+        m_entryMBRs.clear();
+    }
+
+    void LeafNode::refreshEntry(size_t index)
+    {
+        const bool wasOnBoundary = m_entryMBRs.touchesBoundary(index, m_mbr);
+        m_entryMBRs.set(index, m_entries[index]->getRegion());
+        if (wasOnBoundary)
+        {
+            recalculateMBR();
+        }
+        else
+        {
+            expandMBR(m_entries[index]->getRegion());
+        }
+    }
+
+    void LeafNode::detachEntry(size_t index)
+    {
+        const bool wasOnBoundary = m_entryMBRs.touchesBoundary(index, m_mbr);
+        eraseEntry(index);
+        if (wasOnBoundary)
+        {
+            recalculateMBR();
+        }
+    }
+
 } // namespace RTree
\ No newline at end of file
@@ -6,6 +6,7 @@
 #define LEAFNODE_H
 #include <cstdint>
 
+#include "MBRColumns.h"
 #include "Node.h"
 #include "src/RTree/impl/Region.h"
 
@@ -14,7 +15,8 @@ namespace RTree
     class LeafNode : public Node
     {
     public:
-        LeafNode(uint32_t capacity,
+        LeafNode(uint32_t dimension,
+            uint32_t capacity,
             const SplitStrategy *splitStrategy,
             MetricManager* metric_manager);
         ~LeafNode() override;
@@ -22,11 +24,12 @@ namespace RTree
         bool isLeaf() const override;
         const Region &getMBR() const override;
         void insert(Data *data) override;
-        bool remove(id_type id, const Region &mbr) override;
         bool isEmpty() override;
         unsigned long size() override;
         std::vector<Node *> children() override;
-        std::vector<Data *> search(const Region &query) override;
+        void search(const Region &query, Visitor &visitor) override;
+        void searchBatch(const Region *queries, const uint32_t *active, size_t count,
+                         std::vector<std::vector<Data *>> &results) override;
         bool shouldSplit() const override;
         std::pair<Node *, Node *> split() override;
         uint32_t getHeight() const override;
@@ -36,13 +39,31 @@ namespace RTree
 
     private:
         uint32_t m_capacity;
+        // Parallel arrays: entry i is m_entries[i], with id m_ids[i] and MBR m_entryMBRs[i]
         std::vector<Data *> m_entries;
+        std::vector<id_type> m_ids;
+        MBRColumns m_entryMBRs;
         Region m_mbr;
 
         void recalculateMBR();
+        // Grows m_mbr to cover region, never shrinks it
+        void expandMBR(const Region &region);
+        void appendEntry(Data *data);
+        void eraseEntry(size_t index);
+        void clearEntries();
+        // Re-reads entry index's region after it changed; the MBR is only rescanned when
+        // the old region was on its boundary
+        void refreshEntry(size_t index);
+        // Erases entry index, rescanning the MBR only when the entry was on its boundary
+        void detachEntry(size_t index);
 
         friend class RTree;
+        friend class NearestNeighborCursor;
         friend class InternalNode;
+        friend class ConcurrentRTree;
+        friend class SnapshotRTree;
+        friend class SpatialJoin;
+        friend class FrozenRTree;
     };
 
 }
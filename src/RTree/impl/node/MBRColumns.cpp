@@ -0,0 +1,251 @@
+#include "MBRColumns.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include "src/RTree/impl/simd/SimdKernels.h"
+
+namespace RTree
+{
+    MBRColumns::MBRColumns(uint32_t dimension, uint32_t reserve)
+        : m_dimension(dimension), m_stride(std::max<uint32_t>(reserve, 1)),
+          m_coords(2 * static_cast<size_t>(dimension) * m_stride)
+    {
+    }
+
+    void MBRColumns::push_back(const Region &mbr)
+    {
+        if (m_size == m_stride)
+        {
+            grow();
+        }
+
+        ++m_size;
+        set(m_size - 1, mbr);
+    }
+
+    void MBRColumns::set(size_t index, const Region &mbr)
+    {
+        // A region of another dimension (the empty Region(0)) is stored inverted so it never intersects
+        const bool valid = mbr.getDimension() == m_dimension;
+        for (uint32_t d = 0; d < m_dimension; ++d)
+        {
+            lows(d)[index] = valid ? mbr.getLow(d) : std::numeric_limits<double>::max();
+            highs(d)[index] = valid ? mbr.getHigh(d) : std::numeric_limits<double>::lowest();
+        }
+    }
+
+    void MBRColumns::erase(size_t index)
+    {
+        // Shift the tail down in every column to keep indices aligned with the owner's arrays
+        const size_t tail = m_size - index - 1;
+        for (uint32_t c = 0; c < 2 * m_dimension; ++c)
+        {
+            double *column = m_coords.data() + c * m_stride;
+            memmove(column + index, column + index + 1, tail * sizeof(double));
+        }
+        --m_size;
+    }
+
+    void MBRColumns::clear()
+    {
+        m_size = 0;
+    }
+
+    size_t MBRColumns::size() const
+    {
+        return m_size;
+    }
+
+    uint32_t MBRColumns::getDimension() const
+    {
+        return m_dimension;
+    }
+
+    bool MBRColumns::intersects(size_t index, const Region &query) const
+    {
+        if (query.getDimension() != m_dimension)
+        {
+            return false;
+        }
+
+        for (uint32_t d = 0; d < m_dimension; ++d)
+        {
+            if (lows(d)[index] > query.getHigh(d) || highs(d)[index] < query.getLow(d))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool MBRColumns::touchesBoundary(size_t index, const Region &mbr) const
+    {
+        if (mbr.getDimension() != m_dimension)
+        {
+            return true;
+        }
+
+        for (uint32_t d = 0; d < m_dimension; ++d)
+        {
+            if (lows(d)[index] <= mbr.getLow(d) || highs(d)[index] >= mbr.getHigh(d))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    Region MBRColumns::bounds() const
+    {
+        if (m_size == 0)
+        {
+            return Region(0);
+        }
+
+        // One pass down each column, on the stack for the dimensions a Region keeps inline
+        double inlineCoords[2 * Region::kInlineDimensions];
+        std::vector<double> heapCoords;
+        double *low = inlineCoords;
+        if (m_dimension > Region::kInlineDimensions)
+        {
+            heapCoords.resize(2 * m_dimension);
+            low = heapCoords.data();
+        }
+        double *high = low + m_dimension;
+        for (uint32_t d = 0; d < m_dimension; ++d)
+        {
+            low[d] = *std::min_element(lows(d), lows(d) + m_size);
+            high[d] = *std::max_element(highs(d), highs(d) + m_size);
+        }
+
+        // Only empty regions, stored inverted
+        if (low[0] > high[0])
+        {
+            return Region(0);
+        }
+        return Region(low, high, m_dimension);
+    }
+
+    double MBRColumns::getArea(size_t index) const
+    {
+        double area = 1.0;
+        for (uint32_t d = 0; d < m_dimension; ++d)
+        {
+            area *= (highs(d)[index] - lows(d)[index]);
+        }
+        return area;
+    }
+
+    double MBRColumns::getMinDistanceSquared(size_t index, const double *point) const
+    {
+        double distance = 0.0;
+        for (uint32_t d = 0; d < m_dimension; ++d)
+        {
+            const double below = lows(d)[index] - point[d];
+            const double above = point[d] - highs(d)[index];
+            const double gap = std::max(0.0, std::max(below, above));
+            distance += gap * gap;
+        }
+        return distance;
+    }
+
+    double MBRColumns::getMinMaxDistanceSquared(size_t index, const double *point) const
+    {
+        // Along every axis the nearer face is at rm, the farther one at rM. The bound picks the
+        // axis k minimising |p_k - rm_k|^2 + sum over the other axes of |p_i - rM_i|^2. Summed in
+        // axis order like getMinDistanceSquared, so it never rounds below the distance it bounds.
+        double best = std::numeric_limits<double>::max();
+        for (uint32_t k = 0; k < m_dimension; ++k)
+        {
+            double distance = 0.0;
+            for (uint32_t d = 0; d < m_dimension; ++d)
+            {
+                const double middle = (lows(d)[index] + highs(d)[index]) / 2.0;
+                double face;
+                if (d == k)
+                {
+                    face = point[d] <= middle ? lows(d)[index] : highs(d)[index];
+                }
+                else
+                {
+                    face = point[d] >= middle ? lows(d)[index] : highs(d)[index];
+                }
+                const double gap = point[d] - face;
+                distance += gap * gap;
+            }
+            best = std::min(best, distance);
+        }
+        return best;
+    }
+
+    size_t MBRColumns::chooseLeastEnlargement(const Region &mbr) const
+    {
+        double minEnlargement = std::numeric_limits<double>::max();
+        double bestArea = std::numeric_limits<double>::max();
+        size_t best = 0;
+
+        if (mbr.getDimension() != m_dimension)
+        {
+            return best;
+        }
+
+        // Enlargements are computed for a block of entries at a time by the vector kernel
+        constexpr size_t kBlock = 64;
+        double area[kBlock];
+        double enlargement[kBlock];
+
+        for (size_t base = 0; base < m_size; base += kBlock)
+        {
+            const size_t count = std::min(kBlock, m_size - base);
+            simd::areaEnlargements(lows(0) + base, highs(0) + base, m_stride, m_dimension,
+                                   mbr.getLowCoordinates(), mbr.getHighCoordinates(), count, area, enlargement);
+
+            for (size_t j = 0; j < count; ++j)
+            {
+                // Primary criterion: minimum expansion, secondary: smaller area
+                if (base + j == 0 || enlargement[j] < minEnlargement ||
+                    (enlargement[j] == minEnlargement && area[j] < bestArea))
+                {
+                    minEnlargement = enlargement[j];
+                    bestArea = area[j];
+                    best = base + j;
+                }
+            }
+        }
+        return best;
+    }
+
+    void MBRColumns::grow()
+    {
+        const size_t newStride = m_stride * 2;
+        std::vector<double> coords(2 * static_cast<size_t>(m_dimension) * newStride);
+        for (uint32_t c = 0; c < 2 * m_dimension; ++c)
+        {
+            memcpy(coords.data() + c * newStride, m_coords.data() + c * m_stride, m_size * sizeof(double));
+        }
+        m_coords.swap(coords);
+        m_stride = newStride;
+    }
+
+    uint64_t MBRColumns::intersectBlock(const Region &query, size_t base, size_t count) const
+    {
+        return simd::intersectMask(lows(0) + base, highs(0) + base, m_stride, m_dimension,
+                                   query.getLowCoordinates(), query.getHighCoordinates(), count);
+    }
+
+    unsigned MBRColumns::countTrailingZeros(uint64_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+    }
+}
@@ -0,0 +1,105 @@
+//
+// Structure-of-arrays storage for the MBRs of a node's entries or children.
+//
+
+#ifndef MBRCOLUMNS_H
+#define MBRCOLUMNS_H
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "src/RTree/impl/Region.h"
+
+namespace RTree
+{
+    // Keeps one contiguous array of low bounds and one of high bounds per dimension,
+    // so filtering a node against a query scans a few dense arrays instead of
+    // dereferencing every child. Index i always describes the node's i-th entry/child.
+    class MBRColumns
+    {
+    public:
+        MBRColumns(uint32_t dimension, uint32_t reserve);
+
+        void push_back(const Region &mbr);
+        void set(size_t index, const Region &mbr);
+        void erase(size_t index);
+        void clear();
+
+        size_t size() const;
+        uint32_t getDimension() const;
+
+        bool intersects(size_t index, const Region &query) const;
+        // True when MBR index reaches a face of mbr, which may then shrink without it; always
+        // true for an mbr of another dimension
+        bool touchesBoundary(size_t index, const Region &mbr) const;
+        // Smallest region covering every MBR, the empty Region(0) when there is none
+        Region bounds() const;
+        double getArea(size_t index) const;
+
+        // Squared distance from point (getDimension() coordinates) to MBR index, 0 inside it
+        double getMinDistanceSquared(size_t index, const double *point) const;
+        // Squared MINMAXDIST (Roussopoulos et al.): some object touching every face of MBR index is
+        // at most this far from point, so it bounds the distance to the nearest object inside
+        double getMinMaxDistanceSquared(size_t index, const double *point) const;
+
+        // Index of the entry needing the least area enlargement to cover mbr,
+        // ties broken by the smaller area (Guttman's ChooseLeaf criterion)
+        size_t chooseLeastEnlargement(const Region &mbr) const;
+
+        // Calls visit(i) for every index whose MBR intersects query, in index order
+        template <typename Visit>
+        void forEachIntersecting(const Region &query, Visit &&visit) const
+        {
+            if (query.getDimension() != m_dimension)
+            {
+                return;
+            }
+
+            for (size_t base = 0; base < m_size; base += 64)
+            {
+                uint64_t mask = intersectBlock(query, base, std::min<size_t>(64, m_size - base));
+                while (mask != 0)
+                {
+                    visit(base + countTrailingZeros(mask));
+                    mask &= mask - 1;
+                }
+            }
+        }
+
+        const double *lows(uint32_t dim) const
+        {
+            return m_coords.data() + dim * m_stride;
+        }
+
+        const double *highs(uint32_t dim) const
+        {
+            return m_coords.data() + (m_dimension + dim) * m_stride;
+        }
+
+    private:
+        uint32_t m_dimension;
+        size_t m_size = 0;
+        size_t m_stride;
+        // 2 * m_dimension blocks of m_stride values: all low columns, then all high columns
+        std::vector<double> m_coords;
+
+        double *lows(uint32_t dim)
+        {
+            return m_coords.data() + dim * m_stride;
+        }
+
+        double *highs(uint32_t dim)
+        {
+            return m_coords.data() + (m_dimension + dim) * m_stride;
+        }
+
+        void grow();
+
+        // Bit j set when entry base + j intersects query, for count <= 64 entries
+        uint64_t intersectBlock(const Region &query, size_t base, size_t count) const;
+
+        static unsigned countTrailingZeros(uint64_t mask);
+    };
+}
+
+#endif //MBRCOLUMNS_H
@@ -4,6 +4,7 @@
 
 #ifndef NODE_H
 #define NODE_H
+#include <shared_mutex>
 #include <vector>
 
 #include "src/RTree/impl/common.h"
@@ -12,8 +13,10 @@
 namespace RTree
 {
     class Data;
+    class InternalNode;
     class Region;
     class SplitStrategy;
+    class Visitor;
     class RTree; // Forward declaration
 
     class Node
@@ -26,11 +29,15 @@ namespace RTree
         virtual bool isLeaf() const = 0;
         virtual const Region &getMBR() const = 0;
         virtual void insert(Data *data) = 0;
-        virtual bool remove(id_type id, const Region &mbr) = 0;
         virtual bool isEmpty() = 0;
         virtual unsigned long size() = 0;
         virtual std::vector<Node *> children() = 0;
-        virtual std::vector<Data *> search(const Region &query) = 0;
+        // Hands every entry in this subtree that intersects query to the visitor
+        virtual void search(const Region &query, Visitor &visitor) = 0;
+        // Batched search: queries[active[j]] for the count active queries that reach this node,
+        // each query's matches appended to results[query]
+        virtual void searchBatch(const Region *queries, const uint32_t *active, size_t count,
+                                 std::vector<std::vector<Data *>> &results) = 0;
         virtual bool shouldSplit() const = 0;
         virtual std::pair<Node *, Node *> split() = 0;
         virtual uint32_t getHeight() const = 0;
@@ -50,12 +57,31 @@ namespace RTree
             return m_tree;
         }
 
+        // The internal node holding this one, nullptr for the root. Kept by RTree's own inserts,
+        // removes and bulk loads; ConcurrentRTree and SnapshotRTree do not maintain it.
+        InternalNode *getParent() const
+        {
+            return m_parent;
+        }
+
+        void setParent(InternalNode *parent)
+        {
+            m_parent = parent;
+        }
+
     protected:
         MetricManager *metric_manager;
         const SplitStrategy *m_splitStrategy = nullptr;
         bool overflow = true;        // Flag to track if this is the first overflow at this level
         double reinsertFactor = 0.3; // Percentage of entries to reinsert (30%)
         RTree *m_tree = nullptr;     // Pointer to parent tree
+        InternalNode *m_parent = nullptr;
+
+    private:
+        // Taken by ConcurrentRTree only: shared to read the node, exclusive to change it
+        std::shared_mutex m_latch;
+
+        friend class ConcurrentRTree;
     };
 }
 
@@ -5,22 +5,96 @@
 
 namespace RTree
 {
-    Point::Point(const double *coords, uint32_t dimension, int id) : m_dimension(dimension), id(id)
+    Point::Point(const double *coords, uint32_t dimension, int id) : id(id)
     {
-        m_pCoords = new double[dimension];
+        allocate(dimension);
         memcpy(m_pCoords, coords, dimension * sizeof(double));
     }
 
-    Point::Point(const Point &other) : m_dimension(other.m_dimension)
+    Point::Point(const Point &other) : id(other.id)
     {
-        m_pCoords = new double[m_dimension];
+        allocate(other.m_dimension);
         memcpy(m_pCoords, other.m_pCoords, m_dimension * sizeof(double));
-        this->id = other.id;
+    }
+
+    Point::Point(Point &&other) noexcept : id(other.id)
+    {
+        if (other.isInline())
+        {
+            allocate(other.m_dimension);
+            memcpy(m_pCoords, other.m_pCoords, m_dimension * sizeof(double));
+            return;
+        }
+
+        // Steal the heap block and leave other as an empty inline point
+        m_dimension = other.m_dimension;
+        m_pCoords = other.m_pCoords;
+        other.allocate(0);
     }
 
     Point::~Point()
     {
-        delete[] m_pCoords;
+        release();
+    }
+
+    Point &Point::operator=(const Point &other)
+    {
+        if (this != &other)
+        {
+            if (m_dimension != other.m_dimension)
+            {
+                release();
+                allocate(other.m_dimension);
+            }
+            memcpy(m_pCoords, other.m_pCoords, m_dimension * sizeof(double));
+            id = other.id;
+        }
+        return *this;
+    }
+
+    Point &Point::operator=(Point &&other) noexcept
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        id = other.id;
+        if (other.isInline())
+        {
+            if (m_dimension != other.m_dimension)
+            {
+                release();
+                allocate(other.m_dimension);
+            }
+            memcpy(m_pCoords, other.m_pCoords, m_dimension * sizeof(double));
+            return *this;
+        }
+
+        release();
+        m_dimension = other.m_dimension;
+        m_pCoords = other.m_pCoords;
+        other.allocate(0);
+        return *this;
+    }
+
+    void Point::allocate(uint32_t dimension)
+    {
+        m_dimension = dimension;
+        m_pCoords = dimension <= kInlineDimensions ? m_inlineCoords : new double[dimension];
+    }
+
+    void Point::release()
+    {
+        if (!isInline())
+        {
+            delete[] m_pCoords;
+        }
+    }
+
+    bool Point::isInline() const
+    {
+        return m_pCoords == m_inlineCoords;
     }
 
     bool Point::operator==(const Point &other) const
@@ -46,6 +120,11 @@ namespace RTree
         return m_pCoords[index];
     }
 
+    const double *Point::getCoordinates() const
+    {
+        return m_pCoords;
+    }
+
     uint32_t Point::getDimension() const
     {
         return m_dimension;
@@ -13,18 +13,32 @@ namespace RTree {
     public:
         Point(const double *coords, uint32_t dimension, int id);
         Point(const Point &other);
+        Point(Point &&other) noexcept;
         ~Point();
 
+        Point &operator=(const Point &other);
+        Point &operator=(Point &&other) noexcept;
+
         bool operator==(const Point &other) const;
 
         double getCoordinate(uint32_t index) const;
+        // Unchecked access to all getDimension() coordinates
+        const double *getCoordinates() const;
         uint32_t getDimension() const;
         int getId() const;
 
+        // Points up to this dimension keep their coordinates inside the object
+        static constexpr uint32_t kInlineDimensions = 3;
+
     private:
         uint32_t m_dimension;
         double *m_pCoords;
         int id;
+        double m_inlineCoords[kInlineDimensions];
+
+        void allocate(uint32_t dimension);
+        void release();
+        bool isInline() const;
     };
 }
 
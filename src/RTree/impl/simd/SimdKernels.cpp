@@ -0,0 +1,312 @@
+#include "SimdKernels.h"
+
+#include <algorithm>
+#include <atomic>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define RTREE_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace RTree::simd
+{
+    namespace
+    {
+        using IntersectKernel = uint64_t (*)(const double *, const double *, size_t, uint32_t,
+                                             const double *, const double *, size_t);
+        using EnlargementKernel = void (*)(const double *, const double *, size_t, uint32_t,
+                                           const double *, const double *, size_t, double *, double *);
+
+        // Scalar reference, evaluated exactly like Region::intersects
+        uint64_t intersectMaskScalar(const double *lowColumns, const double *highColumns, size_t stride,
+                                     uint32_t dimension, const double *queryLow, const double *queryHigh,
+                                     size_t count, size_t first = 0)
+        {
+            uint64_t mask = 0;
+            for (size_t j = first; j < count; ++j)
+            {
+                bool intersects = true;
+                for (uint32_t d = 0; d < dimension && intersects; ++d)
+                {
+                    intersects = !(lowColumns[d * stride + j] > queryHigh[d] ||
+                                   highColumns[d * stride + j] < queryLow[d]);
+                }
+                mask |= uint64_t(intersects) << j;
+            }
+            return mask;
+        }
+
+        // Scalar reference, evaluated exactly like Region::getArea on the box and on its combination
+        void areaEnlargementsScalar(const double *lowColumns, const double *highColumns, size_t stride,
+                                    uint32_t dimension, const double *mbrLow, const double *mbrHigh,
+                                    size_t count, double *area, double *enlargement, size_t first = 0)
+        {
+            for (size_t j = first; j < count; ++j)
+            {
+                double boxArea = 1.0;
+                double combinedArea = 1.0;
+                for (uint32_t d = 0; d < dimension; ++d)
+                {
+                    const double low = lowColumns[d * stride + j];
+                    const double high = highColumns[d * stride + j];
+                    boxArea *= (high - low);
+                    combinedArea *= (std::max(high, mbrHigh[d]) - std::min(low, mbrLow[d]));
+                }
+                area[j] = boxArea;
+                enlargement[j] = combinedArea - boxArea;
+            }
+        }
+
+#ifdef RTREE_SIMD_X86
+        // The vector kernels use the "not greater"/"not less" predicates so NaNs behave as in
+        // the scalar code, and max(mbr, box)/min(mbr, box) operand order so ties and NaNs
+        // pick the same operand as std::max(box, mbr)/std::min(box, mbr).
+
+        __attribute__((target("sse2")))
+        uint64_t intersectMaskSSE2(const double *lowColumns, const double *highColumns, size_t stride,
+                                   uint32_t dimension, const double *queryLow, const double *queryHigh, size_t count)
+        {
+            uint64_t mask = 0;
+            size_t j = 0;
+            for (; j + 2 <= count; j += 2)
+            {
+                __m128d hit = _mm_castsi128_pd(_mm_set1_epi32(-1));
+                for (uint32_t d = 0; d < dimension; ++d)
+                {
+                    __m128d low = _mm_loadu_pd(lowColumns + d * stride + j);
+                    __m128d high = _mm_loadu_pd(highColumns + d * stride + j);
+                    hit = _mm_and_pd(hit, _mm_cmpngt_pd(low, _mm_set1_pd(queryHigh[d])));
+                    hit = _mm_and_pd(hit, _mm_cmpnlt_pd(high, _mm_set1_pd(queryLow[d])));
+                }
+                mask |= uint64_t(_mm_movemask_pd(hit)) << j;
+            }
+            return mask | intersectMaskScalar(lowColumns, highColumns, stride, dimension, queryLow, queryHigh, count, j);
+        }
+
+        __attribute__((target("sse2")))
+        void areaEnlargementsSSE2(const double *lowColumns, const double *highColumns, size_t stride,
+                                  uint32_t dimension, const double *mbrLow, const double *mbrHigh, size_t count,
+                                  double *area, double *enlargement)
+        {
+            size_t j = 0;
+            for (; j + 2 <= count; j += 2)
+            {
+                __m128d boxArea = _mm_set1_pd(1.0);
+                __m128d combinedArea = _mm_set1_pd(1.0);
+                for (uint32_t d = 0; d < dimension; ++d)
+                {
+                    __m128d low = _mm_loadu_pd(lowColumns + d * stride + j);
+                    __m128d high = _mm_loadu_pd(highColumns + d * stride + j);
+                    boxArea = _mm_mul_pd(boxArea, _mm_sub_pd(high, low));
+                    combinedArea = _mm_mul_pd(combinedArea,
+                                              _mm_sub_pd(_mm_max_pd(_mm_set1_pd(mbrHigh[d]), high),
+                                                         _mm_min_pd(_mm_set1_pd(mbrLow[d]), low)));
+                }
+                _mm_storeu_pd(area + j, boxArea);
+                _mm_storeu_pd(enlargement + j, _mm_sub_pd(combinedArea, boxArea));
+            }
+            areaEnlargementsScalar(lowColumns, highColumns, stride, dimension, mbrLow, mbrHigh, count,
+                                   area, enlargement, j);
+        }
+
+        __attribute__((target("avx2")))
+        uint64_t intersectMaskAVX2(const double *lowColumns, const double *highColumns, size_t stride,
+                                   uint32_t dimension, const double *queryLow, const double *queryHigh, size_t count)
+        {
+            uint64_t mask = 0;
+            size_t j = 0;
+            for (; j + 4 <= count; j += 4)
+            {
+                __m256d hit = _mm256_castsi256_pd(_mm256_set1_epi32(-1));
+                for (uint32_t d = 0; d < dimension; ++d)
+                {
+                    __m256d low = _mm256_loadu_pd(lowColumns + d * stride + j);
+                    __m256d high = _mm256_loadu_pd(highColumns + d * stride + j);
+                    hit = _mm256_and_pd(hit, _mm256_cmp_pd(low, _mm256_set1_pd(queryHigh[d]), _CMP_NGT_UQ));
+                    hit = _mm256_and_pd(hit, _mm256_cmp_pd(high, _mm256_set1_pd(queryLow[d]), _CMP_NLT_UQ));
+                }
+                mask |= uint64_t(_mm256_movemask_pd(hit)) << j;
+            }
+            return mask | intersectMaskScalar(lowColumns, highColumns, stride, dimension, queryLow, queryHigh, count, j);
+        }
+
+        __attribute__((target("avx2")))
+        void areaEnlargementsAVX2(const double *lowColumns, const double *highColumns, size_t stride,
+                                  uint32_t dimension, const double *mbrLow, const double *mbrHigh, size_t count,
+                                  double *area, double *enlargement)
+        {
+            size_t j = 0;
+            for (; j + 4 <= count; j += 4)
+            {
+                __m256d boxArea = _mm256_set1_pd(1.0);
+                __m256d combinedArea = _mm256_set1_pd(1.0);
+                for (uint32_t d = 0; d < dimension; ++d)
+                {
+                    __m256d low = _mm256_loadu_pd(lowColumns + d * stride + j);
+                    __m256d high = _mm256_loadu_pd(highColumns + d * stride + j);
+                    boxArea = _mm256_mul_pd(boxArea, _mm256_sub_pd(high, low));
+                    combinedArea = _mm256_mul_pd(combinedArea,
+                                                 _mm256_sub_pd(_mm256_max_pd(_mm256_set1_pd(mbrHigh[d]), high),
+                                                               _mm256_min_pd(_mm256_set1_pd(mbrLow[d]), low)));
+                }
+                _mm256_storeu_pd(area + j, boxArea);
+                _mm256_storeu_pd(enlargement + j, _mm256_sub_pd(combinedArea, boxArea));
+            }
+            areaEnlargementsScalar(lowColumns, highColumns, stride, dimension, mbrLow, mbrHigh, count,
+                                   area, enlargement, j);
+        }
+
+        __attribute__((target("avx512f")))
+        uint64_t intersectMaskAVX512(const double *lowColumns, const double *highColumns, size_t stride,
+                                     uint32_t dimension, const double *queryLow, const double *queryHigh, size_t count)
+        {
+            uint64_t mask = 0;
+            size_t j = 0;
+            for (; j + 8 <= count; j += 8)
+            {
+                __mmask8 hit = 0xFF;
+                for (uint32_t d = 0; d < dimension; ++d)
+                {
+                    __m512d low = _mm512_loadu_pd(lowColumns + d * stride + j);
+                    __m512d high = _mm512_loadu_pd(highColumns + d * stride + j);
+                    hit = _mm512_mask_cmp_pd_mask(hit, low, _mm512_set1_pd(queryHigh[d]), _CMP_NGT_UQ);
+                    hit = _mm512_mask_cmp_pd_mask(hit, high, _mm512_set1_pd(queryLow[d]), _CMP_NLT_UQ);
+                }
+                mask |= uint64_t(hit) << j;
+            }
+            return mask | intersectMaskScalar(lowColumns, highColumns, stride, dimension, queryLow, queryHigh, count, j);
+        }
+
+        __attribute__((target("avx512f")))
+        void areaEnlargementsAVX512(const double *lowColumns, const double *highColumns, size_t stride,
+                                    uint32_t dimension, const double *mbrLow, const double *mbrHigh, size_t count,
+                                    double *area, double *enlargement)
+        {
+            size_t j = 0;
+            for (; j + 8 <= count; j += 8)
+            {
+                __m512d boxArea = _mm512_set1_pd(1.0);
+                __m512d combinedArea = _mm512_set1_pd(1.0);
+                for (uint32_t d = 0; d < dimension; ++d)
+                {
+                    __m512d low = _mm512_loadu_pd(lowColumns + d * stride + j);
+                    __m512d high = _mm512_loadu_pd(highColumns + d * stride + j);
+                    boxArea = _mm512_mul_pd(boxArea, _mm512_sub_pd(high, low));
+                    // The zero-masked forms with every lane selected: GCC 12 implements the plain
+                    // min/max over an undefined pass-through vector and warns about it
+                    combinedArea = _mm512_mul_pd(
+                        combinedArea,
+                        _mm512_sub_pd(_mm512_maskz_max_pd(0xFF, _mm512_set1_pd(mbrHigh[d]), high),
+                                      _mm512_maskz_min_pd(0xFF, _mm512_set1_pd(mbrLow[d]), low)));
+                }
+                _mm512_storeu_pd(area + j, boxArea);
+                _mm512_storeu_pd(enlargement + j, _mm512_sub_pd(combinedArea, boxArea));
+            }
+            areaEnlargementsScalar(lowColumns, highColumns, stride, dimension, mbrLow, mbrHigh, count,
+                                   area, enlargement, j);
+        }
+#endif
+
+        uint64_t intersectMaskScalarKernel(const double *lowColumns, const double *highColumns, size_t stride,
+                                           uint32_t dimension, const double *queryLow, const double *queryHigh,
+                                           size_t count)
+        {
+            return intersectMaskScalar(lowColumns, highColumns, stride, dimension, queryLow, queryHigh, count);
+        }
+
+        void areaEnlargementsScalarKernel(const double *lowColumns, const double *highColumns, size_t stride,
+                                          uint32_t dimension, const double *mbrLow, const double *mbrHigh,
+                                          size_t count, double *area, double *enlargement)
+        {
+            areaEnlargementsScalar(lowColumns, highColumns, stride, dimension, mbrLow, mbrHigh, count,
+                                   area, enlargement);
+        }
+
+        struct Kernels
+        {
+            IntersectKernel intersectMask;
+            EnlargementKernel areaEnlargements;
+        };
+
+        const Kernels &kernelsFor(IsaLevel level)
+        {
+            static const Kernels table[] = {
+                {intersectMaskScalarKernel, areaEnlargementsScalarKernel},
+#ifdef RTREE_SIMD_X86
+                {intersectMaskSSE2, areaEnlargementsSSE2},
+                {intersectMaskAVX2, areaEnlargementsAVX2},
+                {intersectMaskAVX512, areaEnlargementsAVX512},
+#endif
+            };
+            return table[static_cast<int>(level)];
+        }
+
+        std::atomic<int> &activeLevel()
+        {
+            static std::atomic<int> level{static_cast<int>(detectIsaLevel())};
+            return level;
+        }
+    }
+
+    IsaLevel detectIsaLevel()
+    {
+#ifdef RTREE_SIMD_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            return IsaLevel::AVX512;
+        }
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return IsaLevel::AVX2;
+        }
+        if (__builtin_cpu_supports("sse2"))
+        {
+            return IsaLevel::SSE2;
+        }
+#endif
+        return IsaLevel::Scalar;
+    }
+
+    IsaLevel getIsaLevel()
+    {
+        return static_cast<IsaLevel>(activeLevel().load(std::memory_order_relaxed));
+    }
+
+    IsaLevel setIsaLevel(IsaLevel level)
+    {
+        const IsaLevel supported = std::min(level, detectIsaLevel());
+        activeLevel().store(static_cast<int>(supported), std::memory_order_relaxed);
+        return supported;
+    }
+
+    const char *getIsaName(IsaLevel level)
+    {
+        switch (level)
+        {
+        case IsaLevel::SSE2:
+            return "SSE2";
+        case IsaLevel::AVX2:
+            return "AVX2";
+        case IsaLevel::AVX512:
+            return "AVX-512";
+        default:
+            return "scalar";
+        }
+    }
+
+    uint64_t intersectMask(const double *lowColumns, const double *highColumns, size_t stride,
+                           uint32_t dimension, const double *queryLow, const double *queryHigh, size_t count)
+    {
+        return kernelsFor(getIsaLevel()).intersectMask(lowColumns, highColumns, stride, dimension,
+                                                       queryLow, queryHigh, count);
+    }
+
+    void areaEnlargements(const double *lowColumns, const double *highColumns, size_t stride,
+                          uint32_t dimension, const double *mbrLow, const double *mbrHigh, size_t count,
+                          double *area, double *enlargement)
+    {
+        kernelsFor(getIsaLevel()).areaEnlargements(lowColumns, highColumns, stride, dimension,
+                                                   mbrLow, mbrHigh, count, area, enlargement);
+    }
+}
@@ -0,0 +1,47 @@
+//
+// Vectorised MBR kernels over MBRColumns-style storage, selected at runtime.
+//
+
+#ifndef SIMDKERNELS_H
+#define SIMDKERNELS_H
+#include <cstddef>
+#include <cstdint>
+
+namespace RTree::simd
+{
+    enum class IsaLevel
+    {
+        Scalar = 0,
+        SSE2 = 1,
+        AVX2 = 2,
+        AVX512 = 3
+    };
+
+    // Best level supported by the running CPU (and by the compiler that built us)
+    IsaLevel detectIsaLevel();
+
+    // Level used by the kernels below; defaults to detectIsaLevel()
+    IsaLevel getIsaLevel();
+
+    // Force a level, e.g. to benchmark one against another. Levels the CPU does not
+    // support are clamped to the best supported one; returns the level now in use.
+    IsaLevel setIsaLevel(IsaLevel level);
+
+    const char *getIsaName(IsaLevel level);
+
+    // Boxes are given column-wise: the low bounds of dimension d start at
+    // lowColumns + d * stride, the high bounds at highColumns + d * stride.
+    // Results are bit-identical to Region::intersects / Region::getArea at every level.
+
+    // Bit j is set when box j intersects [queryLow, queryHigh], for count <= 64 boxes
+    uint64_t intersectMask(const double *lowColumns, const double *highColumns, size_t stride,
+                           uint32_t dimension, const double *queryLow, const double *queryHigh, size_t count);
+
+    // area[j] is the area of box j, enlargement[j] how much it grows when combined with
+    // [mbrLow, mbrHigh], for count boxes
+    void areaEnlargements(const double *lowColumns, const double *highColumns, size_t stride,
+                          uint32_t dimension, const double *mbrLow, const double *mbrHigh, size_t count,
+                          double *area, double *enlargement);
+}
+
+#endif //SIMDKERNELS_H
@@ -0,0 +1,240 @@
+#include "BufferPool.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace RTree
+{
+    BufferPool::Page::Page(BufferPool *pool, size_t frame) : m_pool(pool), m_frame(frame)
+    {
+    }
+
+    BufferPool::Page::Page(Page &&other) noexcept : m_pool(other.m_pool), m_frame(other.m_frame)
+    {
+        other.m_pool = nullptr;
+    }
+
+    BufferPool::Page &BufferPool::Page::operator=(Page &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (m_pool != nullptr)
+            {
+                m_pool->unpin(m_frame);
+            }
+            m_pool = other.m_pool;
+            m_frame = other.m_frame;
+            other.m_pool = nullptr;
+        }
+        return *this;
+    }
+
+    BufferPool::Page::~Page()
+    {
+        if (m_pool != nullptr)
+        {
+            m_pool->unpin(m_frame);
+        }
+    }
+
+    char *BufferPool::Page::data() const
+    {
+        return m_pool->frameData(m_frame);
+    }
+
+    uint64_t BufferPool::Page::getId() const
+    {
+        return m_pool->m_frames[m_frame].pageId;
+    }
+
+    void BufferPool::Page::markDirty()
+    {
+        m_pool->m_frames[m_frame].dirty = true;
+    }
+
+    BufferPool::BufferPool(const std::string &path, bool create, uint32_t pageSize, size_t memoryBudget)
+        : m_pageSize(pageSize)
+    {
+        if (pageSize == 0 || pageSize % sizeof(uint64_t) != 0)
+        {
+            throw std::invalid_argument("Page size must be a multiple of 8");
+        }
+
+        m_fd = ::open(path.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR, 0644);
+        if (m_fd < 0)
+        {
+            throw std::runtime_error("Cannot open " + path);
+        }
+
+        const size_t frames = std::max<size_t>(8, memoryBudget / pageSize);
+        m_frames.resize(frames);
+        m_memory.resize(frames * (pageSize / sizeof(uint64_t)));
+        m_pageTable.reserve(frames);
+    }
+
+    BufferPool::~BufferPool()
+    {
+        try
+        {
+            flush();
+        }
+        catch (const std::runtime_error &)
+        {
+            // Destructors must not throw; call flush() first to see write errors
+        }
+        ::close(m_fd);
+    }
+
+    char *BufferPool::frameData(size_t frame)
+    {
+        return reinterpret_cast<char *>(m_memory.data()) + frame * m_pageSize;
+    }
+
+    size_t BufferPool::victim()
+    {
+        // Two full turns clear every reference bit, a third finding nothing means all are pinned
+        for (size_t step = 0; step < 3 * m_frames.size(); ++step)
+        {
+            const size_t frame = m_clockHand;
+            m_clockHand = (m_clockHand + 1) % m_frames.size();
+
+            Frame &candidate = m_frames[frame];
+            if (candidate.pinCount > 0)
+            {
+                continue;
+            }
+            if (candidate.referenced)
+            {
+                candidate.referenced = false;
+                continue;
+            }
+
+            if (candidate.used)
+            {
+                writeBack(frame);
+                m_pageTable.erase(candidate.pageId);
+                candidate.used = false;
+            }
+            return frame;
+        }
+        throw std::runtime_error("Every buffer pool frame is pinned");
+    }
+
+    size_t BufferPool::claim(uint64_t pageId)
+    {
+        const size_t frame = victim();
+        Frame &claimed = m_frames[frame];
+        claimed.pageId = pageId;
+        claimed.used = true;
+        claimed.dirty = false;
+        m_pageTable.emplace(pageId, frame);
+        return frame;
+    }
+
+    void BufferPool::writeBack(size_t frame)
+    {
+        Frame &dirty = m_frames[frame];
+        if (!dirty.used || !dirty.dirty)
+        {
+            return;
+        }
+
+        const auto offset = static_cast<off_t>(dirty.pageId * m_pageSize);
+        if (::pwrite(m_fd, frameData(frame), m_pageSize, offset) != static_cast<ssize_t>(m_pageSize))
+        {
+            throw std::runtime_error("Cannot write page " + std::to_string(dirty.pageId));
+        }
+        dirty.dirty = false;
+        ++m_stats.writes;
+    }
+
+    void BufferPool::unpin(size_t frame)
+    {
+        --m_frames[frame].pinCount;
+    }
+
+    BufferPool::Page BufferPool::fetch(uint64_t pageId)
+    {
+        size_t frame;
+        auto it = m_pageTable.find(pageId);
+        if (it != m_pageTable.end())
+        {
+            frame = it->second;
+            ++m_stats.hits;
+        }
+        else
+        {
+            frame = claim(pageId);
+            const auto offset = static_cast<off_t>(pageId * m_pageSize);
+            const ssize_t read = ::pread(m_fd, frameData(frame), m_pageSize, offset);
+            if (read < 0)
+            {
+                m_pageTable.erase(pageId);
+                m_frames[frame].used = false;
+                throw std::runtime_error("Cannot read page " + std::to_string(pageId));
+            }
+            // Past the end of the file reads as zeros
+            std::memset(frameData(frame) + read, 0, m_pageSize - static_cast<size_t>(read));
+            ++m_stats.reads;
+        }
+
+        m_frames[frame].pinCount++;
+        m_frames[frame].referenced = true;
+        return Page(this, frame);
+    }
+
+    BufferPool::Page BufferPool::create(uint64_t pageId)
+    {
+        auto it = m_pageTable.find(pageId);
+        const size_t frame = it != m_pageTable.end() ? it->second : claim(pageId);
+        std::memset(frameData(frame), 0, m_pageSize);
+        m_frames[frame].dirty = true;
+        m_frames[frame].pinCount++;
+        m_frames[frame].referenced = true;
+        return Page(this, frame);
+    }
+
+    void BufferPool::prefetch(uint64_t pageId)
+    {
+        if (!isCached(pageId))
+        {
+            ::posix_fadvise(m_fd, static_cast<off_t>(pageId * m_pageSize), m_pageSize, POSIX_FADV_WILLNEED);
+        }
+    }
+
+    bool BufferPool::isCached(uint64_t pageId) const
+    {
+        return m_pageTable.count(pageId) != 0;
+    }
+
+    void BufferPool::flush()
+    {
+        for (size_t frame = 0; frame < m_frames.size(); ++frame)
+        {
+            writeBack(frame);
+        }
+    }
+
+    uint32_t BufferPool::getPageSize() const
+    {
+        return m_pageSize;
+    }
+
+    size_t BufferPool::getFrameCount() const
+    {
+        return m_frames.size();
+    }
+
+    const BufferPool::Stats &BufferPool::getStats() const
+    {
+        return m_stats;
+    }
+
+    void BufferPool::resetStats()
+    {
+        m_stats = Stats();
+    }
+}
@@ -0,0 +1,111 @@
+//
+// Fixed-size pages of a file cached in a bounded set of frames.
+//
+
+#ifndef BUFFERPOOL_H
+#define BUFFERPOOL_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace RTree
+{
+    // Pages are read with pread into one of memoryBudget / pageSize frames, and dirty pages
+    // written back with pwrite when their frame is reused or on flush. Frames are reused in
+    // clock (second chance) order, skipping pinned ones. Not thread safe.
+    class BufferPool
+    {
+    public:
+        struct Stats
+        {
+            // Pages read from the file, i.e. misses
+            uint64_t reads = 0;
+            // Pages written back to the file
+            uint64_t writes = 0;
+            // Fetches answered from a frame
+            uint64_t hits = 0;
+        };
+
+        // A pinned page; its frame is not reused while the handle lives
+        class Page
+        {
+        public:
+            Page(Page &&other) noexcept;
+            Page &operator=(Page &&other) noexcept;
+            ~Page();
+
+            Page(const Page &) = delete;
+            Page &operator=(const Page &) = delete;
+
+            char *data() const;
+            uint64_t getId() const;
+            // The page is written back before its frame is reused
+            void markDirty();
+
+        private:
+            Page(BufferPool *pool, size_t frame);
+
+            BufferPool *m_pool;
+            size_t m_frame;
+
+            friend class BufferPool;
+        };
+
+        // Opens path, creating it (empty) when create is set. memoryBudget is rounded down to
+        // whole pages, with a minimum of 8 frames. Throws std::runtime_error if path cannot be opened.
+        BufferPool(const std::string &path, bool create, uint32_t pageSize, size_t memoryBudget);
+        // Writes back every dirty page, ignoring errors
+        ~BufferPool();
+
+        BufferPool(const BufferPool &) = delete;
+        BufferPool &operator=(const BufferPool &) = delete;
+
+        // The page, read from the file unless cached. Throws std::runtime_error when every frame
+        // is pinned or the read fails.
+        Page fetch(uint64_t pageId);
+        // A zeroed, dirty frame for a page whose old content is of no interest, e.g. a new one
+        Page create(uint64_t pageId);
+        // Hints the kernel to start reading a page that is not cached (posix_fadvise WILLNEED),
+        // so a later fetch finds it in the page cache
+        void prefetch(uint64_t pageId);
+        bool isCached(uint64_t pageId) const;
+
+        // Writes back every dirty page. Throws std::runtime_error when a write fails.
+        void flush();
+
+        uint32_t getPageSize() const;
+        size_t getFrameCount() const;
+        const Stats &getStats() const;
+        void resetStats();
+
+    private:
+        struct Frame
+        {
+            uint64_t pageId = 0;
+            uint32_t pinCount = 0;
+            bool used = false;
+            bool referenced = false;
+            bool dirty = false;
+        };
+
+        int m_fd;
+        uint32_t m_pageSize;
+        std::vector<Frame> m_frames;
+        // Frame i holds bytes [i * m_pageSize, (i + 1) * m_pageSize), 8 byte aligned for the doubles
+        std::vector<uint64_t> m_memory;
+        std::unordered_map<uint64_t, size_t> m_pageTable;
+        size_t m_clockHand = 0;
+        Stats m_stats;
+
+        char *frameData(size_t frame);
+        // Unpinned frame to load a page into, written back and unmapped if it held one
+        size_t victim();
+        size_t claim(uint64_t pageId);
+        void writeBack(size_t frame);
+        void unpin(size_t frame);
+    };
+}
+
+#endif //BUFFERPOOL_H
@@ -0,0 +1,217 @@
+#include "MappedRTree.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "src/RTree/impl/Region.h"
+#include "src/RTree/impl/pojo/Point.h"
+
+namespace RTree
+{
+    namespace
+    {
+        // product = a * b, false when it does not fit in 64 bits
+        bool multiply(uint64_t a, uint64_t b, uint64_t &product)
+        {
+            if (b != 0 && a > std::numeric_limits<uint64_t>::max() / b)
+            {
+                return false;
+            }
+            product = a * b;
+            return true;
+        }
+    }
+
+    MappedRTree::MappedRTree(const std::string &path)
+    {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open " + path);
+        }
+
+        struct stat status{};
+        if (::fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(TreeFileHeader))
+        {
+            ::close(fd);
+            throw std::runtime_error(path + " is not a tree file");
+        }
+        m_length = static_cast<size_t>(status.st_size);
+
+        // The mapping stays valid after the descriptor is closed
+        void *mapping = ::mmap(nullptr, m_length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED)
+        {
+            throw std::runtime_error("Cannot map " + path);
+        }
+        m_mapping = mapping;
+
+        const auto *base = static_cast<const char *>(m_mapping);
+        m_header = reinterpret_cast<const TreeFileHeader *>(base);
+        try
+        {
+            validate(path);
+        }
+        catch (...)
+        {
+            ::munmap(m_mapping, m_length);
+            throw;
+        }
+
+        m_view.dimension = m_header->dimension;
+        m_view.nodeCount = m_header->nodeCount;
+        m_view.entryCount = m_header->entryCount;
+        m_view.nodes = reinterpret_cast<const FlatNode *>(base + m_header->nodeTableOffset);
+        m_view.nodeBoxes = reinterpret_cast<const double *>(base + m_header->nodeBoxOffset);
+        m_view.entryBoxes = reinterpret_cast<const double *>(base + m_header->entryBoxOffset);
+        m_view.ids = reinterpret_cast<const id_type *>(base + m_header->entryIdOffset);
+    }
+
+    MappedRTree::~MappedRTree()
+    {
+        ::munmap(m_mapping, m_length);
+    }
+
+    void MappedRTree::validate(const std::string &path) const
+    {
+        const TreeFileHeader &header = *m_header;
+        if (std::memcmp(header.magic, TreeFileHeader::kMagic, sizeof(header.magic)) != 0)
+        {
+            throw std::runtime_error(path + " is not a tree file");
+        }
+        if (header.byteOrderMark != TreeFileHeader::kByteOrderMark)
+        {
+            throw std::runtime_error(path + " was written with another byte order");
+        }
+        if (header.version != TreeFileHeader::kVersion)
+        {
+            throw std::runtime_error(path + " has unsupported version " + std::to_string(header.version));
+        }
+        if (header.checksum != header.computeChecksum())
+        {
+            throw std::runtime_error(path + " has a corrupt header");
+        }
+
+        // Each section must be aligned and end where the next one may start. The lengths come from
+        // the header, so every product and sum is checked before it is trusted.
+        const uint64_t dimension = header.dimension;
+        uint64_t lengths[4];
+        if (!multiply(header.nodeCount, sizeof(FlatNode), lengths[0]) ||
+            !multiply(2 * dimension * sizeof(double), header.nodeCount, lengths[1]) ||
+            !multiply(2 * dimension * sizeof(double), header.entryCount, lengths[2]) ||
+            !multiply(header.entryCount, sizeof(id_type), lengths[3]))
+        {
+            throw std::runtime_error(path + " is truncated or has overlapping sections");
+        }
+        const uint64_t offsets[4] = {header.nodeTableOffset, header.nodeBoxOffset, header.entryBoxOffset,
+                                     header.entryIdOffset};
+        uint64_t end = sizeof(TreeFileHeader);
+        for (size_t i = 0; i < 4; ++i)
+        {
+            if (offsets[i] % TreeFileHeader::kSectionAlignment != 0 || offsets[i] < end ||
+                lengths[i] > m_length || offsets[i] > m_length - lengths[i])
+            {
+                throw std::runtime_error(path + " is truncated or has overlapping sections");
+            }
+            end = offsets[i] + lengths[i];
+        }
+        if (header.fileSize != m_length || header.nodeCount == 0 || dimension == 0)
+        {
+            throw std::runtime_error(path + " does not match the size in its header");
+        }
+
+        // The node table must be the breadth-first layout FlatTreeView walks: each internal node's
+        // children the next run of nodes, one level lower, and each leaf's entries the next run of
+        // entries. Every run then lies inside its section and every descent ends at a leaf.
+        const auto *nodes = reinterpret_cast<const FlatNode *>(static_cast<const char *>(m_mapping) +
+                                                                header.nodeTableOffset);
+        if (nodes[0].height != header.height || header.height == 0)
+        {
+            throw std::runtime_error(path + " has a corrupt node table");
+        }
+        uint64_t nextNode = 1;
+        uint64_t nextEntry = 0;
+        for (uint64_t i = 0; i < header.nodeCount; ++i)
+        {
+            const FlatNode &node = nodes[i];
+            const bool leaf = node.height == 1;
+            const uint64_t limit = leaf ? header.entryCount : header.nodeCount;
+            uint64_t &cursor = leaf ? nextEntry : nextNode;
+            // An empty node's run is never read, wherever it starts
+            if (node.height == 0 || (node.count > 0 && (node.first != cursor || node.count > limit - cursor)))
+            {
+                throw std::runtime_error(path + " has a corrupt node table");
+            }
+            cursor += node.count;
+            for (uint64_t child = node.first; !leaf && child < node.first + node.count; ++child)
+            {
+                if (child <= i || nodes[child].height != node.height - 1)
+                {
+                    throw std::runtime_error(path + " has a corrupt node table");
+                }
+            }
+        }
+        if (nextNode != header.nodeCount || nextEntry != header.entryCount)
+        {
+            throw std::runtime_error(path + " has a corrupt node table");
+        }
+    }
+
+    std::vector<id_type> MappedRTree::intersectionQuery(const Region &query) const
+    {
+        return m_view.intersectionQuery(query);
+    }
+
+    void MappedRTree::intersectionQuery(const Region &query, const std::function<void(id_type)> &visit) const
+    {
+        if (query.getDimension() != m_view.dimension)
+        {
+            return;
+        }
+        m_view.search(query.getLowCoordinates(), query.getHighCoordinates(), [&](size_t index, const double *, size_t)
+                      { visit(m_view.ids[index]); });
+    }
+
+    std::vector<id_type> MappedRTree::containmentQuery(const Region &query) const
+    {
+        return m_view.containmentQuery(query);
+    }
+
+    std::vector<id_type> MappedRTree::pointQuery(const Point &point) const
+    {
+        return m_view.pointQuery(point);
+    }
+
+    uint32_t MappedRTree::getDimension() const
+    {
+        return m_header->dimension;
+    }
+
+    uint32_t MappedRTree::getNodeCapacity() const
+    {
+        return m_header->nodeCapacity;
+    }
+
+    uint32_t MappedRTree::getHeight() const
+    {
+        return m_header->height;
+    }
+
+    uint64_t MappedRTree::size() const
+    {
+        return m_header->entryCount;
+    }
+
+    std::string MappedRTree::getSplitStrategyName() const
+    {
+        const char *name = m_header->splitStrategy;
+        return std::string(name, strnlen(name, TreeFileHeader::kStrategyNameLength));
+    }
+}
@@ -0,0 +1,66 @@
+//
+// Read-only RTree queried directly out of a memory-mapped tree file.
+//
+
+#ifndef MAPPEDRTREE_H
+#define MAPPEDRTREE_H
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "src/RTree/impl/common.h"
+#include "src/RTree/impl/storage/TreeFile.h"
+#include "src/RTree/impl/tree/FlatTreeView.h"
+
+namespace RTree
+{
+    class Point;
+    class Region;
+
+    // Maps a file written by saveTree and answers queries against the mapping itself: nothing is
+    // parsed or copied and no pointer is fixed up, so opening costs a header check and the pages
+    // a query touches are faulted in on demand. The queries only read, so any number of threads
+    // may run them at once.
+    class MappedRTree
+    {
+    public:
+        // Throws std::runtime_error when path cannot be mapped, or is not a tree file this
+        // version can read: wrong magic, version or byte order, a header checksum mismatch,
+        // sections that do not fit the file, or a node table whose runs leave their sections.
+        // The boxes themselves are not checked, a file with corrupt boxes answers wrongly.
+        explicit MappedRTree(const std::string &path);
+        ~MappedRTree();
+
+        MappedRTree(const MappedRTree &) = delete;
+        MappedRTree &operator=(const MappedRTree &) = delete;
+
+        // Ids of the entries intersecting query, contained in query, or containing point
+        std::vector<id_type> intersectionQuery(const Region &query) const;
+        std::vector<id_type> containmentQuery(const Region &query) const;
+        std::vector<id_type> pointQuery(const Point &point) const;
+
+        // Calls visit(id) for every entry intersecting query, in traversal order
+        void intersectionQuery(const Region &query, const std::function<void(id_type)> &visit) const;
+
+        uint32_t getDimension() const;
+        uint32_t getNodeCapacity() const;
+        uint32_t getHeight() const;
+        uint64_t size() const;
+        // getName() of the split strategy the tree was built with
+        std::string getSplitStrategyName() const;
+
+    private:
+        void *m_mapping = nullptr;
+        size_t m_length = 0;
+
+        const TreeFileHeader *m_header = nullptr;
+        // The sections of the mapping
+        FlatTreeView m_view;
+
+        void validate(const std::string &path) const;
+    };
+}
+
+#endif //MAPPEDRTREE_H
@@ -0,0 +1,901 @@
+#include "PagedRTree.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "src/RTree/impl/Region.h"
+#include "src/RTree/impl/pojo/Point.h"
+#include "src/RTree/impl/simd/SimdKernels.h"
+#include "src/RTree/impl/storage/TreeFile.h"
+
+namespace RTree
+{
+    namespace
+    {
+        // Content of page 0
+        struct PagedFileHeader
+        {
+            static constexpr char kMagic[8] = {'R', 'T', 'R', 'E', 'E', 'P', 'G', 'D'};
+            static constexpr uint32_t kVersion = 1;
+            static constexpr uint32_t kByteOrderMark = 0x01020304;
+
+            char magic[8];
+            uint32_t version;
+            uint32_t byteOrderMark;
+            uint32_t pageSize;
+            uint32_t dimension;
+            uint32_t capacity;
+            uint32_t height;
+            uint64_t root;
+            uint64_t pageCount;
+            uint64_t freeHead;
+            uint64_t entryCount;
+            // FNV-1a of every byte above
+            uint64_t checksum;
+
+            uint64_t computeChecksum() const
+            {
+                return fnv1a(this, offsetof(PagedFileHeader, checksum));
+            }
+        };
+
+        // Height (1 for a leaf), entry count and padding keeping the columns 8 byte aligned
+        constexpr size_t kNodeHeaderSize = 16;
+
+        uint32_t capacityFor(uint32_t dimension, uint32_t pageSize)
+        {
+            if (dimension == 0)
+            {
+                throw std::invalid_argument("Dimension must be positive");
+            }
+            const size_t perEntry = 2 * dimension * sizeof(double) + sizeof(uint64_t);
+            if (pageSize < sizeof(PagedFileHeader) || pageSize < kNodeHeaderSize + 4 * perEntry)
+            {
+                throw std::invalid_argument("Page size too small to hold 4 entries of this dimension");
+            }
+            return static_cast<uint32_t>((pageSize - kNodeHeaderSize) / perEntry);
+        }
+
+        std::vector<double> boxOf(const Region &region)
+        {
+            const uint32_t dimension = region.getDimension();
+            std::vector<double> box(2 * dimension);
+            for (uint32_t d = 0; d < dimension; ++d)
+            {
+                box[d] = region.getLow(d);
+                box[dimension + d] = region.getHigh(d);
+            }
+            return box;
+        }
+
+        double area(const double *box, uint32_t dimension)
+        {
+            double result = 1.0;
+            for (uint32_t d = 0; d < dimension; ++d)
+            {
+                result *= box[dimension + d] - box[d];
+            }
+            return result;
+        }
+
+        void combine(double *box, const double *other, uint32_t dimension)
+        {
+            for (uint32_t d = 0; d < dimension; ++d)
+            {
+                box[d] = std::min(box[d], other[d]);
+                box[dimension + d] = std::max(box[dimension + d], other[dimension + d]);
+            }
+        }
+
+        // Area box gains when combined with other
+        double enlargement(const double *box, const double *other, uint32_t dimension)
+        {
+            double combined = 1.0;
+            for (uint32_t d = 0; d < dimension; ++d)
+            {
+                combined *= std::max(box[dimension + d], other[dimension + d]) - std::min(box[d], other[d]);
+            }
+            return combined - area(box, dimension);
+        }
+
+        unsigned countTrailingZeros(uint64_t mask)
+        {
+            return static_cast<unsigned>(__builtin_ctzll(mask));
+        }
+    }
+
+    // A node page seen through its layout: header, then the MBR columns of capacity entries (all
+    // low columns, then all high columns), then capacity references
+    class PagedRTree::NodeView
+    {
+    public:
+        NodeView(char *data, uint32_t dimension, uint32_t capacity)
+            : m_header(reinterpret_cast<uint32_t *>(data)),
+              m_columns(reinterpret_cast<double *>(data + kNodeHeaderSize)),
+              m_refs(reinterpret_cast<uint64_t *>(data + kNodeHeaderSize + 2 * dimension * capacity * sizeof(double))),
+              m_dimension(dimension), m_capacity(capacity)
+        {
+        }
+
+        uint32_t height() const
+        {
+            return m_header[0];
+        }
+
+        void setHeight(uint32_t height)
+        {
+            m_header[0] = height;
+        }
+
+        bool isLeaf() const
+        {
+            return height() == 1;
+        }
+
+        uint32_t count() const
+        {
+            return m_header[1];
+        }
+
+        uint64_t ref(size_t index) const
+        {
+            return m_refs[index];
+        }
+
+        double low(uint32_t dim, size_t index) const
+        {
+            return m_columns[dim * m_capacity + index];
+        }
+
+        double high(uint32_t dim, size_t index) const
+        {
+            return m_columns[(m_dimension + dim) * m_capacity + index];
+        }
+
+        void setBox(size_t index, const double *box)
+        {
+            for (uint32_t d = 0; d < 2 * m_dimension; ++d)
+            {
+                m_columns[d * m_capacity + index] = box[d];
+            }
+        }
+
+        void growBox(size_t index, const double *box)
+        {
+            for (uint32_t d = 0; d < m_dimension; ++d)
+            {
+                double &low = m_columns[d * m_capacity + index];
+                double &high = m_columns[(m_dimension + d) * m_capacity + index];
+                low = std::min(low, box[d]);
+                high = std::max(high, box[m_dimension + d]);
+            }
+        }
+
+        void append(const double *box, uint64_t ref)
+        {
+            const uint32_t index = m_header[1]++;
+            setBox(index, box);
+            m_refs[index] = ref;
+        }
+
+        // Moves the last entry into index
+        void erase(size_t index)
+        {
+            const uint32_t last = --m_header[1];
+            if (index != last)
+            {
+                for (uint32_t d = 0; d < 2 * m_dimension; ++d)
+                {
+                    m_columns[d * m_capacity + index] = m_columns[d * m_capacity + last];
+                }
+                m_refs[index] = m_refs[last];
+            }
+        }
+
+        void clear()
+        {
+            m_header[1] = 0;
+        }
+
+        Entry entry(size_t index) const
+        {
+            Entry result{std::vector<double>(2 * m_dimension), m_refs[index]};
+            for (uint32_t d = 0; d < 2 * m_dimension; ++d)
+            {
+                result.box[d] = m_columns[d * m_capacity + index];
+            }
+            return result;
+        }
+
+        // Box covering every entry, inverted (low +inf, high -inf) when there is none
+        void mbr(double *box) const
+        {
+            for (uint32_t d = 0; d < m_dimension; ++d)
+            {
+                const double *lows = m_columns + d * m_capacity;
+                const double *highs = m_columns + (m_dimension + d) * m_capacity;
+                box[d] = std::numeric_limits<double>::infinity();
+                box[m_dimension + d] = -std::numeric_limits<double>::infinity();
+                for (uint32_t i = 0; i < count(); ++i)
+                {
+                    box[d] = std::min(box[d], lows[i]);
+                    box[m_dimension + d] = std::max(box[m_dimension + d], highs[i]);
+                }
+            }
+        }
+
+        // Calls visit(i) for every entry whose box intersects box, in index order
+        template <typename Visit>
+        void forEachIntersecting(const double *box, Visit &&visit) const
+        {
+            const double *lows = m_columns;
+            const double *highs = m_columns + m_dimension * m_capacity;
+            for (size_t base = 0; base < count(); base += 64)
+            {
+                uint64_t mask = simd::intersectMask(lows + base, highs + base, m_capacity, m_dimension, box,
+                                                    box + m_dimension, std::min<size_t>(64, count() - base));
+                while (mask != 0)
+                {
+                    visit(base + countTrailingZeros(mask));
+                    mask &= mask - 1;
+                }
+            }
+        }
+
+        const double *lows() const
+        {
+            return m_columns;
+        }
+
+        const double *highs() const
+        {
+            return m_columns + m_dimension * m_capacity;
+        }
+
+    private:
+        uint32_t *m_header;
+        double *m_columns;
+        uint64_t *m_refs;
+        uint32_t m_dimension;
+        uint32_t m_capacity;
+    };
+
+    PagedRTree::PagedRTree(const std::string &path, uint32_t dimension, size_t bufferPoolBytes, uint32_t pageSize)
+        : m_dimension(dimension), m_capacity(capacityFor(dimension, pageSize)), m_pageSize(pageSize),
+          m_pool(path, true, pageSize, bufferPoolBytes)
+    {
+        // Page 0 holds the metadata, page 1 the empty root leaf
+        BufferPool::Page root = m_pool.create(m_root);
+        NodeView(root.data(), m_dimension, m_capacity).setHeight(1);
+        storeMetadata();
+    }
+
+    PagedRTree::PagedRTree(const std::string &path, size_t bufferPoolBytes)
+        : m_pageSize(readPageSize(path)), m_pool(path, false, m_pageSize, bufferPoolBytes)
+    {
+        loadMetadata();
+    }
+
+    PagedRTree::~PagedRTree()
+    {
+        try
+        {
+            storeMetadata();
+        }
+        catch (const std::runtime_error &)
+        {
+            // Destructors must not throw; call flush() first to see write errors
+        }
+    }
+
+    uint32_t PagedRTree::readPageSize(const std::string &path)
+    {
+        PagedFileHeader header{};
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw std::runtime_error("Cannot open " + path);
+        }
+        const ssize_t read = ::pread(fd, &header, sizeof(header), 0);
+        ::close(fd);
+
+        if (read != static_cast<ssize_t>(sizeof(header)) ||
+            std::memcmp(header.magic, PagedFileHeader::kMagic, sizeof(header.magic)) != 0)
+        {
+            throw std::runtime_error(path + " is not a paged tree file");
+        }
+        if (header.byteOrderMark != PagedFileHeader::kByteOrderMark)
+        {
+            throw std::runtime_error(path + " was written with another byte order");
+        }
+        if (header.version != PagedFileHeader::kVersion)
+        {
+            throw std::runtime_error(path + " has unsupported version " + std::to_string(header.version));
+        }
+        if (header.checksum != header.computeChecksum())
+        {
+            throw std::runtime_error(path + " has a corrupt header");
+        }
+        if (header.capacity != capacityFor(header.dimension, header.pageSize))
+        {
+            throw std::runtime_error(path + " has a node capacity not matching its page size");
+        }
+        return header.pageSize;
+    }
+
+    void PagedRTree::loadMetadata()
+    {
+        PagedFileHeader header{};
+        {
+            BufferPool::Page page = m_pool.fetch(0);
+            std::memcpy(&header, page.data(), sizeof(header));
+        }
+        m_dimension = header.dimension;
+        m_capacity = header.capacity;
+        m_root = header.root;
+        m_height = header.height;
+        m_pageCount = header.pageCount;
+        m_freeHead = header.freeHead;
+        m_entryCount = header.entryCount;
+    }
+
+    void PagedRTree::storeMetadata()
+    {
+        PagedFileHeader header{};
+        std::memcpy(header.magic, PagedFileHeader::kMagic, sizeof(header.magic));
+        header.version = PagedFileHeader::kVersion;
+        header.byteOrderMark = PagedFileHeader::kByteOrderMark;
+        header.pageSize = m_pageSize;
+        header.dimension = m_dimension;
+        header.capacity = m_capacity;
+        header.height = m_height;
+        header.root = m_root;
+        header.pageCount = m_pageCount;
+        header.freeHead = m_freeHead;
+        header.entryCount = m_entryCount;
+        header.checksum = header.computeChecksum();
+
+        BufferPool::Page page = m_pool.create(0);
+        std::memcpy(page.data(), &header, sizeof(header));
+    }
+
+    void PagedRTree::flush()
+    {
+        storeMetadata();
+        m_pool.flush();
+    }
+
+    uint64_t PagedRTree::allocatePage()
+    {
+        if (m_freeHead == 0)
+        {
+            return m_pageCount++;
+        }
+
+        const uint64_t page = m_freeHead;
+        BufferPool::Page free = m_pool.fetch(page);
+        std::memcpy(&m_freeHead, free.data(), sizeof(m_freeHead));
+        return page;
+    }
+
+    void PagedRTree::freePage(uint64_t page)
+    {
+        BufferPool::Page freed = m_pool.create(page);
+        std::memcpy(freed.data(), &m_freeHead, sizeof(m_freeHead));
+        m_freeHead = page;
+    }
+
+    size_t PagedRTree::chooseSubtree(const NodeView &node, const double *box) const
+    {
+        constexpr size_t kBlock = 64;
+        double areas[kBlock];
+        double enlargements[kBlock];
+        double minEnlargement = std::numeric_limits<double>::max();
+        double bestArea = std::numeric_limits<double>::max();
+        size_t best = 0;
+
+        for (size_t base = 0; base < node.count(); base += kBlock)
+        {
+            const size_t count = std::min<size_t>(kBlock, node.count() - base);
+            simd::areaEnlargements(node.lows() + base, node.highs() + base, m_capacity, m_dimension, box,
+                                   box + m_dimension, count, areas, enlargements);
+            for (size_t j = 0; j < count; ++j)
+            {
+                if (base + j == 0 || enlargements[j] < minEnlargement ||
+                    (enlargements[j] == minEnlargement && areas[j] < bestArea))
+                {
+                    minEnlargement = enlargements[j];
+                    bestArea = areas[j];
+                    best = base + j;
+                }
+            }
+        }
+        return best;
+    }
+
+    PagedRTree::Entry PagedRTree::split(NodeView &node, const Entry &extra)
+    {
+        std::vector<Entry> entries;
+        entries.reserve(node.count() + 1);
+        for (size_t i = 0; i < node.count(); ++i)
+        {
+            entries.push_back(node.entry(i));
+        }
+        entries.push_back(extra);
+
+        // Quadratic seeds: the pair wasting the most area when put in one node
+        size_t seeds[2] = {0, 1};
+        double worstWaste = -std::numeric_limits<double>::infinity();
+        std::vector<double> combined(2 * m_dimension);
+        for (size_t i = 0; i < entries.size(); ++i)
+        {
+            for (size_t j = i + 1; j < entries.size(); ++j)
+            {
+                combined = entries[i].box;
+                combine(combined.data(), entries[j].box.data(), m_dimension);
+                const double waste = area(combined.data(), m_dimension) - area(entries[i].box.data(), m_dimension) -
+                                     area(entries[j].box.data(), m_dimension);
+                if (waste > worstWaste)
+                {
+                    worstWaste = waste;
+                    seeds[0] = i;
+                    seeds[1] = j;
+                }
+            }
+        }
+
+        std::vector<size_t> groups[2] = {{seeds[0]}, {seeds[1]}};
+        std::vector<double> groupBoxes[2] = {entries[seeds[0]].box, entries[seeds[1]].box};
+        std::vector<bool> assigned(entries.size(), false);
+        assigned[seeds[0]] = assigned[seeds[1]] = true;
+        size_t remaining = entries.size() - 2;
+        const size_t minFill = std::max<size_t>(1, m_capacity * 2 / 5);
+
+        auto assign = [&](size_t entry, int group)
+        {
+            groups[group].push_back(entry);
+            combine(groupBoxes[group].data(), entries[entry].box.data(), m_dimension);
+            assigned[entry] = true;
+            --remaining;
+        };
+
+        while (remaining > 0)
+        {
+            // A group that needs every remaining entry to reach the minimum fill takes them all
+            for (int group = 0; group < 2; ++group)
+            {
+                if (groups[group].size() + remaining <= minFill)
+                {
+                    for (size_t i = 0; i < entries.size(); ++i)
+                    {
+                        if (!assigned[i])
+                        {
+                            assign(i, group);
+                        }
+                    }
+                }
+            }
+            if (remaining == 0)
+            {
+                break;
+            }
+
+            // Next the entry with the strongest preference for one group
+            size_t next = 0;
+            double strongest = -1;
+            double growth[2] = {0, 0};
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                if (assigned[i])
+                {
+                    continue;
+                }
+                const double first = enlargement(groupBoxes[0].data(), entries[i].box.data(), m_dimension);
+                const double second = enlargement(groupBoxes[1].data(), entries[i].box.data(), m_dimension);
+                if (std::abs(first - second) > strongest)
+                {
+                    strongest = std::abs(first - second);
+                    next = i;
+                    growth[0] = first;
+                    growth[1] = second;
+                }
+            }
+
+            int group;
+            if (growth[0] != growth[1])
+            {
+                group = growth[0] < growth[1] ? 0 : 1;
+            }
+            else
+            {
+                const double areas[2] = {area(groupBoxes[0].data(), m_dimension),
+                                         area(groupBoxes[1].data(), m_dimension)};
+                group = areas[0] != areas[1] ? (areas[0] < areas[1] ? 0 : 1)
+                                             : (groups[0].size() <= groups[1].size() ? 0 : 1);
+            }
+            assign(next, group);
+        }
+
+        node.clear();
+        for (size_t i : groups[0])
+        {
+            node.append(entries[i].box.data(), entries[i].ref);
+        }
+
+        const uint64_t siblingPage = allocatePage();
+        BufferPool::Page page = m_pool.create(siblingPage);
+        NodeView sibling(page.data(), m_dimension, m_capacity);
+        sibling.setHeight(node.height());
+        for (size_t i : groups[1])
+        {
+            sibling.append(entries[i].box.data(), entries[i].ref);
+        }
+        return Entry{groupBoxes[1], siblingPage};
+    }
+
+    void PagedRTree::insert(const Region &mbr, id_type id)
+    {
+        if (mbr.getDimension() != m_dimension)
+        {
+            throw std::invalid_argument("Dimensions do not match");
+        }
+        const std::vector<double> box = boxOf(mbr);
+
+        std::vector<PathStep> path;
+        uint64_t page = m_root;
+        for (uint32_t height = m_height; height > 1; --height)
+        {
+            BufferPool::Page current = m_pool.fetch(page);
+            NodeView node(current.data(), m_dimension, m_capacity);
+            const size_t index = chooseSubtree(node, box.data());
+            path.push_back({page, static_cast<uint32_t>(index)});
+            page = node.ref(index);
+        }
+
+        // Add entry to the node on page, splitting it when full; a split hands the parent an
+        // entry for the new sibling, otherwise the ancestors only have to grow
+        Entry entry{box, static_cast<uint64_t>(id)};
+        std::vector<double> nodeBox(2 * m_dimension);
+        while (true)
+        {
+            bool splitNode;
+            Entry sibling;
+            {
+                BufferPool::Page current = m_pool.fetch(page);
+                current.markDirty();
+                NodeView node(current.data(), m_dimension, m_capacity);
+                splitNode = node.count() == m_capacity;
+                if (splitNode)
+                {
+                    sibling = split(node, entry);
+                }
+                else
+                {
+                    node.append(entry.box.data(), entry.ref);
+                }
+                node.mbr(nodeBox.data());
+            }
+
+            if (path.empty())
+            {
+                if (splitNode)
+                {
+                    const uint64_t rootPage = allocatePage();
+                    BufferPool::Page current = m_pool.create(rootPage);
+                    NodeView root(current.data(), m_dimension, m_capacity);
+                    root.setHeight(m_height + 1);
+                    root.append(nodeBox.data(), m_root);
+                    root.append(sibling.box.data(), sibling.ref);
+                    m_root = rootPage;
+                    ++m_height;
+                }
+                break;
+            }
+
+            const PathStep step = path.back();
+            path.pop_back();
+            {
+                BufferPool::Page parent = m_pool.fetch(step.page);
+                parent.markDirty();
+                NodeView(parent.data(), m_dimension, m_capacity).setBox(step.index, nodeBox.data());
+            }
+            if (!splitNode)
+            {
+                for (; !path.empty(); path.pop_back())
+                {
+                    BufferPool::Page ancestor = m_pool.fetch(path.back().page);
+                    ancestor.markDirty();
+                    NodeView(ancestor.data(), m_dimension, m_capacity).growBox(path.back().index, box.data());
+                }
+                break;
+            }
+            entry = std::move(sibling);
+            page = step.page;
+        }
+        ++m_entryCount;
+    }
+
+    bool PagedRTree::locate(uint64_t page, uint32_t height, const double *box, id_type id,
+                            std::vector<PathStep> &path)
+    {
+        // The page is released before descending, so only one page of the path is pinned at a time
+        std::vector<std::pair<uint32_t, uint64_t>> candidates;
+        {
+            BufferPool::Page current = m_pool.fetch(page);
+            NodeView node(current.data(), m_dimension, m_capacity);
+            if (height == 1)
+            {
+                for (uint32_t i = 0; i < node.count(); ++i)
+                {
+                    if (node.ref(i) == static_cast<uint64_t>(id))
+                    {
+                        path.push_back({page, i});
+                        return true;
+                    }
+                }
+                return false;
+            }
+            node.forEachIntersecting(box, [&](size_t i)
+                                     { candidates.emplace_back(static_cast<uint32_t>(i), node.ref(i)); });
+        }
+
+        for (const auto &[index, child] : candidates)
+        {
+            path.push_back({page, index});
+            if (locate(child, height - 1, box, id, path))
+            {
+                return true;
+            }
+            path.pop_back();
+        }
+        return false;
+    }
+
+    bool PagedRTree::remove(const Region &mbr, id_type id)
+    {
+        if (mbr.getDimension() != m_dimension)
+        {
+            return false;
+        }
+        const std::vector<double> box = boxOf(mbr);
+
+        // path ends with the leaf and the entry's index in it
+        std::vector<PathStep> path;
+        if (!locate(m_root, m_height, box.data(), id, path))
+        {
+            return false;
+        }
+
+        // Erase the entry, then walk up freeing nodes left empty and refitting their parents
+        std::vector<double> nodeBox(2 * m_dimension);
+        PathStep step = path.back();
+        path.pop_back();
+        while (true)
+        {
+            bool empty;
+            {
+                BufferPool::Page current = m_pool.fetch(step.page);
+                current.markDirty();
+                NodeView node(current.data(), m_dimension, m_capacity);
+                node.erase(step.index);
+                empty = node.count() == 0;
+                node.mbr(nodeBox.data());
+            }
+            if (path.empty() || !empty)
+            {
+                break;
+            }
+            freePage(step.page);
+            step = path.back();
+            path.pop_back();
+        }
+        for (; !path.empty(); path.pop_back())
+        {
+            BufferPool::Page ancestor = m_pool.fetch(path.back().page);
+            ancestor.markDirty();
+            NodeView node(ancestor.data(), m_dimension, m_capacity);
+            node.setBox(path.back().index, nodeBox.data());
+            node.mbr(nodeBox.data());
+        }
+        --m_entryCount;
+
+        // A root with one child is replaced by it, one with none becomes an empty leaf
+        while (m_height > 1)
+        {
+            uint64_t child;
+            {
+                BufferPool::Page current = m_pool.fetch(m_root);
+                NodeView root(current.data(), m_dimension, m_capacity);
+                if (root.count() == 0)
+                {
+                    current.markDirty();
+                    root.setHeight(1);
+                    m_height = 1;
+                    break;
+                }
+                if (root.count() > 1)
+                {
+                    break;
+                }
+                child = root.ref(0);
+            }
+            freePage(m_root);
+            m_root = child;
+            --m_height;
+        }
+        return true;
+    }
+
+    template <typename Visit>
+    void PagedRTree::search(const double *box, Visit &&visit)
+    {
+        std::vector<uint64_t> stack{m_root};
+        while (!stack.empty())
+        {
+            BufferPool::Page current = m_pool.fetch(stack.back());
+            stack.pop_back();
+            NodeView node(current.data(), m_dimension, m_capacity);
+            if (node.isLeaf())
+            {
+                node.forEachIntersecting(box, [&](size_t i)
+                                         { visit(node, i); });
+                continue;
+            }
+
+            node.forEachIntersecting(box, [&](size_t i)
+                                     {
+                                         stack.push_back(node.ref(i));
+                                         if (m_prefetch)
+                                         {
+                                             m_pool.prefetch(node.ref(i));
+                                         }
+                                     });
+        }
+    }
+
+    std::vector<id_type> PagedRTree::intersectionQuery(const Region &query)
+    {
+        std::vector<id_type> result;
+        if (query.getDimension() != m_dimension)
+        {
+            return result;
+        }
+        const std::vector<double> box = boxOf(query);
+        search(box.data(), [&result](const NodeView &leaf, size_t i)
+               { result.push_back(static_cast<id_type>(leaf.ref(i))); });
+        return result;
+    }
+
+    std::vector<id_type> PagedRTree::containmentQuery(const Region &query)
+    {
+        std::vector<id_type> result;
+        if (query.getDimension() != m_dimension)
+        {
+            return result;
+        }
+        const std::vector<double> box = boxOf(query);
+        search(box.data(), [&](const NodeView &leaf, size_t i)
+               {
+                   for (uint32_t d = 0; d < m_dimension; ++d)
+                   {
+                       if (leaf.low(d, i) < box[d] || leaf.high(d, i) > box[m_dimension + d])
+                       {
+                           return;
+                       }
+                   }
+                   result.push_back(static_cast<id_type>(leaf.ref(i)));
+               });
+        return result;
+    }
+
+    std::vector<id_type> PagedRTree::pointQuery(const Point &point)
+    {
+        std::vector<id_type> result;
+        if (point.getDimension() != m_dimension)
+        {
+            return result;
+        }
+        // Intersecting a degenerate box is containing the point
+        std::vector<double> box(point.getCoordinates(), point.getCoordinates() + m_dimension);
+        box.insert(box.end(), point.getCoordinates(), point.getCoordinates() + m_dimension);
+        search(box.data(), [&result](const NodeView &leaf, size_t i)
+               { result.push_back(static_cast<id_type>(leaf.ref(i))); });
+        return result;
+    }
+
+    std::vector<id_type> PagedRTree::nearestNeighbors(const Point &point, uint32_t k)
+    {
+        std::vector<id_type> result;
+        if (point.getDimension() != m_dimension || k == 0)
+        {
+            return result;
+        }
+
+        // Best first: an entry popped is nearer than anything still queued
+        struct Candidate
+        {
+            double distance;
+            uint64_t ref;
+            bool entry;
+
+            bool operator>(const Candidate &other) const
+            {
+                return distance > other.distance || (distance == other.distance && !entry && other.entry);
+            }
+        };
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> queue;
+        queue.push({0.0, m_root, false});
+
+        const double *coords = point.getCoordinates();
+        while (!queue.empty() && result.size() < k)
+        {
+            const Candidate next = queue.top();
+            queue.pop();
+            if (next.entry)
+            {
+                result.push_back(static_cast<id_type>(next.ref));
+                continue;
+            }
+
+            BufferPool::Page current = m_pool.fetch(next.ref);
+            NodeView node(current.data(), m_dimension, m_capacity);
+            for (uint32_t i = 0; i < node.count(); ++i)
+            {
+                double distance = 0.0;
+                for (uint32_t d = 0; d < m_dimension; ++d)
+                {
+                    const double gap = std::max({node.low(d, i) - coords[d], 0.0, coords[d] - node.high(d, i)});
+                    distance += gap * gap;
+                }
+                queue.push({distance, node.ref(i), node.isLeaf()});
+            }
+        }
+        return result;
+    }
+
+    void PagedRTree::setPrefetch(bool prefetch)
+    {
+        m_prefetch = prefetch;
+    }
+
+    uint32_t PagedRTree::getDimension() const
+    {
+        return m_dimension;
+    }
+
+    uint32_t PagedRTree::getNodeCapacity() const
+    {
+        return m_capacity;
+    }
+
+    uint32_t PagedRTree::getHeight() const
+    {
+        return m_height;
+    }
+
+    uint64_t PagedRTree::size() const
+    {
+        return m_entryCount;
+    }
+
+    uint64_t PagedRTree::getPageCount() const
+    {
+        return m_pageCount;
+    }
+
+    const BufferPool::Stats &PagedRTree::getIOStats() const
+    {
+        return m_pool.getStats();
+    }
+
+    void PagedRTree::resetIOStats()
+    {
+        m_pool.resetStats();
+    }
+}
@@ -0,0 +1,122 @@
+//
+// RTree whose nodes are fixed-size pages of a file, cached in a BufferPool.
+//
+
+#ifndef PAGEDRTREE_H
+#define PAGEDRTREE_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "src/RTree/impl/common.h"
+#include "src/RTree/impl/storage/BufferPool.h"
+
+namespace RTree
+{
+    class Point;
+    class Region;
+
+    // For trees larger than memory. Page 0 of the file holds the tree's metadata, every other
+    // page one node (or nothing, when freed and waiting for reuse), and nodes refer to their
+    // children by page number. A node page is a small header followed by the MBR columns of its
+    // entries, laid out as in MBRColumns, and their references: child page numbers in internal
+    // nodes, entry ids in leaves. The node capacity is whatever fits a page.
+    //
+    // Only the pages a call touches are in memory, in a BufferPool of the given budget; the rest
+    // of the tree stays in the file. Inserts choose subtrees and split full nodes as Guttman's
+    // quadratic RTree does (SplitStrategy works on heap nodes, not pages); removes drop emptied
+    // nodes and shorten the root. Changes reach the file when their pages are evicted, on
+    // flush() and on destruction. Not thread safe.
+    class PagedRTree
+    {
+    public:
+        // Creates an empty tree in path, replacing any file there
+        PagedRTree(const std::string &path, uint32_t dimension, size_t bufferPoolBytes, uint32_t pageSize = 4096);
+        // Opens the tree in path. Throws std::runtime_error if it is not a paged tree file.
+        PagedRTree(const std::string &path, size_t bufferPoolBytes);
+        // Writes the metadata, leaving the dirty pages to the buffer pool; errors are ignored
+        ~PagedRTree();
+
+        PagedRTree(const PagedRTree &) = delete;
+        PagedRTree &operator=(const PagedRTree &) = delete;
+
+        void insert(const Region &mbr, id_type id);
+        bool remove(const Region &mbr, id_type id);
+
+        std::vector<id_type> intersectionQuery(const Region &query);
+        std::vector<id_type> containmentQuery(const Region &query);
+        std::vector<id_type> pointQuery(const Point &point);
+        // The k entries nearest to point, nearest first, measured as RTree::nearestNeighbors does
+        std::vector<id_type> nearestNeighbors(const Point &point, uint32_t k);
+
+        // Writes the metadata and every dirty page to the file
+        void flush();
+
+        // When set, searches hint the kernel to read the uncached children they are about to
+        // visit, so the reads overlap instead of each waiting in turn
+        void setPrefetch(bool prefetch);
+
+        uint32_t getDimension() const;
+        uint32_t getNodeCapacity() const;
+        uint32_t getHeight() const;
+        uint64_t size() const;
+        // Pages in the file, the metadata page and free pages included
+        uint64_t getPageCount() const;
+
+        // Page reads, writes and cache hits since construction or the last reset
+        const BufferPool::Stats &getIOStats() const;
+        void resetIOStats();
+
+    private:
+        // Entry of a node: box as all low bounds then all high bounds, and a child page or id
+        struct Entry
+        {
+            std::vector<double> box;
+            uint64_t ref;
+        };
+
+        // Node visited on the way down to a leaf, and which of its entries was followed
+        struct PathStep
+        {
+            uint64_t page;
+            uint32_t index;
+        };
+
+        class NodeView;
+
+        uint32_t m_dimension;
+        uint32_t m_capacity;
+        uint32_t m_pageSize;
+        uint64_t m_root = 1;
+        uint32_t m_height = 1;
+        uint64_t m_pageCount = 2;
+        // First page of the free list, 0 when empty; each free page holds the next one's number
+        uint64_t m_freeHead = 0;
+        uint64_t m_entryCount = 0;
+        bool m_prefetch = false;
+        BufferPool m_pool;
+
+        static uint32_t readPageSize(const std::string &path);
+        void loadMetadata();
+        void storeMetadata();
+
+        uint64_t allocatePage();
+        void freePage(uint64_t page);
+
+        // Entry of node to follow to insert box: least enlargement, then least area
+        size_t chooseSubtree(const NodeView &node, const double *box) const;
+        // Splits node's entries plus extra between node and a new page of the same height,
+        // returning the new page's entry for the parent
+        Entry split(NodeView &node, const Entry &extra);
+
+        // Path from page down to the leaf holding id, ending with the entry's index in that leaf
+        bool locate(uint64_t page, uint32_t height, const double *box, id_type id, std::vector<PathStep> &path);
+
+        // Calls visit(leaf, index) for every entry intersecting box (all low bounds, then all high)
+        template <typename Visit>
+        void search(const double *box, Visit &&visit);
+    };
+}
+
+#endif //PAGEDRTREE_H
@@ -0,0 +1,120 @@
+#include "TreeFile.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include "src/RTree/impl/tree/FlatTreeView.h"
+#include "src/RTree/impl/tree/FrozenRTree.h"
+#include "src/RTree/impl/tree/RTree.h"
+
+namespace RTree
+{
+    static_assert(sizeof(TreeFileHeader) == 128, "TreeFileHeader layout changed");
+    static_assert(sizeof(FlatNode) == 16, "FlatNode layout changed");
+
+    uint64_t fnv1a(const void *data, size_t size)
+    {
+        const auto *bytes = static_cast<const unsigned char *>(data);
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    uint64_t TreeFileHeader::computeChecksum() const
+    {
+        return fnv1a(this, offsetof(TreeFileHeader, checksum));
+    }
+
+    namespace
+    {
+        uint64_t align(uint64_t offset)
+        {
+            const uint64_t alignment = TreeFileHeader::kSectionAlignment;
+            return (offset + alignment - 1) / alignment * alignment;
+        }
+
+        class SectionWriter
+        {
+        public:
+            explicit SectionWriter(std::ofstream &out) : m_out(out)
+            {
+            }
+
+            void write(const void *data, size_t size)
+            {
+                m_out.write(static_cast<const char *>(data), static_cast<std::streamsize>(size));
+                m_written += size;
+            }
+
+            void padTo(uint64_t offset)
+            {
+                static const char zeros[TreeFileHeader::kSectionAlignment] = {};
+                write(zeros, offset - m_written);
+            }
+
+        private:
+            std::ofstream &m_out;
+            uint64_t m_written = 0;
+        };
+    }
+
+    void saveTree(const FrozenRTree &tree, const std::string &path)
+    {
+        if (tree.getEncoding() != BoxEncoding::Exact)
+        {
+            throw std::invalid_argument("Tree files hold exact node boxes only");
+        }
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            throw std::runtime_error("Cannot open " + path + " for writing");
+        }
+
+        const FlatTreeView view = tree.view();
+        const uint32_t dimension = view.dimension;
+        TreeFileHeader header{};
+        std::memcpy(header.magic, TreeFileHeader::kMagic, sizeof(header.magic));
+        header.version = TreeFileHeader::kVersion;
+        header.byteOrderMark = TreeFileHeader::kByteOrderMark;
+        header.dimension = dimension;
+        header.nodeCapacity = tree.getNodeCapacity();
+        header.height = tree.getHeight();
+        header.nodeCount = view.nodeCount;
+        header.entryCount = view.entryCount;
+        header.nodeTableOffset = align(sizeof(TreeFileHeader));
+        header.nodeBoxOffset = align(header.nodeTableOffset + view.nodeCount * sizeof(FlatNode));
+        header.entryBoxOffset = align(header.nodeBoxOffset + 2 * dimension * view.nodeCount * sizeof(double));
+        header.entryIdOffset = align(header.entryBoxOffset + 2 * dimension * view.entryCount * sizeof(double));
+        header.fileSize = header.entryIdOffset + view.entryCount * sizeof(id_type);
+        const std::string &name = tree.getSplitStrategyName();
+        std::memcpy(header.splitStrategy, name.data(), std::min(name.size(), TreeFileHeader::kStrategyNameLength - 1));
+        header.checksum = header.computeChecksum();
+
+        SectionWriter writer(out);
+        writer.write(&header, sizeof(header));
+        writer.padTo(header.nodeTableOffset);
+        writer.write(view.nodes, view.nodeCount * sizeof(FlatNode));
+        writer.padTo(header.nodeBoxOffset);
+        writer.write(view.nodeBoxes, 2 * dimension * view.nodeCount * sizeof(double));
+        writer.padTo(header.entryBoxOffset);
+        writer.write(view.entryBoxes, 2 * dimension * view.entryCount * sizeof(double));
+        writer.padTo(header.entryIdOffset);
+        writer.write(view.ids, view.entryCount * sizeof(id_type));
+
+        out.flush();
+        if (!out)
+        {
+            throw std::runtime_error("Cannot write " + path);
+        }
+    }
+
+    void saveTree(const RTree &tree, const std::string &path)
+    {
+        saveTree(tree.freeze(), path);
+    }
+}
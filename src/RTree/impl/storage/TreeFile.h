@@ -0,0 +1,71 @@
+//
+// On-disk format of a whole RTree, laid out to be queried in place once mapped.
+//
+
+#ifndef TREEFILE_H
+#define TREEFILE_H
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace RTree
+{
+    class FrozenRTree;
+    class RTree;
+
+    // A tree file is a header followed by four sections, each starting on a 64 byte boundary:
+    //
+    //   node table    nodeCount FlatNode records, in breadth-first order with the root first
+    //   node boxes    MBR of every node, 2 * dimension doubles each, packed run by run of
+    //                 siblings as FlatTreeView describes
+    //   entry boxes   MBR of every entry, the same way, one run per leaf
+    //   entry ids     entryCount id_type values
+    //
+    // The sections are the arrays of a FrozenRTree written out as they are, so a mapped file is
+    // queried through the same FlatTreeView. Version 1 files, whose box columns spanned the
+    // whole tree instead of one run, are no longer read.
+    //
+    // Values are in the byte order of the machine that wrote the file; a file from a machine of
+    // the other order is rejected when opened, as is one whose header checksum does not match.
+    struct TreeFileHeader
+    {
+        static constexpr char kMagic[8] = {'R', 'T', 'R', 'E', 'E', 'M', 'A', 'P'};
+        static constexpr uint32_t kVersion = 2;
+        static constexpr uint32_t kByteOrderMark = 0x01020304;
+        static constexpr size_t kSectionAlignment = 64;
+        static constexpr size_t kStrategyNameLength = 32;
+
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrderMark;
+        uint32_t dimension;
+        uint32_t nodeCapacity;
+        uint32_t height;
+        uint32_t reserved;
+        uint64_t nodeCount;
+        uint64_t entryCount;
+        uint64_t nodeTableOffset;
+        uint64_t nodeBoxOffset;
+        uint64_t entryBoxOffset;
+        uint64_t entryIdOffset;
+        uint64_t fileSize;
+        // getName() of the split strategy, zero padded
+        char splitStrategy[kStrategyNameLength];
+        // FNV-1a of every byte above
+        uint64_t checksum;
+
+        uint64_t computeChecksum() const;
+    };
+
+    // 64-bit FNV-1a of size bytes, the checksum of the storage file headers
+    uint64_t fnv1a(const void *data, size_t size);
+
+    // Writes tree to path in the format above, replacing any existing file.
+    // Throws std::runtime_error when the file cannot be written, and std::invalid_argument when
+    // tree's node boxes are quantized.
+    void saveTree(const FrozenRTree &tree, const std::string &path);
+    // Same, freezing tree first
+    void saveTree(const RTree &tree, const std::string &path);
+}
+
+#endif //TREEFILE_H
@@ -1,5 +1,9 @@
 #include "QuadraticSplitStrategy.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "src/RTree/impl/node/Node.h"
 
 namespace RTree
@@ -222,7 +226,8 @@ namespace RTree
     {
         size_t seed1 = 0;
         size_t seed2 = 0;
-        double maxWastedArea = -1.0;
+        // Overlapping regions waste a negative area, any pair must still beat none
+        double maxWastedArea = -std::numeric_limits<double>::max();
 
         // Find the best two seed entries
         for (size_t i = 0; i < entries.size(); ++i)
@@ -256,7 +261,8 @@ namespace RTree
     {
         size_t seed1 = 0;
         size_t seed2 = 0;
-        double maxWastedArea = -1.0;
+        // Overlapping regions waste a negative area, any pair must still beat none
+        double maxWastedArea = -std::numeric_limits<double>::max();
 
         // Find the best two seed nodes
         for (size_t i = 0; i < children.size(); ++i)
@@ -1,5 +1,9 @@
 #include "RStarSplitStrategy.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 #include "src/RTree/impl/node/Node.h"
 
 namespace RTree
@@ -333,7 +337,8 @@ namespace RTree
     {
         size_t seed1 = 0;
         size_t seed2 = 0;
-        double maxWastedArea = -1.0;
+        // Overlapping regions waste a negative area, any pair must still beat none
+        double maxWastedArea = -std::numeric_limits<double>::max();
         for (size_t i = 0; i < entries.size(); ++i)
         {
             const Region &region1 = entries[i]->getRegion();
@@ -4,6 +4,7 @@
 
 #ifndef SPLITSTRATEGY_H
 #define SPLITSTRATEGY_H
+#include <string>
 #include <vector>
 
 #include "src/RTree/impl/Data.h"
@@ -0,0 +1,417 @@
+#include "ConcurrentRTree.h"
+#include <algorithm>
+#include <chrono>
+
+#include "src/RTree/impl/Data.h"
+#include "src/RTree/impl/Visitor.h"
+#include "src/RTree/impl/node/InternalNode.h"
+#include "src/RTree/impl/node/LeafNode.h"
+#include "src/RTree/impl/pojo/Point.h"
+
+namespace RTree
+{
+    namespace
+    {
+        using ExclusiveLatch = std::unique_lock<std::shared_mutex>;
+        using SharedLatch = std::shared_lock<std::shared_mutex>;
+
+        // Collects ids, or forwards to another visitor, remembering whether anything matched
+        template <typename Predicate>
+        class MatchVisitor : public Visitor
+        {
+        public:
+            MatchVisitor(Visitor *visitor, std::vector<id_type> *ids, Predicate predicate)
+                : m_visitor(visitor), m_ids(ids), m_predicate(predicate) {}
+
+            void visitData(Data *data) override
+            {
+                if (!m_predicate(data))
+                {
+                    return;
+                }
+                m_found = true;
+                if (m_visitor != nullptr)
+                {
+                    m_visitor->visitData(data);
+                }
+                if (m_ids != nullptr)
+                {
+                    m_ids->push_back(data->getIdentifier());
+                }
+            }
+
+            bool found() const
+            {
+                return m_found;
+            }
+
+        private:
+            Visitor *m_visitor;
+            std::vector<id_type> *m_ids;
+            Predicate m_predicate;
+            bool m_found = false;
+        };
+
+        template <typename Predicate>
+        MatchVisitor<Predicate> makeMatchVisitor(Visitor *visitor, std::vector<id_type> *ids, Predicate predicate)
+        {
+            return MatchVisitor<Predicate>(visitor, ids, predicate);
+        }
+
+        // True when region lies strictly inside mbr on every axis: removing it cannot shrink mbr,
+        // and a node with that MBR keeps other entries once it is gone
+        bool strictlyInside(const Region &region, const Region &mbr)
+        {
+            if (region.getDimension() != mbr.getDimension())
+            {
+                return false;
+            }
+            for (uint32_t d = 0; d < mbr.getDimension(); ++d)
+            {
+                if (region.getLow(d) <= mbr.getLow(d) || region.getHigh(d) >= mbr.getHigh(d))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        long long microsecondsSince(std::chrono::high_resolution_clock::time_point startTime)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::high_resolution_clock::now() - startTime)
+                .count();
+        }
+    }
+
+    ConcurrentRTree::ConcurrentRTree(uint32_t dimension, uint32_t nodeCapacity, const SplitStrategy *splitStrategy)
+        : m_tree(dimension, nodeCapacity, splitStrategy)
+    {
+    }
+
+    RTree &ConcurrentRTree::getTree()
+    {
+        return m_tree;
+    }
+
+    void ConcurrentRTree::insert(const Region &mbr, id_type id)
+    {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        Data *data = m_tree.createData(mbr, id);
+        const Region &region = data->getRegion();
+        const uint32_t capacity = m_tree.m_nodeCapacity;
+
+        // Grows a node's own MBR to cover the new entry. Only done while the node's parent is
+        // latched too, since a parent splitting reads its children's MBRs.
+        auto grow = [&region](Node *node) -> const Region &
+        {
+            Region &nodeMBR = node->isLeaf() ? static_cast<LeafNode *>(node)->m_mbr
+                                             : static_cast<InternalNode *>(node)->m_mbr;
+            if (nodeMBR.getDimension() == region.getDimension())
+            {
+                nodeMBR.combine(region);
+            }
+            else
+            {
+                nodeMBR = region;
+            }
+            return nodeMBR;
+        };
+
+        ExclusiveLatch rootLatch(m_rootLatch);
+        Node *root = m_tree.m_root_node;
+        ExclusiveLatch rootNodeLatch(root->m_latch);
+
+        // An internal root emptied by removes has no subtree to choose; start over from a leaf
+        if (!root->isLeaf() && root->isEmpty())
+        {
+            Node *emptyRoot = root;
+            root = m_tree.createLeafNode();
+            m_tree.m_root_node = root;
+            rootNodeLatch = ExclusiveLatch(root->m_latch);
+            m_tree.destroyNode(emptyRoot);
+        }
+
+        // path[i] is latched for i >= firstLatched; the nodes above were safe to let go
+        std::vector<Node *> path{root};
+        std::vector<ExclusiveLatch> latches;
+        latches.push_back(std::move(rootNodeLatch));
+        size_t firstLatched = 0;
+
+        grow(root);
+        if (root->size() < capacity)
+        {
+            // A root that cannot split keeps its place, so the root pointer can be released
+            rootLatch.unlock();
+        }
+
+        Node *node = root;
+        while (!node->isLeaf())
+        {
+            auto *internal = static_cast<InternalNode *>(node);
+            const size_t index = internal->m_childMBRs.chooseLeastEnlargement(region);
+            Node *child = internal->m_children[index];
+            ExclusiveLatch childLatch(child->m_latch);
+
+            internal->m_childMBRs.set(index, grow(child));
+
+            if (child->size() < capacity)
+            {
+                // The child absorbs a split below it, nothing above can change any more
+                latches.clear();
+                firstLatched = path.size();
+                if (rootLatch.owns_lock())
+                {
+                    rootLatch.unlock();
+                }
+            }
+            latches.push_back(std::move(childLatch));
+            path.push_back(child);
+            node = child;
+        }
+
+        static_cast<LeafNode *>(node)->appendEntry(data);
+
+        // Splits climb as long as the node overflows; an overflowing node was full on the way
+        // down, so its parent (or the root pointer) is still latched
+        for (size_t i = path.size(); i-- > firstLatched && path[i]->shouldSplit();)
+        {
+            auto [original, newNode] = path[i]->split();
+            if (newNode == nullptr)
+            {
+                break;
+            }
+
+            if (i == 0)
+            {
+                InternalNode *newRoot = m_tree.createInternalNode();
+                newRoot->addChild(original);
+                newRoot->addChild(newNode);
+                m_tree.m_root_node = newRoot;
+                break;
+            }
+
+            // The two halves cover what the node covered, so the parent's MBR stays as it is. It
+            // must not even be rewritten: the parent may be the topmost latched node, whose MBR
+            // its own parent reads under another latch.
+            auto *parent = static_cast<InternalNode *>(path[i - 1]);
+            parent->refreshChild(original);
+            newNode->setTree(parent->getTree());
+            parent->m_children.push_back(newNode);
+            parent->m_childMBRs.push_back(newNode->getMBR());
+        }
+
+        latches.clear();
+        m_tree.metricManager->record_insertion_time(microsecondsSince(startTime));
+    }
+
+    bool ConcurrentRTree::remove(const Region &mbr, id_type id)
+    {
+        for (;;)
+        {
+            std::vector<Node *> path;
+            Region region(0);
+            {
+                SharedLatch rootLatch(m_rootLatch);
+                Node *root = m_tree.m_root_node;
+                SharedLatch rootNodeLatch(root->m_latch);
+                rootLatch.unlock();
+                if (!locate(root, id, mbr, path, region))
+                {
+                    return false;
+                }
+            }
+            std::reverse(path.begin(), path.end());
+
+            // A writer may have split or emptied a node of the path in between; look again
+            if (removeAlong(path, id, region))
+            {
+                return true;
+            }
+        }
+    }
+
+    bool ConcurrentRTree::locate(Node *node, id_type id, const Region &mbr, std::vector<Node *> &path,
+                                 Region &region)
+    {
+        // The caller holds node's latch
+        if (node->isLeaf())
+        {
+            auto *leaf = static_cast<LeafNode *>(node);
+            auto it = std::find(leaf->m_ids.begin(), leaf->m_ids.end(), id);
+            if (it == leaf->m_ids.end())
+            {
+                return false;
+            }
+            region = leaf->m_entries[it - leaf->m_ids.begin()]->getRegion();
+            path.push_back(node);
+            return true;
+        }
+
+        auto *internal = static_cast<InternalNode *>(node);
+        for (size_t i = 0; i < internal->m_children.size(); ++i)
+        {
+            if (internal->m_childMBRs.intersects(i, mbr))
+            {
+                Node *child = internal->m_children[i];
+                SharedLatch childLatch(child->m_latch);
+                if (locate(child, id, mbr, path, region))
+                {
+                    path.push_back(node);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    bool ConcurrentRTree::removeAlong(const std::vector<Node *> &path, id_type id, const Region &region)
+    {
+        ExclusiveLatch rootLatch(m_rootLatch);
+        if (m_tree.m_root_node != path[0])
+        {
+            return false;
+        }
+
+        std::vector<ExclusiveLatch> latches;
+        latches.emplace_back(path[0]->m_latch);
+        size_t firstLatched = 0;
+
+        for (size_t i = 1; i < path.size(); ++i)
+        {
+            // Only latch nodes still reachable from a latched parent, never a destroyed one
+            auto *parent = static_cast<InternalNode *>(path[i - 1]);
+            if (std::find(parent->m_children.begin(), parent->m_children.end(), path[i]) == parent->m_children.end())
+            {
+                return false;
+            }
+
+            ExclusiveLatch childLatch(path[i]->m_latch);
+            if (strictlyInside(region, path[i]->getMBR()))
+            {
+                // Neither this node's MBR nor anything above it can change
+                latches.clear();
+                firstLatched = i;
+                if (rootLatch.owns_lock())
+                {
+                    rootLatch.unlock();
+                }
+            }
+            latches.push_back(std::move(childLatch));
+        }
+
+        auto *leaf = static_cast<LeafNode *>(path.back());
+        auto it = std::find(leaf->m_ids.begin(), leaf->m_ids.end(), id);
+        if (it == leaf->m_ids.end() || !(leaf->m_entries[it - leaf->m_ids.begin()]->getRegion() == region))
+        {
+            return false;
+        }
+        const size_t index = it - leaf->m_ids.begin();
+        m_tree.destroyData(leaf->m_entries[index]);
+        leaf->eraseEntry(index);
+
+        // Tighten the MBRs that may have shrunk, bottom-up through the latched nodes. The topmost
+        // latched node keeps its MBR unless it is the root.
+        for (size_t i = path.size(); i-- > firstLatched;)
+        {
+            if (!path[i]->isLeaf())
+            {
+                auto *internal = static_cast<InternalNode *>(path[i]);
+                Node *child = path[i + 1];
+                const size_t childIndex =
+                    std::find(internal->m_children.begin(), internal->m_children.end(), child) -
+                    internal->m_children.begin();
+                if (child->isEmpty())
+                {
+                    // Nobody else can be waiting for the child's latch: they would hold ours
+                    internal->m_children.erase(internal->m_children.begin() + childIndex);
+                    internal->m_childMBRs.erase(childIndex);
+                    latches[i + 1 - firstLatched].unlock();
+                    m_tree.destroyNode(child);
+                }
+                else
+                {
+                    internal->m_childMBRs.set(childIndex, child->getMBR());
+                }
+            }
+
+            if (i > firstLatched || i == 0)
+            {
+                if (path[i]->isLeaf())
+                {
+                    static_cast<LeafNode *>(path[i])->recalculateMBR();
+                }
+                else
+                {
+                    static_cast<InternalNode *>(path[i])->recalculateMBR();
+                }
+            }
+        }
+        return true;
+    }
+
+    void ConcurrentRTree::search(Node *node, const Region &query, Visitor &visitor)
+    {
+        // The caller holds node's latch
+        if (node->isLeaf())
+        {
+            node->search(query, visitor);
+            return;
+        }
+
+        auto *internal = static_cast<InternalNode *>(node);
+        internal->m_childMBRs.forEachIntersecting(query, [&](size_t i)
+                                                  {
+                                                      Node *child = internal->m_children[i];
+                                                      SharedLatch childLatch(child->m_latch);
+                                                      search(child, query, visitor);
+                                                  });
+    }
+
+    void ConcurrentRTree::search(const Region &query, Visitor &visitor)
+    {
+        SharedLatch rootLatch(m_rootLatch);
+        Node *root = m_tree.m_root_node;
+        SharedLatch rootNodeLatch(root->m_latch);
+        rootLatch.unlock();
+        search(root, query, visitor);
+    }
+
+    void ConcurrentRTree::intersectionQuery(const Region &query, Visitor &visitor)
+    {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        auto matches = makeMatchVisitor(&visitor, nullptr, [](const Data *) { return true; });
+        search(query, matches);
+        m_tree.metricManager->record_range_query_time(matches.found(), microsecondsSince(startTime));
+    }
+
+    std::vector<id_type> ConcurrentRTree::intersectionQuery(const Region &query)
+    {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        std::vector<id_type> ids;
+        auto matches = makeMatchVisitor(nullptr, &ids, [](const Data *) { return true; });
+        search(query, matches);
+        m_tree.metricManager->record_range_query_time(matches.found(), microsecondsSince(startTime));
+        return ids;
+    }
+
+    void ConcurrentRTree::pointQuery(const Point &point, Visitor &visitor)
+    {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        auto matches = makeMatchVisitor(&visitor, nullptr, [&point](const Data *data)
+                                        { return data->getRegion().contains(point); });
+        search(Region(point, point), matches);
+        m_tree.metricManager->record_point_query_time(matches.found(), microsecondsSince(startTime));
+    }
+
+    std::vector<id_type> ConcurrentRTree::pointQuery(const Point &point)
+    {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        std::vector<id_type> ids;
+        auto matches = makeMatchVisitor(nullptr, &ids, [&point](const Data *data)
+                                        { return data->getRegion().contains(point); });
+        search(Region(point, point), matches);
+        m_tree.metricManager->record_point_query_time(matches.found(), microsecondsSince(startTime));
+        return ids;
+    }
+}
@@ -0,0 +1,69 @@
+//
+// RTree that many threads may insert into, remove from and query at the same time.
+//
+
+#ifndef CONCURRENTRTREE_H
+#define CONCURRENTRTREE_H
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+#include "src/RTree/impl/common.h"
+#include "src/RTree/impl/tree/RTree.h"
+
+namespace RTree
+{
+    class Node;
+    class InternalNode;
+    class Point;
+    class Region;
+    class SplitStrategy;
+    class Visitor;
+
+    // Every node carries a reader/writer latch and all operations take latches top-down, the
+    // child's before letting go of the parent's (latch coupling), so no two can deadlock:
+    //  - queries hold shared latches on the path to the node they are reading;
+    //  - inserts grow the MBRs on the way down and hold exclusive latches from the lowest node
+    //    that might split (a full one) down to the leaf, so a split climbs through latched nodes;
+    //  - removes find the entry under shared latches, then take exclusive latches down the same
+    //    path, keeping the ancestors of every node whose MBR may shrink so it can be recomputed.
+    // MBRs therefore stay as tight as in a serial tree. Forced reinsertion is not done here even
+    // with the R* strategy: it would restart from the root while holding latches, so full leaves
+    // are always split.
+    class ConcurrentRTree
+    {
+    public:
+        ConcurrentRTree(uint32_t dimension, uint32_t nodeCapacity, const SplitStrategy *splitStrategy);
+
+        void insert(const Region &mbr, id_type id);
+        bool remove(const Region &mbr, id_type id);
+
+        // Entries may be removed as soon as the query lets go of their leaf, so results are
+        // handed out as ids; the visitor overloads see each entry while its leaf is latched.
+        std::vector<id_type> intersectionQuery(const Region &query);
+        std::vector<id_type> pointQuery(const Point &point);
+        void intersectionQuery(const Region &query, Visitor &visitor);
+        void pointQuery(const Point &point, Visitor &visitor);
+
+        // The underlying tree, for bulk loading, metrics and queries while no thread is writing
+        RTree &getTree();
+
+    private:
+        RTree m_tree;
+        // Guards m_tree.m_root_node; taken before the root's latch
+        std::shared_mutex m_rootLatch;
+
+        // Latch-coupled search from the root, or below node whose latch the caller holds
+        void search(const Region &query, Visitor &visitor);
+        void search(Node *node, const Region &query, Visitor &visitor);
+        // Appends the nodes from the leaf holding id up to node to path and copies the entry's
+        // region, false if id is not below node. The caller holds node's latch.
+        bool locate(Node *node, id_type id, const Region &mbr, std::vector<Node *> &path, Region &region);
+        // Exclusive pass along a path found by locate(), root first; false if the tree changed
+        // under it so the entry has to be looked up again
+        bool removeAlong(const std::vector<Node *> &path, id_type id, const Region &region);
+    };
+}
+
+#endif //CONCURRENTRTREE_H
@@ -0,0 +1,426 @@
+#include "FlatTreeView.h"
+#include <cmath>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+#include "src/RTree/impl/Region.h"
+#include "src/RTree/impl/pojo/Point.h"
+
+namespace RTree
+{
+    BoxQuantizer::BoxQuantizer(BoxEncoding encoding)
+        : m_maxCode(encoding == BoxEncoding::Quantized8 ? 0xFF : 0xFFFF)
+    {
+    }
+
+    uint32_t BoxQuantizer::getMaxCode() const
+    {
+        return m_maxCode;
+    }
+
+    double BoxQuantizer::decode(double frameLow, double frameHigh, uint32_t code) const
+    {
+        if (code == 0)
+        {
+            return frameLow;
+        }
+        if (code >= m_maxCode)
+        {
+            return frameHigh;
+        }
+        // An unbounded frame has no usable step, its inner codes all stand for the low bound
+        const double step = (frameHigh - frameLow) / m_maxCode;
+        return std::isfinite(step) ? frameLow + code * step : frameLow;
+    }
+
+    int64_t BoxQuantizer::floorCode(double frameLow, double frameHigh, double x) const
+    {
+        if (!(x >= frameLow))
+        {
+            return -1;
+        }
+        if (x >= frameHigh)
+        {
+            return m_maxCode;
+        }
+
+        // Estimate, then step to the exact answer; decode rounds, so the estimate may be off by one
+        const double step = (frameHigh - frameLow) / m_maxCode;
+        int64_t code = m_maxCode - 1;
+        if (std::isfinite(step) && step > 0)
+        {
+            code = std::clamp<int64_t>(static_cast<int64_t>((x - frameLow) / step), 0, m_maxCode - 1);
+            while (code > 0 && decode(frameLow, frameHigh, static_cast<uint32_t>(code)) > x)
+            {
+                --code;
+            }
+            while (code + 1 < m_maxCode && decode(frameLow, frameHigh, static_cast<uint32_t>(code + 1)) <= x)
+            {
+                ++code;
+            }
+        }
+        return code;
+    }
+
+    int64_t BoxQuantizer::ceilCode(double frameLow, double frameHigh, double x) const
+    {
+        if (!(x <= frameHigh))
+        {
+            return int64_t{m_maxCode} + 1;
+        }
+        if (x <= frameLow)
+        {
+            return 0;
+        }
+
+        const double step = (frameHigh - frameLow) / m_maxCode;
+        int64_t code = m_maxCode;
+        if (std::isfinite(step) && step > 0)
+        {
+            code = std::clamp<int64_t>(static_cast<int64_t>(std::ceil((x - frameLow) / step)), 1, m_maxCode);
+            while (code < m_maxCode && decode(frameLow, frameHigh, static_cast<uint32_t>(code)) < x)
+            {
+                ++code;
+            }
+            while (code > 1 && decode(frameLow, frameHigh, static_cast<uint32_t>(code - 1)) >= x)
+            {
+                --code;
+            }
+        }
+        return code;
+    }
+
+    void BoxQuantizer::encode(const double *frame, uint32_t dimension, const double *low, const double *high,
+                              uint32_t *codes) const
+    {
+        for (uint32_t d = 0; d < dimension; ++d)
+        {
+            const double frameLow = frame[d];
+            const double frameHigh = frame[dimension + d];
+            codes[d] = static_cast<uint32_t>(std::max<int64_t>(floorCode(frameLow, frameHigh, low[d]), 0));
+            codes[dimension + d] =
+                static_cast<uint32_t>(std::min<int64_t>(ceilCode(frameLow, frameHigh, high[d]), m_maxCode));
+        }
+    }
+
+    namespace
+    {
+        template <typename Code>
+        uint64_t codeMask(const BoxQuantizer &quantizer, const double *frame, uint32_t dimension,
+                          const Code *lowCodes, const Code *highCodes, size_t stride, const double *low,
+                          const double *high, size_t count)
+        {
+            uint64_t mask = count == 64 ? ~uint64_t{0} : (uint64_t{1} << count) - 1;
+            for (uint32_t d = 0; d < dimension && mask != 0; ++d)
+            {
+                // A child intersects the query in d when its low code is at most the last code not
+                // above the query, and its high code at least the first code not below it
+                const int64_t lowLimit = quantizer.floorCode(frame[d], frame[dimension + d], high[d]);
+                const int64_t highLimit = quantizer.ceilCode(frame[d], frame[dimension + d], low[d]);
+                if (lowLimit < 0 || highLimit > quantizer.getMaxCode())
+                {
+                    return 0;
+                }
+
+                const Code *lows = lowCodes + d * stride;
+                const Code *highs = highCodes + d * stride;
+                uint64_t hits = 0;
+                for (size_t j = 0; j < count; ++j)
+                {
+                    hits |= uint64_t(lows[j] <= lowLimit && highs[j] >= highLimit) << j;
+                }
+                mask &= hits;
+            }
+            return mask;
+        }
+
+        template <typename Code>
+        void decodeBox(const BoxQuantizer &quantizer, const double *frame, uint32_t dimension, const Code *codes,
+                       size_t stride, double *box)
+        {
+            for (uint32_t d = 0; d < dimension; ++d)
+            {
+                box[d] = quantizer.decode(frame[d], frame[dimension + d], codes[d * stride]);
+                box[dimension + d] =
+                    quantizer.decode(frame[d], frame[dimension + d], codes[(dimension + d) * stride]);
+            }
+        }
+    }
+
+    uint64_t FlatTreeView::childMask(const FlatNode &node, const double *frame, const double *low,
+                                     const double *high, size_t base) const
+    {
+        const size_t count = std::min<size_t>(64, node.count - base);
+        const size_t first = 2 * dimension * node.first + base;
+        switch (encoding)
+        {
+        case BoxEncoding::Quantized16:
+        {
+            const auto *codes = static_cast<const uint16_t *>(nodeCodes) + first;
+            return codeMask(BoxQuantizer(encoding), frame, dimension, codes, codes + dimension * node.count,
+                            node.count, low, high, count);
+        }
+        case BoxEncoding::Quantized8:
+        {
+            const auto *codes = static_cast<const uint8_t *>(nodeCodes) + first;
+            return codeMask(BoxQuantizer(encoding), frame, dimension, codes, codes + dimension * node.count,
+                            node.count, low, high, count);
+        }
+        default:
+            return simd::intersectMask(nodeBoxes + first, nodeBoxes + first + dimension * node.count, node.count,
+                                       dimension, low, high, count);
+        }
+    }
+
+    void FlatTreeView::childBox(const FlatNode &node, const double *frame, size_t i, double *box) const
+    {
+        const size_t first = 2 * dimension * node.first + i;
+        switch (encoding)
+        {
+        case BoxEncoding::Quantized16:
+            decodeBox(BoxQuantizer(encoding), frame, dimension, static_cast<const uint16_t *>(nodeCodes) + first,
+                      node.count, box);
+            break;
+        case BoxEncoding::Quantized8:
+            decodeBox(BoxQuantizer(encoding), frame, dimension, static_cast<const uint8_t *>(nodeCodes) + first,
+                      node.count, box);
+            break;
+        default:
+            for (uint32_t d = 0; d < 2 * dimension; ++d)
+            {
+                box[d] = nodeBoxes[first + d * node.count];
+            }
+        }
+    }
+
+    unsigned FlatTreeView::countTrailingZeros(uint64_t mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward64(&index, mask);
+        return static_cast<unsigned>(index);
+#else
+        return static_cast<unsigned>(__builtin_ctzll(mask));
+#endif
+    }
+
+    std::vector<id_type> FlatTreeView::intersectionQuery(const Region &query) const
+    {
+        std::vector<id_type> result;
+        if (query.getDimension() == dimension)
+        {
+            search(query.getLowCoordinates(), query.getHighCoordinates(), [&](size_t index, const double *, size_t)
+                   { result.push_back(ids[index]); });
+        }
+        return result;
+    }
+
+    std::vector<id_type> FlatTreeView::containmentQuery(const Region &query) const
+    {
+        std::vector<id_type> result;
+        if (query.getDimension() != dimension)
+        {
+            return result;
+        }
+
+        search(query.getLowCoordinates(), query.getHighCoordinates(), [&](size_t index, const double *box, size_t stride)
+               {
+                   for (uint32_t d = 0; d < dimension; ++d)
+                   {
+                       if (box[d * stride] < query.getLow(d) || box[(dimension + d) * stride] > query.getHigh(d))
+                       {
+                           return;
+                       }
+                   }
+                   result.push_back(ids[index]);
+               });
+        return result;
+    }
+
+    std::vector<id_type> FlatTreeView::pointQuery(const Point &point) const
+    {
+        std::vector<id_type> result;
+        if (point.getDimension() == dimension)
+        {
+            // Intersecting a degenerate box is containing the point
+            search(point.getCoordinates(), point.getCoordinates(), [&](size_t index, const double *, size_t)
+                   { result.push_back(ids[index]); });
+        }
+        return result;
+    }
+
+    std::vector<std::vector<id_type>> FlatTreeView::intersectionQueryBatch(const std::vector<Region> &queries) const
+    {
+        std::vector<std::vector<id_type>> results(queries.size());
+        if (nodeCount == 0)
+        {
+            return results;
+        }
+
+        std::vector<uint32_t> active;
+        for (uint32_t j = 0; j < queries.size(); ++j)
+        {
+            const Region &query = queries[j];
+            if (query.getDimension() == dimension &&
+                simd::intersectMask(nodeBoxes, nodeBoxes + dimension, 1, dimension, query.getLowCoordinates(),
+                                    query.getHighCoordinates(), 1) != 0)
+            {
+                active.push_back(j);
+            }
+        }
+        searchBatch(0, nodeBoxes, queries.data(), active.data(), active.size(), results);
+        return results;
+    }
+
+    void FlatTreeView::searchBatch(uint64_t index, const double *frame, const Region *queries,
+                                   const uint32_t *active, size_t count,
+                                   std::vector<std::vector<id_type>> &results) const
+    {
+        const FlatNode &node = nodes[index];
+        const bool leaf = node.height == 1;
+        const double *lows = entryBoxes + 2 * dimension * node.first;
+        const size_t stride = node.count;
+
+        // Which children every active query reaches, or straight to the results in a leaf
+        std::vector<std::pair<uint32_t, uint32_t>> hits; // (child, query)
+        for (size_t j = 0; j < count; ++j)
+        {
+            const Region &query = queries[active[j]];
+            for (size_t base = 0; base < node.count; base += 64)
+            {
+                uint64_t mask = leaf ? simd::intersectMask(lows + base, lows + dimension * stride + base, stride,
+                                                           dimension, query.getLowCoordinates(),
+                                                           query.getHighCoordinates(),
+                                                           std::min<size_t>(64, node.count - base))
+                                     : childMask(node, frame, query.getLowCoordinates(),
+                                                 query.getHighCoordinates(), base);
+                while (mask != 0)
+                {
+                    const size_t offset = base + countTrailingZeros(mask);
+                    if (leaf)
+                    {
+                        results[active[j]].push_back(ids[node.first + offset]);
+                    }
+                    else
+                    {
+                        hits.emplace_back(static_cast<uint32_t>(offset), active[j]);
+                    }
+                    mask &= mask - 1;
+                }
+            }
+        }
+        if (leaf)
+        {
+            return;
+        }
+
+        // Group the hits by child, keeping the query order, and descend once per child
+        std::vector<size_t> offsets(node.count + 1, 0);
+        for (const auto &hit : hits)
+        {
+            ++offsets[hit.first + 1];
+        }
+        for (size_t i = 0; i < node.count; ++i)
+        {
+            offsets[i + 1] += offsets[i];
+        }
+        std::vector<uint32_t> partition(hits.size());
+        std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+        for (const auto &hit : hits)
+        {
+            partition[next[hit.first]++] = hit.second;
+        }
+
+        std::vector<double> childFrame(2 * dimension);
+        for (size_t i = 0; i < node.count; ++i)
+        {
+            if (offsets[i + 1] > offsets[i])
+            {
+                if (encoding != BoxEncoding::Exact)
+                {
+                    childBox(node, frame, i, childFrame.data());
+                }
+                searchBatch(node.first + i, childFrame.data(), queries, partition.data() + offsets[i],
+                            offsets[i + 1] - offsets[i], results);
+            }
+        }
+    }
+
+    std::vector<id_type> FlatTreeView::nearestNeighbors(const Point &point, uint32_t k) const
+    {
+        if (point.getDimension() != dimension)
+        {
+            throw std::invalid_argument("Dimensions do not match");
+        }
+
+        // Best first as in RTree::nearestNeighbors: an entry popped is nearer than anything queued
+        struct Candidate
+        {
+            double distance;
+            uint64_t index;
+            bool entry;
+            // Where the node's box starts in boxes
+            size_t box;
+
+            // Entries before nodes at equal distance, they can be reported right away
+            bool operator>(const Candidate &other) const
+            {
+                return distance > other.distance || (distance == other.distance && !entry && other.entry);
+            }
+        };
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> queue;
+
+        const double *coords = point.getCoordinates();
+        auto distanceTo = [&](const double *box, size_t stride)
+        {
+            double distance = 0.0;
+            for (uint32_t d = 0; d < dimension; ++d)
+            {
+                const double below = box[d * stride] - coords[d];
+                const double above = coords[d] - box[(dimension + d) * stride];
+                const double gap = std::max(0.0, std::max(below, above));
+                distance += gap * gap;
+            }
+            return distance;
+        };
+
+        // Boxes of the queued nodes, whose children a quantized encoding decodes relative to them
+        std::vector<double> boxes(nodeBoxes, nodeBoxes + (nodeCount > 0 ? 2 * dimension : 0));
+
+        std::vector<id_type> result;
+        if (k > 0 && nodeCount > 0 && nodes[0].count > 0)
+        {
+            queue.push({0.0, 0, false, 0});
+        }
+        while (!queue.empty() && result.size() < k)
+        {
+            const Candidate candidate = queue.top();
+            queue.pop();
+            if (candidate.entry)
+            {
+                result.push_back(ids[candidate.index]);
+                continue;
+            }
+
+            const FlatNode &node = nodes[candidate.index];
+            if (node.height == 1)
+            {
+                const double *entries = entryBoxes + 2 * dimension * node.first;
+                for (uint32_t i = 0; i < node.count; ++i)
+                {
+                    queue.push({distanceTo(entries + i, node.count), node.first + i, true, 0});
+                }
+                continue;
+            }
+            for (uint32_t i = 0; i < node.count; ++i)
+            {
+                const size_t box = boxes.size();
+                boxes.resize(box + 2 * dimension);
+                childBox(node, boxes.data() + candidate.box, i, boxes.data() + box);
+                queue.push({distanceTo(boxes.data() + box, 1), node.first + i, false, box});
+            }
+        }
+        return result;
+    }
+}
@@ -0,0 +1,176 @@
+//
+// Queries over a tree flattened into breadth-first arrays, wherever those arrays live.
+//
+
+#ifndef FLATTREEVIEW_H
+#define FLATTREEVIEW_H
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "src/RTree/impl/common.h"
+#include "src/RTree/impl/simd/SimdKernels.h"
+
+namespace RTree
+{
+    class Point;
+    class Region;
+
+    // One node of a flattened tree
+    struct FlatNode
+    {
+        // Index of the first child in the node array, or of the first entry for a leaf
+        uint64_t first;
+        uint32_t count;
+        // 1 for a leaf
+        uint32_t height;
+    };
+
+    // How a flattened tree stores the boxes of its nodes; entry boxes are always exact
+    enum class BoxEncoding
+    {
+        Exact,       // 2 * dimension doubles per node
+        Quantized16, // 2 * dimension 16-bit codes per node, relative to the parent's box
+        Quantized8   // The same with 8-bit codes
+    };
+
+    // Codes of a quantized BoxEncoding. A box is coded relative to a frame, the box of its parent:
+    // code c of 0..maxCode stands for frameLow + c * (frameHigh - frameLow) / maxCode in each
+    // dimension, 0 and maxCode for the frame bounds themselves. Low bounds are rounded down and
+    // high bounds up, so the decoded box contains the exact one.
+    class BoxQuantizer
+    {
+    public:
+        explicit BoxQuantizer(BoxEncoding encoding);
+
+        uint32_t getMaxCode() const;
+
+        // Value of code in [frameLow, frameHigh], nondecreasing in code
+        double decode(double frameLow, double frameHigh, uint32_t code) const;
+        // Largest code whose value is <= x, -1 when there is none
+        int64_t floorCode(double frameLow, double frameHigh, double x) const;
+        // Smallest code whose value is >= x, maxCode + 1 when there is none
+        int64_t ceilCode(double frameLow, double frameHigh, double x) const;
+
+        // Codes of [low, high] in frame (all low bounds, then all high bounds), rounded outward
+        void encode(const double *frame, uint32_t dimension, const double *low, const double *high,
+                    uint32_t *codes) const;
+
+    private:
+        uint32_t m_maxCode;
+    };
+
+    // Nodes are in breadth-first order with the root first, so the children of a node are a run
+    // of consecutive nodes, and the entries of the leaves follow each other leaf by leaf. Boxes
+    // are packed run by run: the boxes of a run of count nodes (entries) starting at index first
+    // take the 2 * dimension * count doubles from 2 * dimension * first in nodeBoxes (entryBoxes),
+    // laid out like MBRColumns with stride count, the low bounds of each dimension then the high
+    // bounds. Visiting a node thus reads one contiguous block for its children's boxes, next to
+    // the ids for a leaf. The root is a run of its own. An empty node has an inverted box
+    // (low +inf, high -inf).
+    //
+    // With a quantized encoding only the root's box is kept in nodeBoxes. The boxes of the other
+    // nodes are codes in nodeCodes (uint16_t or uint8_t), in the same runs, relative to the
+    // decoded box of their parent, which the root's box starts. A decoded box contains the exact
+    // one, so a query still finds every entry, entries being checked exactly, and only visits
+    // some nodes the exact boxes would have skipped.
+    //
+    // The view does not own the arrays: FrozenRTree keeps them in memory, MappedRTree in a
+    // mapped file. Every query only reads, so any number of threads may run them at once.
+    class FlatTreeView
+    {
+    public:
+        uint32_t dimension = 0;
+        uint64_t nodeCount = 0;
+        uint64_t entryCount = 0;
+        BoxEncoding encoding = BoxEncoding::Exact;
+        const FlatNode *nodes = nullptr;
+        const double *nodeBoxes = nullptr;
+        const void *nodeCodes = nullptr;
+        const double *entryBoxes = nullptr;
+        const id_type *ids = nullptr;
+
+        // Ids of the entries intersecting query, contained in query, or containing point; empty
+        // when the dimensions do not match
+        std::vector<id_type> intersectionQuery(const Region &query) const;
+        std::vector<id_type> containmentQuery(const Region &query) const;
+        std::vector<id_type> pointQuery(const Point &point) const;
+        // Result i lists the entries intersecting queries[i]. One descent answers the whole batch,
+        // visiting each node once for all the queries that reach it.
+        std::vector<std::vector<id_type>> intersectionQueryBatch(const std::vector<Region> &queries) const;
+        // The k entries nearest to point, nearest first, measured as RTree::nearestNeighbors does.
+        // Throws std::invalid_argument on a dimension mismatch.
+        std::vector<id_type> nearestNeighbors(const Point &point, uint32_t k) const;
+
+        // Calls visit(entry index, box, stride) for every entry whose box intersects [low, high],
+        // where box[d * stride] and box[(dimension + d) * stride] are its bounds in dimension d
+        template <typename Visit>
+        void search(const double *low, const double *high, Visit &&visit) const
+        {
+            // Only the root's box is not checked by its parent
+            if (nodeCount == 0 ||
+                simd::intersectMask(nodeBoxes, nodeBoxes + dimension, 1, dimension, low, high, 1) == 0)
+            {
+                return;
+            }
+
+            // Nodes to visit, and their decoded boxes for a quantized encoding
+            const size_t frameSize = encoding == BoxEncoding::Exact ? 0 : 2 * dimension;
+            std::vector<uint64_t> stack{0};
+            std::vector<double> frames(nodeBoxes, nodeBoxes + frameSize);
+            std::vector<double> frame(frameSize);
+            while (!stack.empty())
+            {
+                const FlatNode &node = nodes[stack.back()];
+                stack.pop_back();
+                std::copy(frames.end() - frameSize, frames.end(), frame.begin());
+                frames.resize(frames.size() - frameSize);
+
+                const bool leaf = node.height == 1;
+                const double *lows = entryBoxes + 2 * dimension * node.first;
+                for (size_t base = 0; base < node.count; base += 64)
+                {
+                    uint64_t mask = leaf ? simd::intersectMask(lows + base, lows + dimension * node.count + base,
+                                                               node.count, dimension, low, high,
+                                                               std::min<size_t>(64, node.count - base))
+                                         : childMask(node, frame.data(), low, high, base);
+                    while (mask != 0)
+                    {
+                        const size_t offset = base + countTrailingZeros(mask);
+                        if (leaf)
+                        {
+                            visit(node.first + offset, lows + offset, node.count);
+                        }
+                        else
+                        {
+                            stack.push_back(node.first + offset);
+                            if (frameSize != 0)
+                            {
+                                frames.resize(frames.size() + frameSize);
+                                childBox(node, frame.data(), offset, frames.data() + frames.size() - frameSize);
+                            }
+                        }
+                        mask &= mask - 1;
+                    }
+                }
+            }
+        }
+
+    private:
+        static unsigned countTrailingZeros(uint64_t mask);
+
+        // Mask of the children base to base + 63 of internal node whose boxes intersect [low, high];
+        // frame is the node's decoded box, unused for exact boxes
+        uint64_t childMask(const FlatNode &node, const double *frame, const double *low, const double *high,
+                           size_t base) const;
+        // Box of child i of internal node, decoded in frame: all low bounds, then all high bounds
+        void childBox(const FlatNode &node, const double *frame, size_t i, double *box) const;
+
+        // Batched search below node index for the count queries listed in active
+        void searchBatch(uint64_t index, const double *frame, const Region *queries, const uint32_t *active,
+                         size_t count, std::vector<std::vector<id_type>> &results) const;
+    };
+}
+
+#endif //FLATTREEVIEW_H
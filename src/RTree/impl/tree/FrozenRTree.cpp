@@ -0,0 +1,264 @@
+#include "FrozenRTree.h"
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+#include "src/RTree/impl/Region.h"
+#include "src/RTree/impl/node/InternalNode.h"
+#include "src/RTree/impl/node/LeafNode.h"
+#include "src/RTree/impl/node/MBRColumns.h"
+#include "src/RTree/impl/strategy/SplitStrategy.h"
+#include "src/RTree/impl/tree/RTree.h"
+
+namespace RTree
+{
+    FrozenRTree::FrozenRTree(const RTree &tree, BoxEncoding encoding)
+        : m_dimension(tree.m_dimension), m_nodeCapacity(tree.m_nodeCapacity), m_encoding(encoding)
+    {
+        if (tree.m_splitStrategy != nullptr)
+        {
+            m_splitStrategyName = tree.m_splitStrategy->getName();
+        }
+        if (tree.m_root_node == nullptr)
+        {
+            return;
+        }
+
+        m_height = 1;
+        for (const Node *node = tree.m_root_node;
+             !node->isLeaf() && !static_cast<const InternalNode *>(node)->m_children.empty();
+             node = static_cast<const InternalNode *>(node)->m_children[0])
+        {
+            ++m_height;
+        }
+
+        auto countOf = [](const Node *node)
+        {
+            return node->isLeaf() ? static_cast<const LeafNode *>(node)->m_ids.size()
+                                  : static_cast<const InternalNode *>(node)->m_children.size();
+        };
+
+        // Breadth-first, so every node's children and every leaf's entries land in one run
+        std::vector<const Node *> order{tree.m_root_node};
+        m_nodes.push_back({0, 0, m_height});
+        uint64_t entryCount = 0;
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            const Node *node = order[i];
+            m_nodes[i].count = static_cast<uint32_t>(countOf(node));
+            if (node->isLeaf())
+            {
+                m_nodes[i].first = entryCount;
+                entryCount += m_nodes[i].count;
+                continue;
+            }
+            m_nodes[i].first = order.size();
+            for (const Node *child : static_cast<const InternalNode *>(node)->m_children)
+            {
+                order.push_back(child);
+                m_nodes.push_back({0, 0, m_nodes[i].height - 1});
+            }
+        }
+
+        // Exact box of node index: all low bounds, then all high bounds
+        auto exactBox = [&](size_t index, double *box)
+        {
+            const Region &mbr = order[index]->getMBR();
+            const bool empty = mbr.getDimension() != m_dimension || m_nodes[index].count == 0;
+            for (uint32_t d = 0; d < m_dimension; ++d)
+            {
+                box[d] = empty ? std::numeric_limits<double>::infinity() : mbr.getLow(d);
+                box[m_dimension + d] = empty ? -std::numeric_limits<double>::infinity() : mbr.getHigh(d);
+            }
+        };
+
+        // Every node's box goes to the run it belongs to: the root's own, or its parent's children.
+        // Quantized, only the root's stays in nodeBoxes.
+        const size_t nodeCount = order.size();
+        m_nodeBoxes.resize(2 * m_dimension * (m_encoding == BoxEncoding::Exact ? nodeCount : 1));
+        exactBox(0, m_nodeBoxes.data());
+        if (m_encoding == BoxEncoding::Exact)
+        {
+            std::vector<double> box(2 * m_dimension);
+            for (size_t i = 0; i < nodeCount; ++i)
+            {
+                const FlatNode &node = m_nodes[i];
+                for (size_t child = node.first; !order[i]->isLeaf() && child < node.first + node.count; ++child)
+                {
+                    exactBox(child, box.data());
+                    for (uint32_t d = 0; d < 2 * m_dimension; ++d)
+                    {
+                        m_nodeBoxes[2 * m_dimension * node.first + d * node.count + (child - node.first)] = box[d];
+                    }
+                }
+            }
+        }
+        else
+        {
+            // Top-down, each node's decoded box being the frame of its children's codes
+            const BoxQuantizer quantizer(m_encoding);
+            std::vector<double> frames(2 * m_dimension * nodeCount);
+            std::copy_n(m_nodeBoxes.data(), 2 * m_dimension, frames.data());
+            std::vector<uint32_t> codes(2 * m_dimension * nodeCount);
+            std::vector<double> box(2 * m_dimension);
+            for (size_t i = 0; i < nodeCount; ++i)
+            {
+                const FlatNode &node = m_nodes[i];
+                const double *frame = frames.data() + 2 * m_dimension * i;
+                for (size_t child = node.first; !order[i]->isLeaf() && child < node.first + node.count; ++child)
+                {
+                    exactBox(child, box.data());
+                    uint32_t *childCodes = codes.data() + 2 * m_dimension * child;
+                    quantizer.encode(frame, m_dimension, box.data(), box.data() + m_dimension, childCodes);
+                    for (uint32_t d = 0; d < m_dimension; ++d)
+                    {
+                        frames[2 * m_dimension * child + d] =
+                            quantizer.decode(frame[d], frame[m_dimension + d], childCodes[d]);
+                        frames[2 * m_dimension * child + m_dimension + d] =
+                            quantizer.decode(frame[d], frame[m_dimension + d], childCodes[m_dimension + d]);
+                    }
+                }
+            }
+
+            // Into the runs of the view, column by column
+            auto pack = [&](auto &packed)
+            {
+                packed.resize(codes.size());
+                for (size_t i = 0; i < nodeCount; ++i)
+                {
+                    const FlatNode &node = m_nodes[i];
+                    for (size_t child = node.first; !order[i]->isLeaf() && child < node.first + node.count; ++child)
+                    {
+                        for (uint32_t d = 0; d < 2 * m_dimension; ++d)
+                        {
+                            packed[2 * m_dimension * node.first + d * node.count + (child - node.first)] =
+                                static_cast<typename std::decay_t<decltype(packed)>::value_type>(
+                                    codes[2 * m_dimension * child + d]);
+                        }
+                    }
+                }
+            };
+            if (m_encoding == BoxEncoding::Quantized16)
+            {
+                pack(m_nodeCodes16);
+            }
+            else
+            {
+                pack(m_nodeCodes8);
+            }
+        }
+
+        m_entryBoxes.resize(2 * m_dimension * entryCount);
+        m_ids.reserve(entryCount);
+        for (size_t i = 0; i < nodeCount; ++i)
+        {
+            const FlatNode &node = m_nodes[i];
+            if (!order[i]->isLeaf())
+            {
+                continue;
+            }
+
+            const auto *leaf = static_cast<const LeafNode *>(order[i]);
+            double *boxes = m_entryBoxes.data() + 2 * m_dimension * node.first;
+            for (uint32_t d = 0; d < m_dimension; ++d)
+            {
+                std::copy_n(leaf->m_entryMBRs.lows(d), node.count, boxes + d * node.count);
+                std::copy_n(leaf->m_entryMBRs.highs(d), node.count, boxes + (m_dimension + d) * node.count);
+            }
+            m_ids.insert(m_ids.end(), leaf->m_ids.begin(), leaf->m_ids.end());
+        }
+    }
+
+    FlatTreeView FrozenRTree::view() const
+    {
+        FlatTreeView view;
+        view.dimension = m_dimension;
+        view.nodeCount = m_nodes.size();
+        view.entryCount = m_ids.size();
+        view.nodes = m_nodes.data();
+        view.encoding = m_encoding;
+        view.nodeBoxes = m_nodeBoxes.data();
+        view.nodeCodes = m_encoding == BoxEncoding::Quantized16 ? static_cast<const void *>(m_nodeCodes16.data())
+                                                                 : m_nodeCodes8.data();
+        view.entryBoxes = m_entryBoxes.data();
+        view.ids = m_ids.data();
+        return view;
+    }
+
+    std::vector<id_type> FrozenRTree::intersectionQuery(const Region &query) const
+    {
+        return view().intersectionQuery(query);
+    }
+
+    std::vector<id_type> FrozenRTree::containmentQuery(const Region &query) const
+    {
+        return view().containmentQuery(query);
+    }
+
+    std::vector<id_type> FrozenRTree::pointQuery(const Point &point) const
+    {
+        return view().pointQuery(point);
+    }
+
+    void FrozenRTree::intersectionQuery(const Region &query, const std::function<void(id_type)> &visit) const
+    {
+        if (query.getDimension() != m_dimension)
+        {
+            return;
+        }
+        view().search(query.getLowCoordinates(), query.getHighCoordinates(), [&](size_t index, const double *, size_t)
+                      { visit(m_ids[index]); });
+    }
+
+    std::vector<std::vector<id_type>> FrozenRTree::intersectionQueryBatch(const std::vector<Region> &queries) const
+    {
+        return view().intersectionQueryBatch(queries);
+    }
+
+    std::vector<id_type> FrozenRTree::nearestNeighbors(const Point &point, uint32_t k) const
+    {
+        return view().nearestNeighbors(point, k);
+    }
+
+    uint32_t FrozenRTree::getDimension() const
+    {
+        return m_dimension;
+    }
+
+    uint32_t FrozenRTree::getNodeCapacity() const
+    {
+        return m_nodeCapacity;
+    }
+
+    uint32_t FrozenRTree::getHeight() const
+    {
+        return m_height;
+    }
+
+    uint64_t FrozenRTree::size() const
+    {
+        return m_ids.size();
+    }
+
+    uint64_t FrozenRTree::getNodeCount() const
+    {
+        return m_nodes.size();
+    }
+
+    BoxEncoding FrozenRTree::getEncoding() const
+    {
+        return m_encoding;
+    }
+
+    const std::string &FrozenRTree::getSplitStrategyName() const
+    {
+        return m_splitStrategyName;
+    }
+
+    size_t FrozenRTree::getMemoryUsage() const
+    {
+        return m_nodes.capacity() * sizeof(FlatNode) + m_nodeBoxes.capacity() * sizeof(double) +
+               m_nodeCodes16.capacity() * sizeof(uint16_t) + m_nodeCodes8.capacity() +
+               m_entryBoxes.capacity() * sizeof(double) + m_ids.capacity() * sizeof(id_type);
+    }
+}
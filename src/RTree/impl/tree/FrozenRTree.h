@@ -0,0 +1,88 @@
+//
+// Immutable RTree flattened into contiguous arrays, see RTree::freeze.
+//
+
+#ifndef FROZENRTREE_H
+#define FROZENRTREE_H
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "src/RTree/impl/common.h"
+#include "src/RTree/impl/tree/FlatTreeView.h"
+
+namespace RTree
+{
+    class Point;
+    class Region;
+    class RTree;
+
+    // Read-only copy of an RTree for workloads that stop changing the tree once it is built.
+    // Nodes are FlatNode records in one breadth-first array, children are addressed by index
+    // instead of pointer, and the boxes of the nodes and the ids and boxes of the entries are
+    // packed into a few flat arrays (see FlatTreeView). There are no Data objects, no per-node
+    // allocations and no virtual calls, so the tree takes a fraction of the memory and a query
+    // touches far fewer cache lines. With exact boxes the layout is that of a tree file, see
+    // saveTree.
+    //
+    // A quantized BoxEncoding shrinks the node boxes further, to 16 or 8-bit codes relative to
+    // the parent's box, so many more children fit a cache line. Codes round outward: queries
+    // return the same entries, at the cost of visiting some nodes exact boxes would have pruned.
+    //
+    // Queries return ids rather than Data pointers. They only read, so any number of threads may
+    // run them at once.
+    class FrozenRTree
+    {
+    public:
+        // Ids of the entries intersecting query, contained in query, or containing point
+        std::vector<id_type> intersectionQuery(const Region &query) const;
+        std::vector<id_type> containmentQuery(const Region &query) const;
+        std::vector<id_type> pointQuery(const Point &point) const;
+
+        // Calls visit(id) for every entry intersecting query, in traversal order
+        void intersectionQuery(const Region &query, const std::function<void(id_type)> &visit) const;
+
+        // Result i lists the entries intersecting queries[i]
+        std::vector<std::vector<id_type>> intersectionQueryBatch(const std::vector<Region> &queries) const;
+
+        // The k entries nearest to point, nearest first, measured as RTree::nearestNeighbors does
+        std::vector<id_type> nearestNeighbors(const Point &point, uint32_t k) const;
+
+        uint32_t getDimension() const;
+        uint32_t getNodeCapacity() const;
+        uint32_t getHeight() const;
+        uint64_t size() const;
+        uint64_t getNodeCount() const;
+        BoxEncoding getEncoding() const;
+        // getName() of the split strategy the tree was built with, empty without one
+        const std::string &getSplitStrategyName() const;
+        // Bytes held by the node and entry arrays
+        size_t getMemoryUsage() const;
+
+        // The arrays, for writing them out or querying them directly
+        FlatTreeView view() const;
+
+    private:
+        uint32_t m_dimension;
+        uint32_t m_nodeCapacity;
+        uint32_t m_height = 0;
+        BoxEncoding m_encoding;
+        std::string m_splitStrategyName;
+
+        std::vector<FlatNode> m_nodes;
+        std::vector<double> m_nodeBoxes;
+        // Node box codes of a quantized encoding, only the one in use is filled
+        std::vector<uint16_t> m_nodeCodes16;
+        std::vector<uint8_t> m_nodeCodes8;
+        std::vector<double> m_entryBoxes;
+        std::vector<id_type> m_ids;
+
+        FrozenRTree(const RTree &tree, BoxEncoding encoding);
+
+        friend class RTree;
+    };
+}
+
+#endif //FROZENRTREE_H
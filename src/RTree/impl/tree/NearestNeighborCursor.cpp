@@ -0,0 +1,123 @@
+#include "NearestNeighborCursor.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "RTree.h"
+#include "src/RTree/impl/node/InternalNode.h"
+#include "src/RTree/impl/node/LeafNode.h"
+
+namespace RTree
+{
+    NearestNeighborCursor::NearestNeighborCursor(const RTree &tree, const Point &point, size_t maxQueueSize)
+        : m_point(point), m_maxQueueSize(maxQueueSize), m_truncatedDistance(std::numeric_limits<double>::max())
+    {
+        if (point.getDimension() != tree.getDimension())
+        {
+            throw std::invalid_argument("Dimensions do not match");
+        }
+
+        if (tree.m_root_node->size() > 0)
+        {
+            push(0.0, tree.m_root_node, nullptr);
+        }
+    }
+
+    Data *NearestNeighborCursor::next()
+    {
+        const double *coords = m_point.getCoordinates();
+        while (!m_queue.empty())
+        {
+            // Past the nearest dropped candidate the order can no longer be vouched for
+            if (m_queue.front().distance >= m_truncatedDistance)
+            {
+                return nullptr;
+            }
+
+            std::pop_heap(m_queue.begin(), m_queue.end(), fartherThan);
+            const Candidate candidate = m_queue.back();
+            m_queue.pop_back();
+
+            if (candidate.data != nullptr)
+            {
+                m_distance = std::sqrt(candidate.distance);
+                return candidate.data;
+            }
+
+            if (candidate.node->isLeaf())
+            {
+                auto *leaf = static_cast<LeafNode *>(candidate.node);
+                for (size_t i = 0; i < leaf->m_entries.size(); ++i)
+                {
+                    push(leaf->m_entryMBRs.getMinDistanceSquared(i, coords), nullptr, leaf->m_entries[i]);
+                }
+            }
+            else
+            {
+                auto *node = static_cast<InternalNode *>(candidate.node);
+                for (size_t i = 0; i < node->m_children.size(); ++i)
+                {
+                    push(node->m_childMBRs.getMinDistanceSquared(i, coords), node->m_children[i], nullptr);
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    double NearestNeighborCursor::getDistance() const
+    {
+        return m_distance;
+    }
+
+    bool NearestNeighborCursor::isTruncated() const
+    {
+        return m_truncated;
+    }
+
+    size_t NearestNeighborCursor::getQueueSize() const
+    {
+        return m_queue.size();
+    }
+
+    void NearestNeighborCursor::push(double distance, Node *node, Data *data)
+    {
+        // Candidates beyond what was dropped could never be returned anyway
+        if (distance >= m_truncatedDistance)
+        {
+            return;
+        }
+
+        m_queue.push_back({distance, node, data});
+        std::push_heap(m_queue.begin(), m_queue.end(), fartherThan);
+
+        if (m_maxQueueSize != 0 && m_queue.size() > m_maxQueueSize)
+        {
+            trim();
+        }
+    }
+
+    void NearestNeighborCursor::trim()
+    {
+        // Keep the nearest three quarters so the next few pushes do not trim again
+        const size_t keep = std::max<size_t>(1, m_maxQueueSize - m_maxQueueSize / 4);
+        std::nth_element(m_queue.begin(), m_queue.begin() + keep, m_queue.end(),
+                         [](const Candidate &a, const Candidate &b)
+                         { return a.distance < b.distance; });
+
+        for (auto it = m_queue.begin() + keep; it != m_queue.end(); ++it)
+        {
+            m_truncatedDistance = std::min(m_truncatedDistance, it->distance);
+        }
+        m_queue.resize(keep);
+        std::make_heap(m_queue.begin(), m_queue.end(), fartherThan);
+        m_truncated = true;
+    }
+
+    bool NearestNeighborCursor::fartherThan(const Candidate &a, const Candidate &b)
+    {
+        // Entries before nodes at equal distance, they can be returned right away
+        return a.distance > b.distance || (a.distance == b.distance && a.data == nullptr && b.data != nullptr);
+    }
+}
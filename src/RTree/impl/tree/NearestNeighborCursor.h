@@ -0,0 +1,67 @@
+//
+// Incremental nearest neighbour browsing over an RTree (Hjaltason & Samet's distance browsing).
+//
+
+#ifndef NEARESTNEIGHBORCURSOR_H
+#define NEARESTNEIGHBORCURSOR_H
+#include <cstddef>
+#include <vector>
+
+#include "src/RTree/impl/pojo/Point.h"
+
+namespace RTree
+{
+    class Data;
+    class Node;
+    class RTree;
+
+    // Yields the entries of a tree one at a time by increasing distance from a query point, until
+    // the caller stops asking. A single queue of nodes and entries lives across next() calls, so
+    // every node is expanded at most once however many entries are taken.
+    //
+    // The cursor reads the tree in place: it must not outlive the tree, and any insert or remove
+    // invalidates it.
+    class NearestNeighborCursor
+    {
+    public:
+        // maxQueueSize bounds the queue, 0 for no bound. When the queue would grow past it the
+        // farthest quarter is dropped; browsing then ends early (see isTruncated()) once it reaches
+        // the distance of the nearest dropped candidate, but never returns entries out of order.
+        NearestNeighborCursor(const RTree &tree, const Point &point, size_t maxQueueSize = 0);
+
+        // Next nearest entry, nullptr when there is none left or the rest was dropped
+        Data *next();
+
+        // Distance of the entry last returned by next()
+        double getDistance() const;
+
+        // True when entries were dropped to honour maxQueueSize, so the end of browsing may have
+        // come before the end of the tree
+        bool isTruncated() const;
+
+        size_t getQueueSize() const;
+
+    private:
+        struct Candidate
+        {
+            double distance; // squared
+            Node *node;
+            Data *data;
+        };
+
+        Point m_point;
+        size_t m_maxQueueSize;
+        // Min-heap on distance, kept with std::push_heap/pop_heap so that it can be trimmed
+        std::vector<Candidate> m_queue;
+        double m_distance = 0.0;
+        // Smallest squared distance dropped from the queue; results stop short of it
+        double m_truncatedDistance;
+        bool m_truncated = false;
+
+        void push(double distance, Node *node, Data *data);
+        void trim();
+        static bool fartherThan(const Candidate &a, const Candidate &b);
+    };
+}
+
+#endif //NEARESTNEIGHBORCURSOR_H
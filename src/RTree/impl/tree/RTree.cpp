@@ -1,7 +1,19 @@
 #include "RTree.h"
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <queue>
 #include <stack>
+#include <stdexcept>
 
+#include "src/RTree/impl/bulk/BulkOrdering.h"
+#include "src/RTree/impl/concurrency/ThreadPool.h"
 #include "src/RTree/impl/node/InternalNode.h"
 #include "src/RTree/impl/node/LeafNode.h"
 #include "src/RTree/impl/strategy/LinearSplitStrategy.h"
@@ -12,13 +24,14 @@ namespace RTree
     RTree::RTree(const uint32_t dimension, const uint32_t nodeCapacity, const SplitStrategy *splitStrategy)
         : m_dimension(dimension), m_nodeCapacity(nodeCapacity), m_splitStrategy(splitStrategy)
     {
-        m_root_node = new LeafNode(nodeCapacity, m_splitStrategy, metricManager);
-        m_root_node->setTree(this); // Set tree pointer for the root node
+        // Data destructors release nothing when the regions fit the inline buffer
+        m_dataPool.setTrivialTeardown(dimension <= Region::kInlineDimensions);
+        m_root_node = createLeafNode();
     }
 
     RTree::~RTree()
     {
-        delete m_root_node;
+        // Nodes and entries are released with their pools
         delete metricManager;
     }
 
@@ -26,7 +39,7 @@ namespace RTree
     {
         auto insertStartTime = std::chrono::high_resolution_clock::now();
         // Create data object
-        Data *data = new Data(mbr, id);
+        Data *data = createData(mbr, id);
         // Insert data
         insertData_impl(data);
         auto insertEndTime = std::chrono::high_resolution_clock::now();
@@ -38,72 +51,477 @@ namespace RTree
 
     bool RTree::remove(const Region &mbr, id_type id)
     {
-        return m_root_node->remove(id, mbr);
+        auto [leaf, index] = locateEntry(id, mbr);
+        if (leaf == nullptr)
+        {
+            return false;
+        }
+
+        removeEntry(leaf, index);
+        condenseTree(leaf);
+        return true;
     }
 
-    std::vector<Data *> RTree::intersectionQuery(const Region &query)
+    void RTree::setMinimumFill(double fraction)
     {
-        auto startTime = std::chrono::high_resolution_clock::now();
-        auto result = m_root_node->search(query);
-        auto endTime = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
-                                  endTime - startTime)
-                                  .count();
-        metricManager->record_range_query_time(!result.empty(), duration);
+        if (!(fraction >= 0.0 && fraction <= 0.5))
+        {
+            throw std::invalid_argument("minimum fill must be within [0, 0.5]");
+        }
+        m_minimumFill = fraction;
+    }
 
-        return result;
+    double RTree::getMinimumFill() const
+    {
+        return m_minimumFill;
     }
 
-    std::vector<Data *> RTree::containmentQuery(const Region &query)
+    void RTree::enableIdIndex()
+    {
+        m_idIndexEnabled = true;
+        rebuildIdIndex();
+    }
+
+    void RTree::disableIdIndex()
+    {
+        m_idIndexEnabled = false;
+        std::unordered_map<id_type, LeafNode *>().swap(m_idIndex);
+    }
+
+    bool RTree::hasIdIndex() const
     {
-        std::vector<Data *> intersectedResults = m_root_node->search(query);
-        std::vector<Data *> containedResults;
+        return m_idIndexEnabled;
+    }
+
+    Data *RTree::findById(id_type id) const
+    {
+        if (!m_idIndexEnabled)
+        {
+            throw std::logic_error("findById needs the id index");
+        }
+
+        auto [leaf, index] = locateEntry(id, Region(0));
+        return leaf == nullptr ? nullptr : leaf->m_entries[index];
+    }
+
+    bool RTree::removeById(id_type id)
+    {
+        if (!m_idIndexEnabled)
+        {
+            throw std::logic_error("removeById needs the id index");
+        }
+
+        return remove(Region(0), id);
+    }
+
+    bool RTree::update(id_type id, const Region &oldRegion, const Region &newRegion)
+    {
+        auto [leaf, index] = locateEntry(id, oldRegion);
+        if (leaf == nullptr)
+        {
+            return false;
+        }
+
+        Data *data = leaf->m_entries[index];
+        data->setRegion(newRegion);
+        InternalNode *parent = leaf->getParent();
+        auto updateInPlace = [&]()
+        {
+            leaf->refreshEntry(index);
+            tightenUpward(leaf);
+        };
+
+        // Still inside the leaf: only shrinking MBRs to tighten
+        if (parent == nullptr || leaf->getMBR().contains(newRegion))
+        {
+            updateInPlace();
+            return true;
+        }
 
-        // Filter out results that are fully contained
-        for (Data *data : intersectedResults)
+        // A sibling already covering the new region takes the entry, no MBR grows. Not when that
+        // would leave the leaf underfull, which would cost far more than the move saves.
+        for (Node *child : parent->m_children)
         {
-            if (query.contains(data->getRegion()))
+            if (leaf->size() > minimumEntries() && child != leaf && child->size() < m_nodeCapacity &&
+                child->getMBR().contains(newRegion))
             {
-                containedResults.push_back(data);
+                auto *sibling = static_cast<LeafNode *>(child);
+                leaf->detachEntry(index);
+                sibling->appendEntry(data);
+                indexEntry(id, sibling);
+                tightenUpward(leaf);
+                return true;
             }
         }
 
-        return containedResults;
+        // Growing the leaf within its parent's MBR leaves the ancestors' MBRs as they are
+        if (parent->getMBR().contains(newRegion))
+        {
+            updateInPlace();
+            return true;
+        }
+
+        // Too far: out of the leaf and in again from the root
+        leaf->detachEntry(index);
+        condenseTree(leaf);
+        insertData_impl(data);
+        return true;
     }
 
-    std::vector<Data *> RTree::pointQuery(const Point &point)
+    namespace
     {
-        // Create a tiny region for point query
-        double coords[m_dimension * 2];
-        for (uint32_t i = 0; i < m_dimension; ++i)
+        // Center of every region, dimension coordinates per item, as the bulk orderings expect
+        template <typename GetRegion>
+        std::vector<double> collectCenters(size_t count, uint32_t dimension, GetRegion getRegion, ThreadPool *pool)
         {
-            coords[i] = point.getCoordinate(i);
-            coords[i + m_dimension] = point.getCoordinate(i);
+            std::vector<double> centers(count * dimension);
+            parallelFor(pool, count, [&](size_t begin, size_t end)
+                        {
+                            for (size_t i = begin; i < end; ++i)
+                            {
+                                const Region &region = getRegion(i);
+                                for (uint32_t d = 0; d < dimension; ++d)
+                                {
+                                    centers[i * dimension + d] = (region.getLow(d) + region.getHigh(d)) / 2.0;
+                                }
+                            }
+                        });
+            return centers;
         }
 
-        Region pointRegion(coords, coords + m_dimension, m_dimension);
+        // Forwards the matches of the filtering region search that pass the exact test,
+        // remembering whether anything was found for the query metrics
+        template <typename Predicate>
+        class FilterVisitor : public Visitor
+        {
+        public:
+            FilterVisitor(Visitor &visitor, Predicate predicate) : m_visitor(visitor), m_predicate(predicate) {}
+
+            void visitData(Data *data) override
+            {
+                if (m_predicate(data))
+                {
+                    m_found = true;
+                    m_visitor.visitData(data);
+                }
+            }
+
+            bool found() const
+            {
+                return m_found;
+            }
+
+        private:
+            Visitor &m_visitor;
+            Predicate m_predicate;
+            bool m_found = false;
+        };
+
+        template <typename Predicate>
+        FilterVisitor<Predicate> makeFilterVisitor(Visitor &visitor, Predicate predicate)
+        {
+            return FilterVisitor<Predicate>(visitor, predicate);
+        }
+    }
+
+    void RTree::bulkLoad(const std::vector<BulkEntry> &entries, BulkLoadMethod method, double fillFactor,
+                         unsigned threadCount)
+    {
+        bulkLoad(entries.data(), entries.size(), method, fillFactor, threadCount);
+    }
+
+    void RTree::bulkLoad(const BulkEntry *entries, size_t count, BulkLoadMethod method, double fillFactor,
+                         unsigned threadCount)
+    {
+        if (!(fillFactor > 0.0 && fillFactor <= 1.0))
+        {
+            throw std::invalid_argument("fill factor must be within (0, 1]");
+        }
+        // A level of single-entry nodes would never shrink to one root
+        if (m_nodeCapacity < 2)
+        {
+            throw std::invalid_argument("bulk load needs a node capacity of at least 2");
+        }
 
         auto startTime = std::chrono::high_resolution_clock::now();
-        const std::vector<Data *> intersectedResults = m_root_node->search(pointRegion);
+
+        clear();
+
+        std::unique_ptr<ThreadPool> pool;
+        if (threadCount != 1)
+        {
+            pool = std::make_unique<ThreadPool>(threadCount);
+        }
+
+        // Entries per node; at least two so that every level shrinks
+        const uint32_t perNode = std::clamp<uint32_t>(static_cast<uint32_t>(fillFactor * m_nodeCapacity), 2,
+                                                      m_nodeCapacity);
+
+        // Order the entries so that every run of perNode of them makes a compact leaf
+        std::vector<double> centers = collectCenters(
+            count, m_dimension, [entries](size_t i) -> const Region & { return entries[i].first; }, pool.get());
+        std::vector<size_t> order = packingOrder(centers, count, method, perNode, pool.get());
+
+        // Pack the leaves. Their slots are taken from the pools up front, in the order a sequential
+        // build would take them, so that the leaves themselves can be filled in parallel.
+        const size_t leafCount = (count + perNode - 1) / perNode;
+        std::vector<Data *> data(count);
+        std::vector<LeafNode *> leaves(leafCount);
+        m_dataPool.allocate(count, data.data());
+        m_leafPool.allocate(leafCount, leaves.data());
+        parallelFor(pool.get(), leafCount, [&](size_t begin, size_t end)
+                    {
+                        for (size_t l = begin; l < end; ++l)
+                        {
+                            LeafNode *leaf = new (leaves[l]) LeafNode(m_dimension, m_nodeCapacity, m_splitStrategy,
+                                                                      metricManager);
+                            leaf->setTree(this);
+                            const size_t last = std::min<size_t>((l + 1) * perNode, count);
+                            for (size_t i = l * perNode; i < last; ++i)
+                            {
+                                const BulkEntry &entry = entries[order[i]];
+                                leaf->appendEntry(new (data[i]) Data(entry.first, entry.second));
+                            }
+                            leaf->recalculateMBR();
+                        }
+                    });
+
+        // Then the internal levels on top of them until one node is left
+        std::vector<Node *> level(leaves.begin(), leaves.end());
+        while (level.size() > 1)
+        {
+            level = packInternalLevel(level, method, perNode, pool.get());
+        }
+        m_root_node = level.empty() ? createLeafNode() : level.front();
+        if (m_idIndexEnabled)
+        {
+            rebuildIdIndex();
+        }
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        metricManager->record_bulk_load_time(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                 endTime - startTime)
+                                                 .count());
+    }
+
+    std::vector<Data *> RTree::intersectionQuery(const Region &query)
+    {
+        std::vector<Data *> result;
+        intersectionQuery(query, std::back_inserter(result));
+        return result;
+    }
+
+    std::vector<Data *> RTree::containmentQuery(const Region &query)
+    {
+        std::vector<Data *> result;
+        containmentQuery(query, std::back_inserter(result));
+        return result;
+    }
+
+    std::vector<Data *> RTree::pointQuery(const Point &point)
+    {
+        std::vector<Data *> result;
+        pointQuery(point, std::back_inserter(result));
+        return result;
+    }
+
+    std::vector<std::vector<Data *>> RTree::intersectionQueryBatch(const std::vector<Region> &queries)
+    {
+        std::vector<std::vector<Data *>> results(queries.size());
+        std::vector<uint32_t> active(queries.size());
+        std::iota(active.begin(), active.end(), 0);
+        m_root_node->searchBatch(queries.data(), active.data(), active.size(), results);
+        return results;
+    }
+
+    std::vector<std::vector<Data *>> RTree::intersectionQueryBatch(const std::vector<Region> &queries,
+                                                                   ThreadPool &pool)
+    {
+        // Small chunks balance the load across workers, large ones share more node visits
+        constexpr size_t kChunk = 256;
+        const size_t chunkCount = (queries.size() + kChunk - 1) / kChunk;
+
+        std::vector<std::vector<Data *>> results(queries.size());
+        std::vector<uint32_t> active(queries.size());
+        std::iota(active.begin(), active.end(), 0);
+
+        // Every query belongs to exactly one chunk, so each result list has a single writer
+        std::atomic<size_t> nextChunk{0};
+        parallelFor(&pool, std::min<size_t>(chunkCount, pool.getThreadCount()), [&](size_t, size_t)
+                    {
+                        for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+                        {
+                            const size_t begin = chunk * kChunk;
+                            const size_t count = std::min(kChunk, queries.size() - begin);
+                            m_root_node->searchBatch(queries.data(), active.data() + begin, count, results);
+                        }
+                    });
+        return results;
+    }
+
+    void RTree::intersectionQuery(const Region &query, Visitor &visitor)
+    {
+        auto filter = makeFilterVisitor(visitor, [](const Data *) { return true; });
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+        m_root_node->search(query, filter);
         auto endTime = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
                                   endTime - startTime)
                                   .count();
+        metricManager->record_range_query_time(filter.found(), duration);
+    }
 
-        std::vector<Data *> pointResults;
+    void RTree::containmentQuery(const Region &query, Visitor &visitor)
+    {
+        // Filter out results that are not fully contained
+        auto filter = makeFilterVisitor(visitor, [&query](const Data *data)
+                                        { return query.contains(data->getRegion()); });
+        m_root_node->search(query, filter);
+    }
+
+    void RTree::pointQuery(const Point &point, Visitor &visitor)
+    {
+        // Create a tiny region for point query
+        Region pointRegion(point, point);
+
+        // Filter out results that do not contain the point
+        auto filter = makeFilterVisitor(visitor, [&point](const Data *data)
+                                        { return data->getRegion().contains(point); });
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+        m_root_node->search(pointRegion, filter);
+        auto endTime = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+                                  endTime - startTime)
+                                  .count();
 
-        // Filter out results that contain the point
-        for (Data *data : intersectedResults)
+        metricManager->record_point_query_time(filter.found(), duration);
+    }
+
+    std::vector<Data *> RTree::nearestNeighbors(const Point &point, uint32_t k)
+    {
+        if (point.getDimension() != m_dimension)
         {
-            if (data->getRegion().contains(point))
+            throw std::invalid_argument("Dimensions do not match");
+        }
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+
+        // Best-first search: nodes and entries come off the queue by increasing MINDIST, so an entry
+        // popped before anything else is closer than all that is left. Distances stay squared.
+        struct Candidate
+        {
+            double distance;
+            Node *node;
+            Data *data;
+
+            // Entries before nodes at equal distance, they can be reported right away
+            bool operator>(const Candidate &other) const
             {
-                pointResults.push_back(data);
+                return distance > other.distance || (distance == other.distance && data == nullptr && other.data != nullptr);
             }
+        };
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<>> queue;
+
+        // Upper bound on the distance of the k-th nearest entry; anything whose MINDIST exceeds it can
+        // be dropped. Fed by the exact distances of entries seen so far (the k smallest) and, for
+        // every expanded node, by the k-th smallest MINMAXDIST of its children: the subtrees are
+        // disjoint, so each of those k children is known to hold a different entry within its bound.
+        double pruneDistance = std::numeric_limits<double>::max();
+        std::priority_queue<double> nearestSeen;
+        std::vector<double> childBounds;
+        auto tighten = [&](std::vector<double> &bounds)
+        {
+            if (k > 0 && bounds.size() >= k)
+            {
+                std::nth_element(bounds.begin(), bounds.begin() + (k - 1), bounds.end());
+                pruneDistance = std::min(pruneDistance, bounds[k - 1]);
+            }
+        };
+
+        const double *coords = point.getCoordinates();
+        std::vector<Data *> result;
+        if (k > 0 && m_root_node->size() > 0)
+        {
+            queue.push({0.0, m_root_node, nullptr});
         }
 
-        metricManager->record_point_query_time(!pointResults.empty(), duration);
+        while (!queue.empty() && result.size() < k)
+        {
+            const Candidate candidate = queue.top();
+            queue.pop();
+            if (candidate.distance > pruneDistance)
+            {
+                break;
+            }
+
+            if (candidate.data != nullptr)
+            {
+                result.push_back(candidate.data);
+                continue;
+            }
+
+            childBounds.clear();
+            if (candidate.node->isLeaf())
+            {
+                auto *leaf = static_cast<LeafNode *>(candidate.node);
+                for (size_t i = 0; i < leaf->m_entries.size(); ++i)
+                {
+                    const double distance = leaf->m_entryMBRs.getMinDistanceSquared(i, coords);
+                    if (nearestSeen.size() < k)
+                    {
+                        nearestSeen.push(distance);
+                    }
+                    else if (distance < nearestSeen.top())
+                    {
+                        nearestSeen.pop();
+                        nearestSeen.push(distance);
+                    }
+                    if (nearestSeen.size() == k)
+                    {
+                        pruneDistance = std::min(pruneDistance, nearestSeen.top());
+                    }
+                    if (distance <= pruneDistance)
+                    {
+                        queue.push({distance, nullptr, leaf->m_entries[i]});
+                    }
+                }
+            }
+            else
+            {
+                auto *node = static_cast<InternalNode *>(candidate.node);
+                for (size_t i = 0; i < node->m_children.size(); ++i)
+                {
+                    childBounds.push_back(node->m_childMBRs.getMinMaxDistanceSquared(i, coords));
+                }
+                tighten(childBounds);
+                for (size_t i = 0; i < node->m_children.size(); ++i)
+                {
+                    const double distance = node->m_childMBRs.getMinDistanceSquared(i, coords);
+                    if (distance <= pruneDistance)
+                    {
+                        queue.push({distance, node->m_children[i], nullptr});
+                    }
+                }
+            }
+        }
+
+        auto endTime = std::chrono::high_resolution_clock::now();
+        metricManager->record_knn_query_time(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                 endTime - startTime)
+                                                 .count());
+        return result;
+    }
+
+    NearestNeighborCursor RTree::nearestNeighborCursor(const Point &point, size_t maxQueueSize) const
+    {
+        return NearestNeighborCursor(*this, point, maxQueueSize);
+    }
 
-        return pointResults;
+    FrozenRTree RTree::freeze(BoxEncoding encoding) const
+    {
+        return FrozenRTree(*this, encoding);
     }
 
     uint32_t RTree::getDimension() const
@@ -128,6 +546,8 @@ namespace RTree
 
     void RTree::construction_finished() const {
         std::vector<double> node_capacity_percent = {};
+        // Internal nodes below the root, whose fill is not constrained
+        std::vector<double> internal_capacity_percent = {};
         // capacity -> average, mean
 
         std::stack<Node*> s;
@@ -144,6 +564,8 @@ namespace RTree
                         double percent = static_cast<double>(child->size()) / static_cast<double>(m_nodeCapacity);
                         node_capacity_percent.push_back(percent);
                     } else {
+                        double percent = static_cast<double>(child->size()) / static_cast<double>(m_nodeCapacity);
+                        internal_capacity_percent.push_back(percent);
                         s.push(child);
                     }
                 }
@@ -153,6 +575,133 @@ namespace RTree
         uint32_t height = getHeight();
 
         metricManager->record_post_construction_metrics(height, node_capacity_percent);
+        metricManager->record_internal_node_metrics(internal_capacity_percent);
+
+        if (!m_root_node->isLeaf() && m_root_node->getMBR().getDimension() == m_dimension) {
+            recordNodeEncodingMetrics();
+        }
+    }
+
+    void RTree::recordNodeEncodingMetrics() const
+    {
+        // Up to kProbes entry centers spread evenly over the leaves, as the points queries ask for
+        constexpr size_t kProbes = 1000;
+        std::vector<const InternalNode *> internals;
+        std::vector<const LeafNode *> leaves;
+        std::vector<const Node *> pending{m_root_node};
+        size_t entryCount = 0;
+        while (!pending.empty())
+        {
+            const Node *node = pending.back();
+            pending.pop_back();
+            if (node->isLeaf())
+            {
+                leaves.push_back(static_cast<const LeafNode *>(node));
+                entryCount += leaves.back()->m_ids.size();
+                continue;
+            }
+            internals.push_back(static_cast<const InternalNode *>(node));
+            pending.insert(pending.end(), internals.back()->m_children.begin(), internals.back()->m_children.end());
+        }
+
+        std::vector<double> probes;
+        const size_t probeStride = std::max<size_t>(1, entryCount / kProbes);
+        size_t seen = 0;
+        for (const LeafNode *leaf : leaves)
+        {
+            for (size_t i = 0; i < leaf->m_ids.size(); ++i, ++seen)
+            {
+                if (seen % probeStride != 0)
+                {
+                    continue;
+                }
+                for (uint32_t d = 0; d < m_dimension; ++d)
+                {
+                    probes.push_back((leaf->m_entryMBRs.lows(d)[i] + leaf->m_entryMBRs.highs(d)[i]) / 2);
+                }
+            }
+        }
+
+        // Per BoxEncoding, the bytes a frozen internal node takes, and the false positives of the
+        // quantized boxes: of the child boxes a probe falls in once decoded, the fraction whose
+        // exact box it misses. Probes descend wherever the decoded boxes let them, as queries do.
+        const BoxEncoding encodings[] = {BoxEncoding::Exact, BoxEncoding::Quantized16, BoxEncoding::Quantized8};
+        const size_t coordinateBytes[] = {sizeof(double), sizeof(uint16_t), sizeof(uint8_t)};
+        for (size_t e = 0; e < 3; ++e)
+        {
+            const BoxQuantizer quantizer(encodings[e]);
+            std::vector<double> nodeBytes;
+            for (const InternalNode *node : internals)
+            {
+                const size_t boxBytes = node->m_children.size() * 2 * m_dimension * coordinateBytes[e];
+                nodeBytes.push_back(static_cast<double>(sizeof(FlatNode) + boxBytes));
+            }
+
+            size_t decodedHits = 0;
+            size_t exactHits = 0;
+            std::vector<double> exact(2 * m_dimension);
+            std::vector<uint32_t> codes(2 * m_dimension);
+            for (size_t p = 0; p < probes.size(); p += m_dimension)
+            {
+                const double *probe = probes.data() + p;
+                const Region &root = m_root_node->getMBR();
+                std::vector<std::pair<const InternalNode *, std::vector<double>>> frames;
+                frames.emplace_back(static_cast<const InternalNode *>(m_root_node),
+                                    std::vector<double>(root.getLowCoordinates(),
+                                                        root.getLowCoordinates() + 2 * m_dimension));
+                while (!frames.empty())
+                {
+                    auto [node, frame] = std::move(frames.back());
+                    frames.pop_back();
+                    for (size_t i = 0; i < node->m_children.size(); ++i)
+                    {
+                        for (uint32_t d = 0; d < m_dimension; ++d)
+                        {
+                            exact[d] = node->m_childMBRs.lows(d)[i];
+                            exact[m_dimension + d] = node->m_childMBRs.highs(d)[i];
+                        }
+                        std::vector<double> decoded = exact;
+                        if (encodings[e] != BoxEncoding::Exact)
+                        {
+                            quantizer.encode(frame.data(), m_dimension, exact.data(), exact.data() + m_dimension,
+                                             codes.data());
+                            for (uint32_t d = 0; d < 2 * m_dimension; ++d)
+                            {
+                                decoded[d] = quantizer.decode(frame[d % m_dimension],
+                                                              frame[m_dimension + d % m_dimension], codes[d]);
+                            }
+                        }
+
+                        auto contains = [&](const std::vector<double> &box)
+                        {
+                            for (uint32_t d = 0; d < m_dimension; ++d)
+                            {
+                                if (probe[d] < box[d] || probe[d] > box[m_dimension + d])
+                                {
+                                    return false;
+                                }
+                            }
+                            return true;
+                        };
+                        if (!contains(decoded))
+                        {
+                            continue;
+                        }
+                        ++decodedHits;
+                        exactHits += contains(exact);
+                        if (!node->m_children[i]->isLeaf())
+                        {
+                            frames.emplace_back(static_cast<const InternalNode *>(node->m_children[i]),
+                                                std::move(decoded));
+                        }
+                    }
+                }
+            }
+
+            const double falsePositiveRate =
+                decodedHits == 0 ? 0.0 : static_cast<double>(decodedHits - exactHits) / decodedHits;
+            metricManager->record_node_encoding_metrics(e, nodeBytes, falsePositiveRate);
+        }
     }
 
     void RTree::print_construction_metrics(std::string name) const {
@@ -167,7 +716,18 @@ namespace RTree
         metricManager->print_range_query_metrics(name, window);
     }
 
+    void RTree::print_knn_query_metrics(std::string name, uint32_t k) const {
+        metricManager->print_knn_query_metrics(name, k);
+    }
+
     void RTree::insertData_impl(Data *data) {
+        // A root emptied by the removes of a ConcurrentRTree has no child to descend into
+        if (!m_root_node->isLeaf() && m_root_node->isEmpty())
+        {
+            destroyNode(m_root_node);
+            m_root_node = createLeafNode();
+        }
+
         // Insert data into the root node
         m_root_node->insert(data);
 
@@ -178,12 +738,8 @@ namespace RTree
 
             if (newNode)
             {
-                // Set tree pointer for new node
-                newNode->setTree(this);
-
                 // Create a new internal node as root
-                auto *newRoot = new InternalNode(m_nodeCapacity, m_splitStrategy, metricManager);
-                newRoot->setTree(this); // Set tree pointer for new root
+                InternalNode *newRoot = createInternalNode();
                 newRoot->addChild(original);
                 newRoot->addChild(newNode);
 
@@ -192,13 +748,353 @@ namespace RTree
         }
     }
 
+    void RTree::clear()
+    {
+        m_leafPool.clear();
+        m_internalPool.clear();
+        m_dataPool.clear();
+        m_idIndex.clear();
+        m_root_node = nullptr;
+    }
+
+    std::pair<LeafNode *, size_t> RTree::locateEntry(id_type id, const Region &region) const
+    {
+        auto indexIn = [id](const LeafNode *leaf)
+        {
+            return static_cast<size_t>(std::find(leaf->m_ids.begin(), leaf->m_ids.end(), id) - leaf->m_ids.begin());
+        };
+
+        if (m_idIndexEnabled)
+        {
+            auto it = m_idIndex.find(id);
+            if (it == m_idIndex.end())
+            {
+                return {nullptr, 0};
+            }
+            return {it->second, indexIn(it->second)};
+        }
+
+        std::vector<Node *> pending{m_root_node};
+        while (!pending.empty())
+        {
+            Node *node = pending.back();
+            pending.pop_back();
+            if (node->isLeaf())
+            {
+                auto *leaf = static_cast<LeafNode *>(node);
+                const size_t index = indexIn(leaf);
+                if (index < leaf->m_ids.size())
+                {
+                    return {leaf, index};
+                }
+                continue;
+            }
+
+            auto *internal = static_cast<InternalNode *>(node);
+            internal->m_childMBRs.forEachIntersecting(region, [&](size_t i)
+                                                      { pending.push_back(internal->m_children[i]); });
+        }
+        return {nullptr, 0};
+    }
+
+    void RTree::removeEntry(LeafNode *leaf, size_t index)
+    {
+        if (m_idIndexEnabled)
+        {
+            m_idIndex.erase(leaf->m_ids[index]);
+        }
+        destroyData(leaf->m_entries[index]);
+        leaf->detachEntry(index);
+    }
+
+    size_t RTree::minimumEntries() const
+    {
+        return std::max<size_t>(1, static_cast<size_t>(m_minimumFill * m_nodeCapacity));
+    }
+
+    void RTree::tightenUpward(Node *node)
+    {
+        for (InternalNode *parent = node->getParent(); parent != nullptr; node = parent, parent = parent->getParent())
+        {
+            const size_t child = std::find(parent->m_children.begin(), parent->m_children.end(), node) -
+                                 parent->m_children.begin();
+            const Region before = parent->m_mbr;
+            parent->updateChild(child);
+            if (parent->m_mbr == before)
+            {
+                return;
+            }
+        }
+    }
+
+    void RTree::condenseTree(LeafNode *leaf)
+    {
+        // Up to the root: underfull nodes are detached and freed, their entries or children kept
+        // aside, and the MBRs brought up to date on the way
+        std::vector<Data *> orphanEntries;
+        std::vector<std::pair<uint32_t, Node *>> orphanSubtrees; // (height, subtree)
+        Node *node = leaf;
+        uint32_t height = 1;
+        for (InternalNode *parent = node->getParent(); parent != nullptr;
+             node = parent, parent = parent->getParent(), ++height)
+        {
+            const size_t child = std::find(parent->m_children.begin(), parent->m_children.end(), node) -
+                                 parent->m_children.begin();
+            if (node->size() < minimumEntries())
+            {
+                if (node->isLeaf())
+                {
+                    const auto &entries = static_cast<LeafNode *>(node)->m_entries;
+                    orphanEntries.insert(orphanEntries.end(), entries.begin(), entries.end());
+                }
+                else
+                {
+                    for (Node *orphan : static_cast<InternalNode *>(node)->m_children)
+                    {
+                        orphanSubtrees.emplace_back(height - 1, orphan);
+                    }
+                }
+                parent->removeChild(child);
+                destroyNode(node);
+            }
+            else
+            {
+                parent->updateChild(child);
+            }
+        }
+        uint32_t rootHeight = height;
+
+        // A root left without children gives way to the highest orphaned subtree, or to an empty
+        // leaf; inserting into a childless internal node has nowhere to go
+        if (!m_root_node->isLeaf() && m_root_node->isEmpty())
+        {
+            destroyNode(m_root_node);
+            auto highest = std::max_element(orphanSubtrees.begin(), orphanSubtrees.end(),
+                                            [](const auto &a, const auto &b)
+                                            { return a.first < b.first; });
+            if (highest == orphanSubtrees.end())
+            {
+                m_root_node = createLeafNode();
+                rootHeight = 1;
+            }
+            else
+            {
+                m_root_node = highest->second;
+                m_root_node->setParent(nullptr);
+                rootHeight = highest->first;
+                orphanSubtrees.erase(highest);
+            }
+        }
+
+        // Orphans go back at their own level, the highest first while the tree is still as tall
+        std::stable_sort(orphanSubtrees.begin(), orphanSubtrees.end(),
+                         [](const auto &a, const auto &b)
+                         { return a.first > b.first; });
+        for (auto &[subtreeHeight, subtree] : orphanSubtrees)
+        {
+            insertSubtree(subtree, subtreeHeight, rootHeight);
+        }
+        for (Data *data : orphanEntries)
+        {
+            insertData_impl(data);
+        }
+
+        // A root with a single child adds a level and nothing else
+        while (!m_root_node->isLeaf() && m_root_node->size() == 1)
+        {
+            Node *child = static_cast<InternalNode *>(m_root_node)->m_children[0];
+            destroyNode(m_root_node);
+            child->setParent(nullptr);
+            m_root_node = child;
+        }
+    }
+
+    void RTree::insertSubtree(Node *subtree, uint32_t subtreeHeight, uint32_t &rootHeight)
+    {
+        auto growRoot = [&](Node *first, Node *second)
+        {
+            InternalNode *newRoot = createInternalNode();
+            newRoot->addChild(first);
+            newRoot->addChild(second);
+            m_root_node = newRoot;
+            ++rootHeight;
+        };
+
+        // As tall as the tree: the two become the children of a new root
+        if (subtreeHeight >= rootHeight)
+        {
+            growRoot(m_root_node, subtree);
+            return;
+        }
+
+        // Down to the level above the subtree, the way an entry would go
+        Node *node = m_root_node;
+        for (uint32_t level = rootHeight; level > subtreeHeight + 1; --level)
+        {
+            node = static_cast<InternalNode *>(node)->chooseSubtree(subtree->getMBR());
+        }
+        static_cast<InternalNode *>(node)->addChild(subtree);
+
+        // Back up, splitting what overflows and re-reading the MBRs
+        for (auto *current = static_cast<InternalNode *>(node); current != nullptr;)
+        {
+            InternalNode *above = current->getParent();
+            if (current->shouldSplit())
+            {
+                auto [original, newNode] = current->split();
+                if (newNode != nullptr && above == nullptr)
+                {
+                    growRoot(original, newNode);
+                    return;
+                }
+                if (newNode != nullptr)
+                {
+                    above->addChild(newNode);
+                }
+            }
+            if (above != nullptr)
+            {
+                above->updateChild(std::find(above->m_children.begin(), above->m_children.end(), current) -
+                                   above->m_children.begin());
+            }
+            current = above;
+        }
+    }
+
+    void RTree::rebuildIdIndex()
+    {
+        m_idIndex.clear();
+        if (m_root_node == nullptr)
+        {
+            return;
+        }
+
+        m_root_node->setParent(nullptr);
+        std::vector<Node *> pending{m_root_node};
+        while (!pending.empty())
+        {
+            Node *node = pending.back();
+            pending.pop_back();
+            if (node->isLeaf())
+            {
+                auto *leaf = static_cast<LeafNode *>(node);
+                for (id_type id : leaf->m_ids)
+                {
+                    m_idIndex[id] = leaf;
+                }
+                continue;
+            }
+
+            auto *internal = static_cast<InternalNode *>(node);
+            for (Node *child : internal->m_children)
+            {
+                child->setParent(internal);
+                pending.push_back(child);
+            }
+        }
+    }
+
+    std::vector<size_t> RTree::packingOrder(const std::vector<double> &centers, size_t count,
+                                            BulkLoadMethod method, uint32_t perNode, ThreadPool *pool) const
+    {
+        std::vector<size_t> order(count);
+        std::iota(order.begin(), order.end(), 0);
+        switch (method)
+        {
+        case BulkLoadMethod::SortTileRecursive:
+            bulk::sortTileRecursive(centers.data(), m_dimension, perNode, order.data(), order.data() + count, pool);
+            break;
+        case BulkLoadMethod::Hilbert:
+            bulk::hilbertSort(centers.data(), m_dimension, order.data(), order.data() + count, pool);
+            break;
+        }
+        return order;
+    }
+
+    std::vector<Node *> RTree::packInternalLevel(const std::vector<Node *> &nodes, BulkLoadMethod method,
+                                                 uint32_t perNode, ThreadPool *pool)
+    {
+        std::vector<size_t> order(nodes.size());
+        if (method == BulkLoadMethod::Hilbert)
+        {
+            // The level was produced in curve order already, neighbours stay neighbours
+            std::iota(order.begin(), order.end(), 0);
+        }
+        else
+        {
+            std::vector<double> centers = collectCenters(
+                nodes.size(), m_dimension, [&nodes](size_t i) -> const Region & { return nodes[i]->getMBR(); },
+                pool);
+            order = packingOrder(centers, nodes.size(), method, perNode, pool);
+        }
+
+        std::vector<Node *> parents;
+        parents.reserve((nodes.size() + perNode - 1) / perNode);
+        for (size_t begin = 0; begin < nodes.size(); begin += perNode)
+        {
+            InternalNode *parent = createInternalNode();
+            const size_t end = std::min<size_t>(begin + perNode, nodes.size());
+            for (size_t i = begin; i < end; ++i)
+            {
+                Node *child = nodes[order[i]];
+                child->setParent(parent);
+                parent->m_children.push_back(child);
+                parent->m_childMBRs.push_back(child->getMBR());
+            }
+            // One MBR pass per node instead of one per child as addChild would do
+            parent->recalculateMBR();
+            parents.push_back(parent);
+        }
+        return parents;
+    }
+
     void RTree::handleRstarReinsertion(std::vector<Data *> &dataEntries)
     {
-        // So far just call inseart again
+        // The entries were detached from their leaf, so insert them again as they are
         for (Data *data : dataEntries)
         {
-            Data *dataClone = data->clone();
-            insertData_impl(dataClone);
+            insertData_impl(data);
+        }
+    }
+
+    LeafNode *RTree::createLeafNode()
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        LeafNode *node = m_leafPool.create(m_dimension, m_nodeCapacity, m_splitStrategy, metricManager);
+        node->setTree(this);
+        return node;
+    }
+
+    InternalNode *RTree::createInternalNode()
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        InternalNode *node = m_internalPool.create(m_dimension, m_nodeCapacity, m_splitStrategy, metricManager);
+        node->setTree(this);
+        return node;
+    }
+
+    Data *RTree::createData(const Region &mbr, id_type id)
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        return m_dataPool.create(mbr, id);
+    }
+
+    void RTree::destroyNode(Node *node)
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        if (node->isLeaf())
+        {
+            m_leafPool.destroy(static_cast<LeafNode *>(node));
         }
+        else
+        {
+            m_internalPool.destroy(static_cast<InternalNode *>(node));
+        }
+    }
+
+    void RTree::destroyData(Data *data)
+    {
+        std::lock_guard<std::mutex> lock(m_poolMutex);
+        m_dataPool.destroy(data);
     }
 } // namespace RTree
\ No newline at end of file
@@ -5,11 +5,22 @@
 #ifndef RTREE_H
 #define RTREE_H
 #include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "src/RTree/impl/common.h"
+#include "src/RTree/impl/Data.h"
+#include "src/RTree/impl/Visitor.h"
+#include "src/RTree/impl/memory/ObjectPool.h"
 #include "src/RTree/impl/metric/MetricManager.h"
+#include "src/RTree/impl/node/InternalNode.h"
+#include "src/RTree/impl/node/LeafNode.h"
 #include "src/RTree/impl/strategy/LinearSplitStrategy.h"
+#include "src/RTree/impl/tree/FrozenRTree.h"
+#include "src/RTree/impl/tree/NearestNeighborCursor.h"
 
 namespace RTree
 {
@@ -18,7 +29,21 @@ namespace RTree
     class Data;
     class Region;
     class SplitStrategy;
+    class ThreadPool;
 
+    // One input entry of a bulk load
+    using BulkEntry = std::pair<Region, id_type>;
+
+    // How a bulk load orders entries before packing them into nodes
+    enum class BulkLoadMethod
+    {
+        SortTileRecursive, // Tiles of every level sorted axis by axis
+        Hilbert            // Sorted once along a Hilbert curve, levels packed in curve order
+    };
+
+    // Queries (including the batch, nearest-neighbor and cursor queries) only read the tree, so
+    // any number of threads may run them concurrently as long as no thread inserts, removes or
+    // bulk loads at the same time. The metric print methods must not overlap with queries either.
     class RTree
     {
     public:
@@ -26,13 +51,109 @@ namespace RTree
         ~RTree();
 
         void insert(const Region &mbr, id_type id);
+        // Without the id index, only the subtrees whose MBRs intersect mbr are searched for id.
+        // With it, id's leaf is looked up directly and mbr is not used. The tree is then condensed:
+        // every node on the way up left with fewer entries than the minimum fill is dissolved and
+        // what it held inserted again at its own level, and a root with a single child is replaced
+        // by that child.
         bool remove(const Region &mbr, id_type id);
 
+        // Fraction of the node capacity below which remove dissolves a node, 0 to only drop empty
+        // ones. At most 0.5, as a split may leave half a node. Throws std::invalid_argument outside
+        // [0, 0.5].
+        void setMinimumFill(double fraction);
+        double getMinimumFill() const;
+
+        // Moves entry id from oldRegion to newRegion, false when there is no such entry. Without
+        // the id index, oldRegion finds the entry as remove's mbr does. Small moves are made
+        // bottom-up: in place while the entry's leaf covers newRegion, into a sibling leaf that
+        // covers it and has room, or in place growing the leaf while its parent covers newRegion.
+        // Only then is the entry taken out and inserted again from the root. The MBRs above are
+        // tightened or grown as far up as they change.
+        bool update(id_type id, const Region &oldRegion, const Region &newRegion);
+
+        // Id index: a hash map from every entry's id to the leaf holding it, kept current through
+        // inserts, splits, R* reinsertion, removes and bulk loads. Removing by id then goes straight
+        // to the leaf and tightens the MBRs back up through the parent pointers of the nodes,
+        // instead of descending every subtree that might hold the entry. Ids must be unique while
+        // it is enabled. Not supported on the tree of a ConcurrentRTree or SnapshotRTree, which
+        // change its nodes themselves.
+        void enableIdIndex();
+        void disableIdIndex();
+        bool hasIdIndex() const;
+        // The entry with id, nullptr when there is none. Throws std::logic_error without the id index.
+        Data *findById(id_type id) const;
+        // Removes the entry with id, false when there is none. Throws std::logic_error without the
+        // id index.
+        bool removeById(id_type id);
+
+        // Replace the contents of the tree with entries, packed bottom-up. Every node but the last
+        // one of each level gets fillFactor * capacity entries; below 1 leaves room for later inserts.
+        // threadCount > 1 sorts and builds the leaves on that many threads (0: all hardware
+        // threads); the tree is the same as with a single thread. Throws std::invalid_argument for
+        // a fillFactor outside (0, 1] or a node capacity below 2, the tree is left as it was.
+        void bulkLoad(const std::vector<BulkEntry> &entries,
+                      BulkLoadMethod method = BulkLoadMethod::SortTileRecursive, double fillFactor = 1.0,
+                      unsigned threadCount = 1);
+        void bulkLoad(const BulkEntry *entries, size_t count,
+                      BulkLoadMethod method = BulkLoadMethod::SortTileRecursive, double fillFactor = 1.0,
+                      unsigned threadCount = 1);
+
         // Query method - Return result set without using visitor pattern
         std::vector<Data *> intersectionQuery(const Region &query);
         std::vector<Data *> containmentQuery(const Region &query);
         std::vector<Data *> pointQuery(const Point &point);
 
+        // Query method - Stream every result to the visitor during traversal, nothing is buffered
+        void intersectionQuery(const Region &query, Visitor &visitor);
+        void containmentQuery(const Region &query, Visitor &visitor);
+        void pointQuery(const Point &point, Visitor &visitor);
+
+        // Query method - Answer many windows in one descent of the tree, sharing the visit of every
+        // node among the queries that reach it. Result i lists the entries intersecting queries[i].
+        std::vector<std::vector<Data *>> intersectionQueryBatch(const std::vector<Region> &queries);
+        // Same results, with the workers of pool taking chunks of consecutive queries off the batch
+        // and descending once per chunk. Nearby queries should be adjacent in the batch.
+        std::vector<std::vector<Data *>> intersectionQueryBatch(const std::vector<Region> &queries, ThreadPool &pool);
+
+        // Query method - Write results to an output iterator, returns the iterator past the last result
+        template <typename OutputIt, typename = std::enable_if_t<!std::is_base_of_v<Visitor, OutputIt>>>
+        OutputIt intersectionQuery(const Region &query, OutputIt out)
+        {
+            OutputIteratorVisitor<OutputIt> visitor(out);
+            intersectionQuery(query, visitor);
+            return visitor.getIterator();
+        }
+
+        template <typename OutputIt, typename = std::enable_if_t<!std::is_base_of_v<Visitor, OutputIt>>>
+        OutputIt containmentQuery(const Region &query, OutputIt out)
+        {
+            OutputIteratorVisitor<OutputIt> visitor(out);
+            containmentQuery(query, visitor);
+            return visitor.getIterator();
+        }
+
+        template <typename OutputIt, typename = std::enable_if_t<!std::is_base_of_v<Visitor, OutputIt>>>
+        OutputIt pointQuery(const Point &point, OutputIt out)
+        {
+            OutputIteratorVisitor<OutputIt> visitor(out);
+            pointQuery(point, visitor);
+            return visitor.getIterator();
+        }
+
+        // The k entries nearest to point, nearest first. Distance is measured to the closest point of
+        // an entry's region, 0 when the region contains point.
+        std::vector<Data *> nearestNeighbors(const Point &point, uint32_t k);
+
+        // Browse entries by increasing distance from point without fixing k up front, see
+        // NearestNeighborCursor; maxQueueSize caps the cursor's memory, 0 for no cap
+        NearestNeighborCursor nearestNeighborCursor(const Point &point, size_t maxQueueSize = 0) const;
+
+        // Immutable copy of the tree flattened into contiguous arrays, for answering queries once
+        // the tree has stopped changing; the tree itself is left as it is. encoding picks how the
+        // node boxes are stored, see FrozenRTree.
+        FrozenRTree freeze(BoxEncoding encoding = BoxEncoding::Exact) const;
+
         // Helper methods
         uint32_t getDimension() const;
         uint32_t getNodeCapacity() const;
@@ -49,6 +170,8 @@ namespace RTree
 
         void print_range_query_metrics(std::string name, double window) const;
 
+        void print_knn_query_metrics(std::string name, uint32_t k) const;
+
     private:
         Node *m_root_node;
         uint32_t m_dimension;
@@ -57,7 +180,73 @@ namespace RTree
 
         MetricManager *metricManager = new MetricManager();
 
+        double m_minimumFill = 0.4;
+
+        bool m_idIndexEnabled = false;
+        std::unordered_map<id_type, LeafNode *> m_idIndex;
+
+        // Every node and entry of the tree lives in these pools; the tree owns them all
+        ObjectPool<Data> m_dataPool{4096};
+        ObjectPool<LeafNode> m_leafPool{256};
+        ObjectPool<InternalNode> m_internalPool{64};
+        // Serialises the create/destroy methods below, which concurrent writers call from many threads
+        std::mutex m_poolMutex;
+
         void insertData_impl(Data *data);
+
+        // Records that leaf now holds id, when the id index is enabled
+        void indexEntry(id_type id, LeafNode *leaf)
+        {
+            if (m_idIndexEnabled)
+            {
+                m_idIndex[id] = leaf;
+            }
+        }
+        // Leaf holding entry id and its index there, searched below the MBRs intersecting region
+        // without the id index; {nullptr, 0} when there is none
+        std::pair<LeafNode *, size_t> locateEntry(id_type id, const Region &region) const;
+        // Takes entry index out of leaf and frees it
+        void removeEntry(LeafNode *leaf, size_t index);
+        // Entries or children below which a node other than the root is dissolved, at least 1
+        size_t minimumEntries() const;
+        // Re-reads node's MBR into its parent and recomputes the MBRs of the ancestors as far up
+        // as they change
+        void tightenUpward(Node *node);
+        // After entries left leaf: dissolves the underfull nodes from leaf up, tightens the MBRs
+        // of the others, inserts the orphaned entries and subtrees again and shortens the root
+        void condenseTree(LeafNode *leaf);
+        // Adds subtree, of height subtreeHeight, under a node of the level above it, splitting
+        // up the path as needed; rootHeight is the height of the tree, updated on a root split
+        void insertSubtree(Node *subtree, uint32_t subtreeHeight, uint32_t &rootHeight);
+        // Sets the parent pointers of every node and refills the id index from the leaves
+        void rebuildIdIndex();
+
+        // Bytes per internal node and false positive rate of each BoxEncoding, for construction_finished
+        void recordNodeEncodingMetrics() const;
+
+        // Drop every node and entry, leaving no root
+        void clear();
+        // Order items by their centers for packing runs of perNode of them into one node
+        std::vector<size_t> packingOrder(const std::vector<double> &centers, size_t count,
+                                         BulkLoadMethod method, uint32_t perNode, ThreadPool *pool) const;
+        // Group nodes of one level into parents of up to perNode children each
+        std::vector<Node *> packInternalLevel(const std::vector<Node *> &nodes, BulkLoadMethod method,
+                                              uint32_t perNode, ThreadPool *pool);
+
+        // Node and entry allocation, used by the nodes when they split or drop children
+        LeafNode *createLeafNode();
+        InternalNode *createInternalNode();
+        Data *createData(const Region &mbr, id_type id);
+        void destroyNode(Node *node);
+        void destroyData(Data *data);
+
+        friend class LeafNode;
+        friend class InternalNode;
+        friend class NearestNeighborCursor;
+        friend class ConcurrentRTree;
+        friend class SnapshotRTree;
+        friend class SpatialJoin;
+        friend class FrozenRTree;
     };
 
 }
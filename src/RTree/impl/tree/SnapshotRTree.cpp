@@ -0,0 +1,340 @@
+#include "SnapshotRTree.h"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+#include <type_traits>
+
+#include "src/RTree/impl/Data.h"
+#include "src/RTree/impl/Visitor.h"
+#include "src/RTree/impl/node/InternalNode.h"
+#include "src/RTree/impl/node/LeafNode.h"
+#include "src/RTree/impl/pojo/Point.h"
+
+namespace RTree
+{
+    namespace
+    {
+        // Appends the entries passing predicate to a vector or a list of ids
+        template <typename Output, typename Predicate>
+        class CollectVisitor : public Visitor
+        {
+        public:
+            CollectVisitor(Output &output, Predicate predicate) : m_output(output), m_predicate(predicate) {}
+
+            void visitData(Data *data) override
+            {
+                if (m_predicate(data))
+                {
+                    if constexpr (std::is_same_v<Output, std::vector<id_type>>)
+                    {
+                        m_output.push_back(data->getIdentifier());
+                    }
+                    else
+                    {
+                        m_output.push_back(data);
+                    }
+                }
+            }
+
+        private:
+            Output &m_output;
+            Predicate m_predicate;
+        };
+
+        template <typename Output, typename Predicate>
+        CollectVisitor<Output, Predicate> makeCollectVisitor(Output &output, Predicate predicate)
+        {
+            return CollectVisitor<Output, Predicate>(output, predicate);
+        }
+    }
+
+    SnapshotRTree::Snapshot::Snapshot(EpochManager::Guard guard, Node *root)
+        : m_guard(std::move(guard)), m_root(root)
+    {
+    }
+
+    void SnapshotRTree::Snapshot::intersectionQuery(const Region &query, Visitor &visitor) const
+    {
+        m_root->search(query, visitor);
+    }
+
+    std::vector<Data *> SnapshotRTree::Snapshot::intersectionQuery(const Region &query) const
+    {
+        std::vector<Data *> result;
+        auto collect = makeCollectVisitor(result, [](const Data *) { return true; });
+        m_root->search(query, collect);
+        return result;
+    }
+
+    std::vector<Data *> SnapshotRTree::Snapshot::pointQuery(const Point &point) const
+    {
+        std::vector<Data *> result;
+        auto collect = makeCollectVisitor(result, [&point](const Data *data)
+                                          { return data->getRegion().contains(point); });
+        m_root->search(Region(point, point), collect);
+        return result;
+    }
+
+    SnapshotRTree::SnapshotRTree(uint32_t dimension, uint32_t nodeCapacity, const SplitStrategy *splitStrategy)
+        : m_tree(dimension, nodeCapacity, splitStrategy), m_root(m_tree.m_root_node)
+    {
+    }
+
+    RTree &SnapshotRTree::getTree()
+    {
+        return m_tree;
+    }
+
+    size_t SnapshotRTree::pendingReclamation() const
+    {
+        return m_epochs.pendingCount();
+    }
+
+    SnapshotRTree::Snapshot SnapshotRTree::snapshot()
+    {
+        EpochManager::Guard guard = m_epochs.pin();
+        Node *root = m_root.load(std::memory_order_seq_cst);
+        return Snapshot(std::move(guard), root);
+    }
+
+    std::vector<id_type> SnapshotRTree::intersectionQuery(const Region &query)
+    {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        std::vector<id_type> ids;
+        {
+            Snapshot current = snapshot();
+            auto collect = makeCollectVisitor(ids, [](const Data *) { return true; });
+            current.m_root->search(query, collect);
+        }
+        m_tree.metricManager->record_range_query_time(!ids.empty(), std::chrono::duration_cast<std::chrono::microseconds>(
+                                                                         std::chrono::high_resolution_clock::now() - startTime)
+                                                                         .count());
+        return ids;
+    }
+
+    std::vector<id_type> SnapshotRTree::pointQuery(const Point &point)
+    {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        std::vector<id_type> ids;
+        {
+            Snapshot current = snapshot();
+            auto collect = makeCollectVisitor(ids, [&point](const Data *data)
+                                              { return data->getRegion().contains(point); });
+            current.m_root->search(Region(point, point), collect);
+        }
+        m_tree.metricManager->record_point_query_time(!ids.empty(), std::chrono::duration_cast<std::chrono::microseconds>(
+                                                                         std::chrono::high_resolution_clock::now() - startTime)
+                                                                         .count());
+        return ids;
+    }
+
+    void SnapshotRTree::bulkLoad(const std::vector<BulkEntry> &entries, BulkLoadMethod method, double fillFactor,
+                                 unsigned threadCount)
+    {
+        std::lock_guard<std::mutex> lock(m_writerMutex);
+        // With no reader left everything retired can go, before the pools are cleared under it
+        m_epochs.collect();
+        m_tree.bulkLoad(entries, method, fillFactor, threadCount);
+        m_root.store(m_tree.m_root_node, std::memory_order_seq_cst);
+    }
+
+    void SnapshotRTree::grow(Node *node, const Region &region)
+    {
+        Region &nodeMBR = node->isLeaf() ? static_cast<LeafNode *>(node)->m_mbr
+                                         : static_cast<InternalNode *>(node)->m_mbr;
+        if (nodeMBR.getDimension() == region.getDimension())
+        {
+            nodeMBR.combine(region);
+        }
+        else
+        {
+            nodeMBR = region;
+        }
+    }
+
+    Node *SnapshotRTree::copyNode(const Node *node)
+    {
+        if (node->isLeaf())
+        {
+            const auto *leaf = static_cast<const LeafNode *>(node);
+            LeafNode *copy = m_tree.createLeafNode();
+            copy->m_entries = leaf->m_entries;
+            copy->m_ids = leaf->m_ids;
+            copy->m_entryMBRs = leaf->m_entryMBRs;
+            copy->m_mbr = leaf->m_mbr;
+            return copy;
+        }
+
+        const auto *internal = static_cast<const InternalNode *>(node);
+        InternalNode *copy = m_tree.createInternalNode();
+        copy->m_children = internal->m_children;
+        copy->m_childMBRs = internal->m_childMBRs;
+        copy->m_mbr = internal->m_mbr;
+        return copy;
+    }
+
+    void SnapshotRTree::publish(Node *root, const std::vector<Node *> &replaced, Data *removed)
+    {
+        m_tree.m_root_node = root;
+        m_root.store(root, std::memory_order_seq_cst);
+
+        // Readers that loaded the old root may still be walking the replaced nodes
+        for (Node *node : replaced)
+        {
+            m_epochs.retire([this, node]()
+                            { m_tree.destroyNode(node); });
+        }
+        if (removed != nullptr)
+        {
+            m_epochs.retire([this, removed]()
+                            { m_tree.destroyData(removed); });
+        }
+        m_epochs.advance();
+        m_epochs.collect();
+    }
+
+    void SnapshotRTree::insert(const Region &mbr, id_type id)
+    {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        std::lock_guard<std::mutex> lock(m_writerMutex);
+
+        Data *data = m_tree.createData(mbr, id);
+        const Region &region = data->getRegion();
+
+        Node *root = m_tree.m_root_node;
+        std::vector<Node *> replaced{root};
+        // An internal root emptied by removes has no subtree to choose; start over from a leaf
+        Node *copy = !root->isLeaf() && root->isEmpty() ? m_tree.createLeafNode() : copyNode(root);
+        grow(copy, region);
+
+        // path holds the copies, root first
+        std::vector<Node *> path{copy};
+        while (!copy->isLeaf())
+        {
+            auto *internal = static_cast<InternalNode *>(copy);
+            const size_t index = internal->m_childMBRs.chooseLeastEnlargement(region);
+            Node *child = internal->m_children[index];
+            replaced.push_back(child);
+
+            copy = copyNode(child);
+            grow(copy, region);
+            internal->m_children[index] = copy;
+            internal->m_childMBRs.set(index, copy->getMBR());
+            path.push_back(copy);
+        }
+        static_cast<LeafNode *>(copy)->appendEntry(data);
+
+        // The copies are private until published, so they split in place like a serial tree
+        Node *newRoot = path[0];
+        for (size_t i = path.size(); i-- > 0 && path[i]->shouldSplit();)
+        {
+            // The children of a copied internal node may still be published, so they keep
+            // their parent pointers
+            auto [original, newNode] = path[i]->isLeaf()
+                                           ? path[i]->split()
+                                           : static_cast<InternalNode *>(path[i])->splitChildren(false);
+            if (newNode == nullptr)
+            {
+                break;
+            }
+
+            if (i == 0)
+            {
+                auto *grownRoot = m_tree.createInternalNode();
+                grownRoot->addChild(original);
+                grownRoot->addChild(newNode);
+                newRoot = grownRoot;
+                break;
+            }
+
+            auto *parent = static_cast<InternalNode *>(path[i - 1]);
+            parent->refreshChild(original);
+            parent->addChild(newNode);
+        }
+
+        publish(newRoot, replaced, nullptr);
+        m_tree.metricManager->record_insertion_time(std::chrono::duration_cast<std::chrono::microseconds>(
+                                                        std::chrono::high_resolution_clock::now() - startTime)
+                                                        .count());
+    }
+
+    bool SnapshotRTree::remove(const Region &mbr, id_type id)
+    {
+        std::lock_guard<std::mutex> lock(m_writerMutex);
+
+        // Only this writer changes the tree, so the current version can be searched directly.
+        // replaced holds the path to the leaf, childIndex[i] the position of replaced[i + 1].
+        std::vector<Node *> replaced;
+        std::vector<size_t> childIndex;
+        size_t entryIndex = 0;
+        auto locate = [&](auto &self, Node *node) -> bool
+        {
+            replaced.push_back(node);
+            if (node->isLeaf())
+            {
+                const auto &ids = static_cast<LeafNode *>(node)->m_ids;
+                auto it = std::find(ids.begin(), ids.end(), id);
+                if (it != ids.end())
+                {
+                    entryIndex = it - ids.begin();
+                    return true;
+                }
+            }
+            else
+            {
+                auto *internal = static_cast<InternalNode *>(node);
+                for (size_t i = 0; i < internal->m_children.size(); ++i)
+                {
+                    if (internal->m_childMBRs.intersects(i, mbr))
+                    {
+                        childIndex.push_back(i);
+                        if (self(self, internal->m_children[i]))
+                        {
+                            return true;
+                        }
+                        childIndex.pop_back();
+                    }
+                }
+            }
+            replaced.pop_back();
+            return false;
+        };
+        if (!locate(locate, m_tree.m_root_node))
+        {
+            return false;
+        }
+
+        std::vector<Node *> path;
+        for (size_t i = 0; i < replaced.size(); ++i)
+        {
+            path.push_back(copyNode(replaced[i]));
+            if (i > 0)
+            {
+                static_cast<InternalNode *>(path[i - 1])->m_children[childIndex[i - 1]] = path[i];
+            }
+        }
+
+        auto *leaf = static_cast<LeafNode *>(path.back());
+        Data *removed = leaf->m_entries[entryIndex];
+        leaf->detachEntry(entryIndex);
+
+        for (size_t i = path.size() - 1; i-- > 0;)
+        {
+            auto *internal = static_cast<InternalNode *>(path[i]);
+            Node *child = path[i + 1];
+            if (child->isEmpty())
+            {
+                // Never published, so it can go right away
+                internal->removeChild(childIndex[i]);
+                m_tree.destroyNode(child);
+            }
+            else
+            {
+                internal->updateChild(childIndex[i]);
+            }
+        }
+
+        publish(path[0], replaced, removed);
+        return true;
+    }
+}
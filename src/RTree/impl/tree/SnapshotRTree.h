@@ -0,0 +1,96 @@
+//
+// RTree whose readers never wait: updates copy the path they change and swap in a new root.
+//
+
+#ifndef SNAPSHOTRTREE_H
+#define SNAPSHOTRTREE_H
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "src/RTree/impl/common.h"
+#include "src/RTree/impl/concurrency/EpochManager.h"
+#include "src/RTree/impl/tree/RTree.h"
+
+namespace RTree
+{
+    class Data;
+    class Node;
+    class Point;
+    class Region;
+    class SplitStrategy;
+    class Visitor;
+
+    // Published nodes are never modified. An insert or remove copies the nodes from the root down
+    // to the leaf it changes, applies the change (and any splits) to the copies, then publishes
+    // the copied root with one atomic store; untouched subtrees are shared between versions.
+    // Parent pointers are therefore not maintained: a shared node keeps the one it had.
+    // The replaced nodes and removed entries are retired to an EpochManager and freed once every
+    // reader that might have seen them has finished.
+    //
+    // Readers take no lock and never block: a Snapshot pins the current version, and any number
+    // of threads may query while one writer at a time (others queue on a mutex) updates the tree.
+    // As in ConcurrentRTree, forced R* reinsertion is not done; full leaves are split.
+    class SnapshotRTree
+    {
+    public:
+        // One version of the tree, consistent across every query made through it. Entries it
+        // returns stay valid while the snapshot lives; keep snapshots short, they hold back
+        // reclamation of everything retired after them.
+        class Snapshot
+        {
+        public:
+            void intersectionQuery(const Region &query, Visitor &visitor) const;
+            std::vector<Data *> intersectionQuery(const Region &query) const;
+            std::vector<Data *> pointQuery(const Point &point) const;
+
+        private:
+            Snapshot(EpochManager::Guard guard, Node *root);
+
+            EpochManager::Guard m_guard;
+            Node *m_root;
+
+            friend class SnapshotRTree;
+        };
+
+        SnapshotRTree(uint32_t dimension, uint32_t nodeCapacity, const SplitStrategy *splitStrategy);
+
+        void insert(const Region &mbr, id_type id);
+        bool remove(const Region &mbr, id_type id);
+
+        // Replaces the whole tree, see RTree::bulkLoad. Frees every node in place, so no reader
+        // may be running.
+        void bulkLoad(const std::vector<BulkEntry> &entries,
+                      BulkLoadMethod method = BulkLoadMethod::SortTileRecursive, double fillFactor = 1.0,
+                      unsigned threadCount = 1);
+
+        Snapshot snapshot();
+
+        // Single queries on the current version, returning ids as entries may be freed afterwards
+        std::vector<id_type> intersectionQuery(const Region &query);
+        std::vector<id_type> pointQuery(const Point &point);
+
+        // Retired nodes and entries not freed yet
+        size_t pendingReclamation() const;
+
+        // The underlying tree, for metrics and queries while no thread is updating this one
+        RTree &getTree();
+
+    private:
+        RTree m_tree;
+        // Published root, mirrored into m_tree.m_root_node by the writer
+        std::atomic<Node *> m_root;
+        std::mutex m_writerMutex;
+        EpochManager m_epochs;
+
+        // Grows an unpublished node's own MBR to cover region
+        static void grow(Node *node, const Region &region);
+        // Unpublished copy of a published node
+        Node *copyNode(const Node *node);
+        // Publishes root and retires the nodes and entries it no longer reaches
+        void publish(Node *root, const std::vector<Node *> &replaced, Data *removed);
+    };
+}
+
+#endif //SNAPSHOTRTREE_H
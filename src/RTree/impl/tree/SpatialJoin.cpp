@@ -0,0 +1,289 @@
+#include "SpatialJoin.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+#include "src/RTree/impl/concurrency/ThreadPool.h"
+#include "src/RTree/impl/node/InternalNode.h"
+#include "src/RTree/impl/node/LeafNode.h"
+#include "src/RTree/impl/node/MBRColumns.h"
+#include "src/RTree/impl/tree/RTree.h"
+
+namespace RTree
+{
+    // Friend of the tree and node classes, reads their columns in place
+    class SpatialJoin
+    {
+    public:
+        SpatialJoin(uint32_t dimension, const std::function<void(id_type, id_type)> &callback)
+            : m_dimension(dimension), m_callback(callback)
+        {
+        }
+
+        // Pair of subtrees whose join is independent of every other task
+        struct Task
+        {
+            const Node *a;
+            uint32_t heightA;
+            const Node *b;
+            uint32_t heightB;
+        };
+
+        void run(const RTree &a, const RTree &b)
+        {
+            if (a.m_root_node != nullptr && b.m_root_node != nullptr)
+            {
+                join(a.m_root_node, heightOf(a.m_root_node), b.m_root_node, heightOf(b.m_root_node));
+            }
+        }
+
+        // Independent node pairs covering the whole join, at least about minCount of them unless
+        // the trees run out of levels first
+        std::vector<Task> split(const RTree &a, const RTree &b, size_t minCount)
+        {
+            std::vector<Task> tasks;
+            if (a.m_root_node == nullptr || b.m_root_node == nullptr)
+            {
+                return tasks;
+            }
+            tasks.push_back({a.m_root_node, heightOf(a.m_root_node), b.m_root_node, heightOf(b.m_root_node)});
+
+            // Breadth first, so that the tasks stay of similar size
+            bool expanded = true;
+            while (tasks.size() < minCount && expanded)
+            {
+                expanded = false;
+                std::vector<Task> next;
+                for (const Task &task : tasks)
+                {
+                    // Two leaves would report pairs here, keep them for a worker
+                    if (task.heightA == 1 && task.heightB == 1)
+                    {
+                        next.push_back(task);
+                        continue;
+                    }
+                    expanded = true;
+                    step(task.a, task.heightA, task.b, task.heightB,
+                         [&next](const Node *a, uint32_t heightA, const Node *b, uint32_t heightB)
+                         { next.push_back({a, heightA, b, heightB}); });
+                }
+                tasks.swap(next);
+            }
+            return tasks;
+        }
+
+        void run(const Task &task)
+        {
+            join(task.a, task.heightA, task.b, task.heightB);
+        }
+
+    private:
+        // Joins the subtrees under a and b, the roots of subtrees of the given heights
+        void join(const Node *a, uint32_t heightA, const Node *b, uint32_t heightB)
+        {
+            step(a, heightA, b, heightB, [this](const Node *childA, uint32_t childHeightA, const Node *childB,
+                                                uint32_t childHeightB)
+                 { join(childA, childHeightA, childB, childHeightB); });
+        }
+
+        // Matches a against b one level down: reports the intersecting entries of two leaves, and
+        // hands every other pair of subtrees that may hold results to descend
+        template <typename Descend>
+        void step(const Node *a, uint32_t heightA, const Node *b, uint32_t heightB, Descend descend)
+        {
+            const Region &mbrA = a->getMBR();
+            const Region &mbrB = b->getMBR();
+            if (mbrA.getDimension() != m_dimension || mbrB.getDimension() != m_dimension ||
+                !mbrA.intersects(mbrB))
+            {
+                return;
+            }
+
+            // Descend the taller side alone until both are on the same level
+            if (heightA > heightB)
+            {
+                const auto *internal = static_cast<const InternalNode *>(a);
+                internal->m_childMBRs.forEachIntersecting(mbrB, [&](size_t i)
+                                                          { descend(internal->m_children[i], heightA - 1, b, heightB); });
+                return;
+            }
+            if (heightB > heightA)
+            {
+                const auto *internal = static_cast<const InternalNode *>(b);
+                internal->m_childMBRs.forEachIntersecting(mbrA, [&](size_t i)
+                                                          { descend(a, heightA, internal->m_children[i], heightB - 1); });
+                return;
+            }
+
+            // Only entries inside the intersection of both MBRs can meet an entry of the other node
+            std::vector<double> low(m_dimension);
+            std::vector<double> high(m_dimension);
+            for (uint32_t d = 0; d < m_dimension; ++d)
+            {
+                low[d] = std::max(mbrA.getLow(d), mbrB.getLow(d));
+                high[d] = std::min(mbrA.getHigh(d), mbrB.getHigh(d));
+            }
+            const Region window(low.data(), high.data(), m_dimension);
+
+            const MBRColumns &columnsA = a->isLeaf() ? static_cast<const LeafNode *>(a)->m_entryMBRs
+                                                     : static_cast<const InternalNode *>(a)->m_childMBRs;
+            const MBRColumns &columnsB = b->isLeaf() ? static_cast<const LeafNode *>(b)->m_entryMBRs
+                                                     : static_cast<const InternalNode *>(b)->m_childMBRs;
+
+            sweep(columnsA, columnsB, window, [&](size_t i, size_t j)
+                  {
+                      if (a->isLeaf())
+                      {
+                          m_callback(static_cast<const LeafNode *>(a)->m_ids[i],
+                                     static_cast<const LeafNode *>(b)->m_ids[j]);
+                      }
+                      else
+                      {
+                          descend(static_cast<const InternalNode *>(a)->m_children[i], heightA - 1,
+                                  static_cast<const InternalNode *>(b)->m_children[j], heightB - 1);
+                      }
+                  });
+        }
+
+        uint32_t m_dimension;
+        const std::function<void(id_type, id_type)> &m_callback;
+
+        // Leaves are all on one level, so the leftmost path gives the height without the full
+        // walk Node::getHeight does
+        static uint32_t heightOf(const Node *node)
+        {
+            uint32_t height = 1;
+            while (!node->isLeaf() && !static_cast<const InternalNode *>(node)->m_children.empty())
+            {
+                node = static_cast<const InternalNode *>(node)->m_children[0];
+                ++height;
+            }
+            return height;
+        }
+
+        // Indices of the entries meeting window, ordered by their low bound on the first axis
+        static std::vector<uint32_t> sortedWithin(const MBRColumns &columns, const Region &window)
+        {
+            std::vector<uint32_t> indices;
+            columns.forEachIntersecting(window, [&](size_t i)
+                                        { indices.push_back(static_cast<uint32_t>(i)); });
+            const double *lows = columns.lows(0);
+            std::sort(indices.begin(), indices.end(), [lows](uint32_t x, uint32_t y)
+                      { return lows[x] < lows[y] || (lows[x] == lows[y] && x < y); });
+            return indices;
+        }
+
+        bool intersects(const MBRColumns &columnsA, size_t i, const MBRColumns &columnsB, size_t j) const
+        {
+            // The sweep has already matched the first axis
+            for (uint32_t d = 1; d < m_dimension; ++d)
+            {
+                if (columnsA.lows(d)[i] > columnsB.highs(d)[j] || columnsB.lows(d)[j] > columnsA.highs(d)[i])
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        // Reports every intersecting pair (i from a, j from b) within window. The side whose next
+        // box starts first is taken, and paired with the boxes of the other side starting before
+        // it ends along the first axis.
+        template <typename Report>
+        void sweep(const MBRColumns &columnsA, const MBRColumns &columnsB, const Region &window, Report report) const
+        {
+            const std::vector<uint32_t> sortedA = sortedWithin(columnsA, window);
+            const std::vector<uint32_t> sortedB = sortedWithin(columnsB, window);
+            const double *lowsA = columnsA.lows(0);
+            const double *highsA = columnsA.highs(0);
+            const double *lowsB = columnsB.lows(0);
+            const double *highsB = columnsB.highs(0);
+
+            size_t nextA = 0;
+            size_t nextB = 0;
+            while (nextA < sortedA.size() && nextB < sortedB.size())
+            {
+                if (lowsA[sortedA[nextA]] <= lowsB[sortedB[nextB]])
+                {
+                    const uint32_t i = sortedA[nextA++];
+                    for (size_t k = nextB; k < sortedB.size() && lowsB[sortedB[k]] <= highsA[i]; ++k)
+                    {
+                        if (intersects(columnsA, i, columnsB, sortedB[k]))
+                        {
+                            report(i, sortedB[k]);
+                        }
+                    }
+                }
+                else
+                {
+                    const uint32_t j = sortedB[nextB++];
+                    for (size_t k = nextA; k < sortedA.size() && lowsA[sortedA[k]] <= highsB[j]; ++k)
+                    {
+                        if (intersects(columnsA, sortedA[k], columnsB, j))
+                        {
+                            report(sortedA[k], j);
+                        }
+                    }
+                }
+            }
+        }
+    };
+
+    void spatialJoin(const RTree &a, const RTree &b, const std::function<void(id_type, id_type)> &callback)
+    {
+        if (a.getDimension() != b.getDimension())
+        {
+            throw std::invalid_argument("Dimensions do not match");
+        }
+
+        SpatialJoin(a.getDimension(), callback).run(a, b);
+    }
+
+    std::vector<std::pair<id_type, id_type>> spatialJoin(const RTree &a, const RTree &b, ThreadPool &pool)
+    {
+        if (a.getDimension() != b.getDimension())
+        {
+            throw std::invalid_argument("Dimensions do not match");
+        }
+
+        // Many more tasks than workers, so that one dense region does not hold up the rest
+        constexpr size_t kTasksPerWorker = 32;
+        const size_t workers = std::max(1u, pool.getThreadCount());
+        const std::function<void(id_type, id_type)> none = [](id_type, id_type) {};
+        const std::vector<SpatialJoin::Task> tasks =
+            SpatialJoin(a.getDimension(), none).split(a, b, workers * kTasksPerWorker);
+        if (tasks.empty())
+        {
+            return {};
+        }
+
+        // Idle workers take the next task, and each worker appends to its own buffer
+        std::vector<std::vector<std::pair<id_type, id_type>>> buffers(std::min(workers, tasks.size()));
+        std::atomic<size_t> nextTask{0};
+        parallelFor(&pool, buffers.size(), [&](size_t begin, size_t)
+                    {
+                        std::vector<std::pair<id_type, id_type>> &buffer = buffers[begin];
+                        const std::function<void(id_type, id_type)> collect = [&buffer](id_type idA, id_type idB)
+                        { buffer.emplace_back(idA, idB); };
+                        SpatialJoin join(a.getDimension(), collect);
+                        for (size_t task = nextTask++; task < tasks.size(); task = nextTask++)
+                        {
+                            join.run(tasks[task]);
+                        }
+                    });
+
+        size_t total = 0;
+        for (const auto &buffer : buffers)
+        {
+            total += buffer.size();
+        }
+        std::vector<std::pair<id_type, id_type>> pairs = std::move(buffers[0]);
+        pairs.reserve(total);
+        for (size_t i = 1; i < buffers.size(); ++i)
+        {
+            pairs.insert(pairs.end(), buffers[i].begin(), buffers[i].end());
+        }
+        return pairs;
+    }
+}
@@ -0,0 +1,32 @@
+//
+// Spatial join of two RTrees by synchronized traversal.
+//
+
+#ifndef SPATIALJOIN_H
+#define SPATIALJOIN_H
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "src/RTree/impl/common.h"
+
+namespace RTree
+{
+    class RTree;
+    class ThreadPool;
+
+    // Calls callback(idA, idB) once for every entry of a and entry of b whose regions intersect.
+    // Both trees are descended together (Brinkhoff, Kriegel & Seeger): only node pairs whose MBRs
+    // meet are visited, each pair's children are first cut down to the part of space both nodes
+    // cover, then matched by a plane sweep along the first axis instead of testing every pair.
+    // The trees may have different heights. Throws std::invalid_argument on a dimension mismatch.
+    void spatialJoin(const RTree &a, const RTree &b, const std::function<void(id_type, id_type)> &callback);
+
+    // The same join spread over pool. The upper levels of both trees are split into independent
+    // node pairs, many more than there are workers, which idle workers take one at a time; every
+    // worker collects its pairs in its own buffer, and the buffers are concatenated at the end.
+    // The pairs come in no particular order. The trees must not change while the join runs.
+    std::vector<std::pair<id_type, id_type>> spatialJoin(const RTree &a, const RTree &b, ThreadPool &pool);
+}
+
+#endif //SPATIALJOIN_H
@@ -2,17 +2,37 @@
 // Tests the correctness of R-tree implementation by comparing search results between vector and R-tree
 
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <limits>
 #include <random>
 #include <set>
+#include <shared_mutex>
+#include <string>
+#include <thread>
 #include <vector>
-#include <__random/random_device.h>
+
+#include <unistd.h>
 
 #include "generator/TestGenerator.h"
+#include "RTree/impl/concurrency/ThreadPool.h"
+#include "RTree/impl/fixed/FixedRTree.h"
+#include "RTree/impl/simd/SimdKernels.h"
+#include "RTree/impl/storage/MappedRTree.h"
+#include "RTree/impl/storage/PagedRTree.h"
+#include "RTree/impl/storage/TreeFile.h"
 #include "RTree/impl/strategy/LinearSplitStrategy.h"
 #include "RTree/impl/strategy/QuadraticSplitStrategy.h"
 #include "RTree/impl/strategy/RStarSplitStrategy.h"
+#include "RTree/impl/tree/ConcurrentRTree.h"
+#include "RTree/impl/tree/FrozenRTree.h"
 #include "RTree/impl/tree/RTree.h"
+#include "RTree/impl/tree/SnapshotRTree.h"
+#include "RTree/impl/tree/SpatialJoin.h"
 
 // Define the structure of test data entry
 struct TestPoint
@@ -238,19 +258,42 @@ void sanity() {
     std::cout << "===== R-tree Split Strategy Comparison Completed =====" << std::endl;
 }
 
+// Answers the windows one at a time and then as one batch, returning both wall times in seconds
+std::pair<double, double> batch_throughput(const std::vector<RTree::Region> &queries, RTree::RTree &tree) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (const auto &query : queries) {
+        tree.intersectionQuery(query);
+    }
+    auto midTime = std::chrono::high_resolution_clock::now();
+    tree.intersectionQueryBatch(queries);
+    auto endTime = std::chrono::high_resolution_clock::now();
+    return {std::chrono::duration<double>(midTime - startTime).count(),
+            std::chrono::duration<double>(endTime - midTime).count()};
+}
+
+void print_batch_throughput(size_t queryCount, std::pair<double, double> seconds, const std::string &name) {
+    std::cout << " Single range query throughput - " << name << ": "
+              << (seconds.first > 0 ? queryCount / seconds.first : 0.0) << " queries/s" << std::endl;
+    std::cout << " Batch range query throughput - " << name << ": "
+              << (seconds.second > 0 ? queryCount / seconds.second : 0.0) << " queries/s" << std::endl;
+}
+
 void range_query(double max_x, double max_y, double window_unit,
     RTree::RTree & linearTree, RTree::RTree & quadraticTree, RTree::RTree & rstarTree) {
+    std::vector<RTree::Region> queries;
     for(double x_start = 0.0; x_start < max_x; x_start+=window_unit) {
         for(double y_start = 0.0; y_start < max_y; y_start+=window_unit) {
             double low[2] = {x_start, y_start};
             double high[2] = {x_start + window_unit, y_start + window_unit};
-            RTree::Region queryRegion(low, high, 2);
-            linearTree.intersectionQuery(queryRegion);
-            quadraticTree.intersectionQuery(queryRegion);
-            rstarTree.intersectionQuery(queryRegion);
+            queries.emplace_back(low, high, 2);
         }
     }
 
+    // Batched queries record no per-query metrics, so the cost report below covers the single ones
+    auto linearSeconds = batch_throughput(queries, linearTree);
+    auto quadraticSeconds = batch_throughput(queries, quadraticTree);
+    auto rstarSeconds = batch_throughput(queries, rstarTree);
+
     std::cout << window_unit << " range queries cost" << std::endl;
     std::cout << "Linear Split " << std::endl;
     linearTree.print_range_query_metrics("linear", window_unit);
@@ -263,6 +306,117 @@ void range_query(double max_x, double max_y, double window_unit,
     std::cout << "R* Split " << std::endl;
     rstarTree.print_range_query_metrics("r-star", window_unit);
     std::cout << std::endl;
+
+    std::cout << window_unit << " batched range queries" << std::endl;
+    print_batch_throughput(queries.size(), linearSeconds, "linear");
+    print_batch_throughput(queries.size(), quadraticSeconds, "quadratic");
+    print_batch_throughput(queries.size(), rstarSeconds, "r-star");
+    std::cout << std::endl;
+}
+
+// Identical boxes waste a negative area for every pair, the quadratic split must still pick two
+// distinct seeds and keep each entry exactly once
+void duplicate_boxes_check(int boxes_count, int capacity) {
+    double low[2] = {0, 0};
+    double high[2] = {10, 10};
+
+    RTree::fixed::RTree<2> fixedTree(capacity);
+    for (int i = 0; i < boxes_count; ++i) {
+        fixedTree.insert(RTree::fixed::Region<2>(low, high), i);
+    }
+    std::set<id_type> fixed_ids;
+    const auto fixed_results = fixedTree.intersectionQuery(RTree::fixed::Region<2>(low, high));
+    for (const auto *entry : fixed_results) {
+        fixed_ids.insert(entry->id);
+    }
+    printTestResult("duplicate boxes kept once - fixed-quadratic",
+                    fixed_results.size() == static_cast<size_t>(boxes_count) &&
+                        fixed_ids.size() == static_cast<size_t>(boxes_count));
+
+    // Emptied by removes, the tree must take inserts again
+    bool all_removed = true;
+    for (int i = 0; i < boxes_count; ++i) {
+        all_removed = fixedTree.remove(RTree::fixed::Region<2>(low, high), i) && all_removed;
+    }
+    all_removed = all_removed && fixedTree.intersectionQuery(RTree::fixed::Region<2>(low, high)).empty();
+    fixedTree.insert(RTree::fixed::Region<2>(low, high), boxes_count);
+    const auto reinserted = fixedTree.intersectionQuery(RTree::fixed::Region<2>(low, high));
+    printTestResult("emptied tree takes inserts again - fixed-quadratic",
+                    all_removed && reinserted.size() == 1 && reinserted[0]->id == static_cast<id_type>(boxes_count));
+
+    RTree::QuadraticSplitStrategy quadraticSplitStrategy;
+    RTree::RTree quadraticTree(2, capacity, &quadraticSplitStrategy);
+    for (int i = 0; i < boxes_count; ++i) {
+        quadraticTree.insert(RTree::Region(low, high, 2), i);
+    }
+    std::set<id_type> quadratic_ids;
+    const auto quadratic_results = quadraticTree.intersectionQuery(RTree::Region(low, high, 2));
+    for (const auto *data : quadratic_results) {
+        quadratic_ids.insert(data->getIdentifier());
+    }
+    printTestResult("duplicate boxes kept once - quadratic",
+                    quadratic_results.size() == static_cast<size_t>(boxes_count) &&
+                        quadratic_ids.size() == static_cast<size_t>(boxes_count));
+}
+
+// Same sliding window as range_query, against the compile-time dimension tree
+void range_query_fixed(double max_x, double max_y, double window_unit, RTree::fixed::RTree<2> &fixedTree) {
+    for(double x_start = 0.0; x_start < max_x; x_start+=window_unit) {
+        for(double y_start = 0.0; y_start < max_y; y_start+=window_unit) {
+            RTree::fixed::Region<2> queryRegion({x_start, y_start}, {x_start + window_unit, y_start + window_unit});
+            fixedTree.intersectionQuery(queryRegion);
+        }
+    }
+
+    std::cout << window_unit << " range queries cost" << std::endl;
+    std::cout << "Fixed-dimension Quadratic Split " << std::endl;
+    fixedTree.print_range_query_metrics("fixed-quadratic", window_unit);
+    std::cout << std::endl;
+}
+
+// Same sliding window as range_query, against one more tree
+void range_query_single(double max_x, double max_y, double window_unit, RTree::RTree &tree,
+                        const std::string &title, const std::string &name) {
+    for(double x_start = 0.0; x_start < max_x; x_start+=window_unit) {
+        for(double y_start = 0.0; y_start < max_y; y_start+=window_unit) {
+            double low[2] = {x_start, y_start};
+            double high[2] = {x_start + window_unit, y_start + window_unit};
+            RTree::Region queryRegion(low, high, 2);
+            tree.intersectionQuery(queryRegion);
+        }
+    }
+
+    std::cout << window_unit << " range queries cost" << std::endl;
+    std::cout << title << " " << std::endl;
+    tree.print_range_query_metrics(name, window_unit);
+    std::cout << std::endl;
+}
+
+// Distances of the k entries nearestNeighbors returns, and of the first k the cursor yields, both
+// against the k smallest of every region's distance to point. Compared by distance, as ties may
+// come in any order.
+bool knn_matches_brute_force(RTree::RTree &tree, const std::vector<RTree::Region> &regions,
+                             const RTree::Point &point, uint32_t k) {
+    std::vector<double> expected;
+    expected.reserve(regions.size());
+    for (const auto & region : regions) {
+        expected.push_back(region.getMinDistance(point));
+    }
+    const size_t count = std::min<size_t>(k, expected.size());
+    std::partial_sort(expected.begin(), expected.begin() + count, expected.end());
+    expected.resize(count);
+
+    std::vector<double> found;
+    for (const RTree::Data *data : tree.nearestNeighbors(point, k)) {
+        found.push_back(data->getRegion().getMinDistance(point));
+    }
+
+    std::vector<double> browsed;
+    RTree::NearestNeighborCursor cursor = tree.nearestNeighborCursor(point);
+    for (const RTree::Data *data = cursor.next(); data != nullptr && browsed.size() < count; data = cursor.next()) {
+        browsed.push_back(data->getRegion().getMinDistance(point));
+    }
+    return found == expected && browsed == expected;
 }
 
 void benchmark(double max_x, double max_y,
@@ -281,6 +435,9 @@ void benchmark(double max_x, double max_y,
     RTree::RStarSplitStrategy rstarSplitStrategy;
     RTree::RTree rstarTree(dimension, capacity, &rstarSplitStrategy);
 
+    // Compile-time 2D tree with the quadratic split, compared against quadraticTree
+    RTree::fixed::RTree<2> fixedTree(capacity);
+
     int count = 0;
 
     for (const auto & point : points) {
@@ -293,11 +450,29 @@ void benchmark(double max_x, double max_y,
         linearTree.insert(region1, point.getId());
         quadraticTree.insert(region2, point.getId());
         rstarTree.insert(region3, point.getId());
+        fixedTree.insert(RTree::fixed::Region<2>(low, high), point.getId());
     }
 
     linearTree.construction_finished();
     quadraticTree.construction_finished();
     rstarTree.construction_finished();
+    fixedTree.construction_finished();
+
+    // The same points packed bottom-up with STR instead of inserted one by one
+    std::vector<RTree::BulkEntry> bulkEntries;
+    bulkEntries.reserve(points.size());
+    for (const auto & point : points) {
+        double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+        bulkEntries.emplace_back(RTree::Region(low, low, 2), point.getId());
+    }
+    RTree::RTree strTree(dimension, capacity, &quadraticSplitStrategy);
+    strTree.bulkLoad(bulkEntries);
+    strTree.construction_finished();
+
+    // Packed along a Hilbert curve instead, which follows the clusters of the skewed modes
+    RTree::RTree hilbertTree(dimension, capacity, &quadraticSplitStrategy);
+    hilbertTree.bulkLoad(bulkEntries, RTree::BulkLoadMethod::Hilbert);
+    hilbertTree.construction_finished();
 
     std::cout << "Linear Split " << std::endl;
     linearTree.print_construction_metrics("linear");
@@ -311,11 +486,26 @@ void benchmark(double max_x, double max_y,
     rstarTree.print_construction_metrics("r-star");
     std::cout << std::endl;
 
+    std::cout << "Fixed-dimension Quadratic Split " << std::endl;
+    fixedTree.print_construction_metrics("fixed-quadratic");
+    std::cout << std::endl;
+
+    std::cout << "STR Bulk Load " << std::endl;
+    strTree.print_construction_metrics("str-bulk");
+    std::cout << std::endl;
+
+    std::cout << "Hilbert Bulk Load " << std::endl;
+    hilbertTree.print_construction_metrics("hilbert-bulk");
+    std::cout << std::endl;
+
     if(!construction_only) {
         for (const auto & point : points) {
             linearTree.pointQuery(point);
             quadraticTree.pointQuery(point);
             rstarTree.pointQuery(point);
+            fixedTree.pointQuery({point.getCoordinate(0), point.getCoordinate(1)});
+            strTree.pointQuery(point);
+            hilbertTree.pointQuery(point);
         }
 
         std::cout << "point queries cost" << std::endl;
@@ -330,6 +520,57 @@ void benchmark(double max_x, double max_y,
         rstarTree.print_point_query_metrics("r-star");
         std::cout << std::endl;
 
+        std::cout << "Fixed-dimension Quadratic Split " << std::endl;
+        fixedTree.print_point_query_metrics("fixed-quadratic");
+        std::cout << std::endl;
+
+        std::cout << "STR Bulk Load " << std::endl;
+        strTree.print_point_query_metrics("str-bulk");
+        std::cout << std::endl;
+
+        std::cout << "Hilbert Bulk Load " << std::endl;
+        hilbertTree.print_point_query_metrics("hilbert-bulk");
+        std::cout << std::endl;
+
+        std::cout << "knn queries cost" << std::endl;
+        for (uint32_t k : {1u, 10u, 100u}) {
+            const size_t knn_queries = std::min<size_t>(points.size(), 1000);
+            for (size_t i = 0; i < knn_queries; ++i) {
+                quadraticTree.nearestNeighbors(points[i], k);
+                rstarTree.nearestNeighbors(points[i], k);
+                strTree.nearestNeighbors(points[i], k);
+            }
+
+            std::cout << "Quadratic Split " << std::endl;
+            quadraticTree.print_knn_query_metrics("quadratic", k);
+            std::cout << std::endl;
+
+            std::cout << "R* Split " << std::endl;
+            rstarTree.print_knn_query_metrics("r-star", k);
+            std::cout << std::endl;
+
+            std::cout << "STR Bulk Load " << std::endl;
+            strTree.print_knn_query_metrics("str-bulk", k);
+            std::cout << std::endl;
+        }
+
+        // Checked after the timed queries, whose metrics are printed by now, on a sample of them
+        std::vector<RTree::Region> regions;
+        regions.reserve(points.size());
+        for (const auto & point : points) {
+            double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+            regions.emplace_back(low, low, 2);
+        }
+        for (uint32_t k : {1u, 10u, 100u}) {
+            bool knn_exact = true;
+            for (size_t i = 0; i < std::min<size_t>(points.size(), 1000); i += 50) {
+                knn_exact = knn_exact && knn_matches_brute_force(quadraticTree, regions, points[i], k) &&
+                            knn_matches_brute_force(rstarTree, regions, points[i], k) &&
+                            knn_matches_brute_force(strTree, regions, points[i], k);
+            }
+            printTestResult(std::to_string(k) + "nn and cursor match brute force", knn_exact);
+        }
+
         std::cout << "range queries cost" << std::endl;
         range_query(max_x, max_y, 50, linearTree, quadraticTree, rstarTree);
         range_query(max_x, max_y, 100, linearTree, quadraticTree, rstarTree);
@@ -337,20 +578,1245 @@ void benchmark(double max_x, double max_y,
         range_query(max_x, max_y, 1000, linearTree, quadraticTree, rstarTree);
         range_query(max_x, max_y, 5000, linearTree, quadraticTree, rstarTree);
         range_query(max_x, max_y, 10000, linearTree, quadraticTree, rstarTree);
+
+        for (double window : {50.0, 100.0, 500.0, 1000.0, 5000.0, 10000.0}) {
+            range_query_fixed(max_x, max_y, window, fixedTree);
+            range_query_single(max_x, max_y, window, strTree, "STR Bulk Load", "str-bulk");
+            range_query_single(max_x, max_y, window, hilbertTree, "Hilbert Bulk Load", "hilbert-bulk");
+        }
     }
 }
 
-int main()
+// Node-sized batches of 2D child MBRs run through the intersection and enlargement kernels
+// at every ISA level the CPU supports; results are checked against the scalar level
+void simd_benchmark(double max_x, double max_y, int node_capacity, int node_count) {
+    namespace simd = RTree::simd;
+    constexpr uint32_t dimension = 2;
+    const size_t stride = node_capacity;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<> distX(0.0, max_x);
+    std::uniform_real_distribution<> distY(0.0, max_y);
+    std::uniform_real_distribution<> extent(0.0, max_x / 50);
+
+    // Per node: low columns (x then y), then high columns (x then y)
+    std::vector<double> columns(static_cast<size_t>(node_count) * 2 * dimension * stride);
+    for (int n = 0; n < node_count; ++n) {
+        double *node = columns.data() + static_cast<size_t>(n) * 2 * dimension * stride;
+        for (size_t j = 0; j < stride; ++j) {
+            double x = distX(gen);
+            double y = distY(gen);
+            node[j] = x;
+            node[stride + j] = y;
+            node[2 * stride + j] = x + extent(gen);
+            node[3 * stride + j] = y + extent(gen);
+        }
+    }
+
+    std::vector<std::pair<std::array<double, 2>, std::array<double, 2>>> queries;
+    for (int q = 0; q < 64; ++q) {
+        double x = distX(gen);
+        double y = distY(gen);
+        queries.push_back({{x, y}, {x + extent(gen), y + extent(gen)}});
+    }
+
+    const simd::IsaLevel detected = simd::detectIsaLevel();
+    std::vector<uint64_t> referenceMasks;
+    std::vector<double> referenceEnlargements;
+    long long scalarIntersectTime = 0;
+    long long scalarEnlargementTime = 0;
+
+    std::cout << "SIMD kernels, nodes of " << node_capacity << " children, " << node_count << " nodes" << std::endl;
+    for (int level = 0; level <= static_cast<int>(detected); ++level) {
+        simd::setIsaLevel(static_cast<simd::IsaLevel>(level));
+
+        std::vector<uint64_t> masks;
+        std::vector<double> enlargements(stride);
+        std::vector<double> areas(stride);
+        std::vector<double> enlargementResults;
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+        for (const auto &[low, high] : queries) {
+            for (int n = 0; n < node_count; ++n) {
+                const double *node = columns.data() + static_cast<size_t>(n) * 2 * dimension * stride;
+                for (size_t base = 0; base < stride; base += 64) {
+                    masks.push_back(simd::intersectMask(node + base, node + 2 * stride + base, stride, dimension,
+                                                        low.data(), high.data(), std::min<size_t>(64, stride - base)));
+                }
+            }
+        }
+        auto midTime = std::chrono::high_resolution_clock::now();
+        for (const auto &[low, high] : queries) {
+            for (int n = 0; n < node_count; ++n) {
+                const double *node = columns.data() + static_cast<size_t>(n) * 2 * dimension * stride;
+                simd::areaEnlargements(node, node + 2 * stride, stride, dimension, low.data(), high.data(),
+                                       stride, areas.data(), enlargements.data());
+                enlargementResults.push_back(enlargements[n % stride]);
+            }
+        }
+        auto endTime = std::chrono::high_resolution_clock::now();
+
+        long long intersectTime = std::chrono::duration_cast<std::chrono::microseconds>(midTime - startTime).count();
+        long long enlargementTime = std::chrono::duration_cast<std::chrono::microseconds>(endTime - midTime).count();
+        if (level == 0) {
+            referenceMasks = masks;
+            referenceEnlargements = enlargementResults;
+            scalarIntersectTime = intersectTime;
+            scalarEnlargementTime = enlargementTime;
+        }
+
+        const char *name = simd::getIsaName(static_cast<simd::IsaLevel>(level));
+        bool exact = masks == referenceMasks && enlargementResults == referenceEnlargements;
+        std::cout << " Intersect kernel time - " << name << ": " << intersectTime << std::endl;
+        std::cout << " Intersect kernel speedup - " << name << ": "
+                  << static_cast<double>(scalarIntersectTime) / std::max(intersectTime, 1LL) << std::endl;
+        std::cout << " Enlargement kernel time - " << name << ": " << enlargementTime << std::endl;
+        std::cout << " Enlargement kernel speedup - " << name << ": "
+                  << static_cast<double>(scalarEnlargementTime) / std::max(enlargementTime, 1LL) << std::endl;
+        std::cout << " Matches scalar - " << name << ": " << (exact ? "yes" : "NO") << std::endl;
+    }
+    simd::setIsaLevel(detected);
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+
+// Construction time of the parallel bulk load for growing thread counts, up to the hardware threads
+void bulk_load_scaling(double max_x, double max_y, int points_count, int capacity) {
+    std::vector<RTree::Point> points;
+    TestGenerator::generate_test_data(0, max_x, max_y, points_count, points);
+
+    std::vector<RTree::BulkEntry> bulkEntries;
+    bulkEntries.reserve(points.size());
+    for (const auto & point : points) {
+        double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+        bulkEntries.emplace_back(RTree::Region(low, low, 2), point.getId());
+    }
+
+    std::vector<unsigned> thread_counts = {1, 2, 4, 8, 16, 32, 64};
+    const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    thread_counts.erase(std::remove_if(thread_counts.begin(), thread_counts.end(),
+                                       [&](unsigned threads) { return threads > hardware_threads; }),
+                        thread_counts.end());
+
+    RTree::QuadraticSplitStrategy quadraticSplitStrategy;
+    std::cout << "Parallel bulk load, total points: " << points.size() << ", capacity: " << capacity << std::endl;
+    for (auto [method, name] : {std::make_pair(RTree::BulkLoadMethod::SortTileRecursive, "str"),
+                                std::make_pair(RTree::BulkLoadMethod::Hilbert, "hilbert")}) {
+        long long single_thread_time = 0;
+        for (unsigned threads : thread_counts) {
+            RTree::RTree tree(2, capacity, &quadraticSplitStrategy);
+            auto startTime = std::chrono::high_resolution_clock::now();
+            tree.bulkLoad(bulkEntries, method, 1.0, threads);
+            auto endTime = std::chrono::high_resolution_clock::now();
+            long long time = std::chrono::duration_cast<std::chrono::microseconds>(endTime - startTime).count();
+            if (threads == 1) {
+                single_thread_time = time;
+            }
+            std::cout << " Bulk load time - " << name << " " << threads << " threads: " << time << std::endl;
+            std::cout << " Bulk load speedup - " << name << " " << threads << " threads: "
+                      << static_cast<double>(single_thread_time) / std::max(time, 1LL) << std::endl;
+        }
+    }
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+
+// Read-only query throughput from 1 to N threads: each thread answering its share of the windows
+// one at a time, then the whole batch spread over a thread pool
+void query_scaling(double max_x, double max_y, int points_count, int capacity, double window_unit) {
+    std::vector<RTree::Point> points;
+    TestGenerator::generate_test_data(0, max_x, max_y, points_count, points);
+
+    std::vector<RTree::BulkEntry> bulkEntries;
+    bulkEntries.reserve(points.size());
+    for (const auto & point : points) {
+        double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+        bulkEntries.emplace_back(RTree::Region(low, low, 2), point.getId());
+    }
+
+    RTree::QuadraticSplitStrategy quadraticSplitStrategy;
+    RTree::RTree tree(2, capacity, &quadraticSplitStrategy);
+    tree.bulkLoad(bulkEntries, RTree::BulkLoadMethod::SortTileRecursive);
+
+    std::vector<RTree::Region> queries;
+    for(double x_start = 0.0; x_start < max_x; x_start+=window_unit) {
+        for(double y_start = 0.0; y_start < max_y; y_start+=window_unit) {
+            double low[2] = {x_start, y_start};
+            double high[2] = {x_start + window_unit, y_start + window_unit};
+            queries.emplace_back(low, high, 2);
+        }
+    }
+
+    std::vector<unsigned> thread_counts = {1, 2, 4, 8, 16, 32, 64};
+    const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    thread_counts.erase(std::remove_if(thread_counts.begin(), thread_counts.end(),
+                                       [&](unsigned threads) { return threads > hardware_threads; }),
+                        thread_counts.end());
+
+    std::cout << "Concurrent range queries, total points: " << points.size() << ", capacity: " << capacity
+              << ", queries: " << queries.size() << std::endl;
+    double single_thread_throughput = 0;
+    double single_thread_batch_throughput = 0;
+    for (unsigned threads : thread_counts) {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        std::vector<std::thread> readers;
+        for (unsigned t = 0; t < threads; ++t) {
+            readers.emplace_back([&, t]() {
+                for (size_t q = queries.size() * t / threads; q < queries.size() * (t + 1) / threads; ++q) {
+                    tree.intersectionQuery(queries[q]);
+                }
+            });
+        }
+        for (auto &reader : readers) {
+            reader.join();
+        }
+        auto midTime = std::chrono::high_resolution_clock::now();
+
+        RTree::ThreadPool pool(threads);
+        auto batchStartTime = std::chrono::high_resolution_clock::now();
+        tree.intersectionQueryBatch(queries, pool);
+        auto endTime = std::chrono::high_resolution_clock::now();
+
+        double throughput = queries.size() / std::max(std::chrono::duration<double>(midTime - startTime).count(), 1e-9);
+        double batch_throughput = queries.size() / std::max(std::chrono::duration<double>(endTime - batchStartTime).count(), 1e-9);
+        if (threads == 1) {
+            single_thread_throughput = throughput;
+            single_thread_batch_throughput = batch_throughput;
+        }
+        std::cout << " Range query throughput - " << threads << " threads: " << throughput << " queries/s, speedup "
+                  << throughput / single_thread_throughput << std::endl;
+        std::cout << " Batch range query throughput - " << threads << " threads: " << batch_throughput
+                  << " queries/s, speedup " << batch_throughput / single_thread_batch_throughput << std::endl;
+    }
+    tree.print_range_query_metrics("concurrent", window_unit);
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+
+// One thread's share of a mixed workload: 60% small range queries, 20% inserts of new points and
+// 20% removes of points this thread inserted earlier. Returns the ids it inserted and did not remove
+template <typename Query, typename Insert, typename Remove>
+std::vector<id_type> mixed_operations(double max_x, double max_y, int operations, id_type first_id, unsigned seed,
+                      Query query, Insert insert, Remove remove) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<> distX(0.0, max_x);
+    std::uniform_real_distribution<> distY(0.0, max_y);
+    std::vector<std::pair<RTree::Region, id_type>> inserted;
+    id_type next_id = first_id;
+    for (int op = 0; op < operations; ++op) {
+        const unsigned kind = gen() % 10;
+        double low[2] = {distX(gen), distY(gen)};
+        if (kind < 6 || (kind >= 8 && inserted.empty())) {
+            double high[2] = {low[0] + 5, low[1] + 5};
+            query(RTree::Region(low, high, 2));
+        } else if (kind < 8) {
+            inserted.emplace_back(RTree::Region(low, low, 2), next_id++);
+            insert(inserted.back().first, inserted.back().second);
+        } else {
+            std::swap(inserted[gen() % inserted.size()], inserted.back());
+            remove(inserted.back().first, inserted.back().second);
+            inserted.pop_back();
+        }
+    }
+    std::vector<id_type> kept;
+    kept.reserve(inserted.size());
+    for (const auto &entry : inserted) {
+        kept.push_back(entry.second);
+    }
+    return kept;
+}
+
+// Ids from a query over the whole space, sorted
+std::vector<id_type> sorted_ids(std::vector<id_type> ids) {
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+std::vector<id_type> sorted_ids(const std::vector<RTree::Data *> &entries) {
+    std::vector<id_type> ids;
+    ids.reserve(entries.size());
+    for (const RTree::Data *entry : entries) {
+        ids.push_back(entry->getIdentifier());
+    }
+    return sorted_ids(std::move(ids));
+}
+
+RTree::Region whole_space() {
+    double low[2] = {std::numeric_limits<double>::lowest(), std::numeric_limits<double>::lowest()};
+    double high[2] = {std::numeric_limits<double>::max(), std::numeric_limits<double>::max()};
+    return RTree::Region(low, high, 2);
+}
+
+// Mixed read/write throughput from 1 to N threads: a tree behind one reader/writer lock against
+// the latch-coupled ConcurrentRTree and the copy-on-write SnapshotRTree. After each run every tree
+// must hold exactly the preloaded points and those the workers inserted and did not remove
+void mixed_workload_scaling(double max_x, double max_y, int points_count, int capacity, int operations_per_thread) {
+    std::vector<RTree::Point> points;
+    TestGenerator::generate_test_data(0, max_x, max_y, points_count, points);
+
+    std::vector<RTree::BulkEntry> bulkEntries;
+    bulkEntries.reserve(points.size());
+    for (const auto & point : points) {
+        double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+        bulkEntries.emplace_back(RTree::Region(low, low, 2), point.getId());
+    }
+
+    std::vector<unsigned> thread_counts = {1, 2, 4, 8, 16, 32, 64};
+    const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    thread_counts.erase(std::remove_if(thread_counts.begin(), thread_counts.end(),
+                                       [&](unsigned threads) { return threads > hardware_threads; }),
+                        thread_counts.end());
+
+    // Ids of points inserted during the run start past the preloaded ones
+    const id_type first_new_id = static_cast<id_type>(points.size()) + 1;
+
+    RTree::QuadraticSplitStrategy quadraticSplitStrategy;
+    std::cout << "Mixed read/write workload, total points: " << points.size() << ", capacity: " << capacity
+              << ", operations per thread: " << operations_per_thread << std::endl;
+    for (unsigned threads : thread_counts) {
+        RTree::RTree lockedTree(2, capacity, &quadraticSplitStrategy);
+        lockedTree.bulkLoad(bulkEntries);
+        std::shared_mutex treeLock;
+
+        RTree::ConcurrentRTree concurrentTree(2, capacity, &quadraticSplitStrategy);
+        concurrentTree.getTree().bulkLoad(bulkEntries);
+
+        RTree::SnapshotRTree snapshotTree(2, capacity, &quadraticSplitStrategy);
+        snapshotTree.bulkLoad(bulkEntries);
+
+        // Sorted ids each tree should hold after the last run
+        std::vector<id_type> expected;
+        auto run = [&](auto &&worker) {
+            std::vector<std::vector<id_type>> kept(threads);
+            auto startTime = std::chrono::high_resolution_clock::now();
+            std::vector<std::thread> workers;
+            for (unsigned t = 0; t < threads; ++t) {
+                workers.emplace_back([&, t]() { kept[t] = worker(t); });
+            }
+            for (auto &w : workers) {
+                w.join();
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - startTime).count();
+            expected.clear();
+            for (const auto &entry : bulkEntries) {
+                expected.push_back(entry.second);
+            }
+            for (const auto &ids : kept) {
+                expected.insert(expected.end(), ids.begin(), ids.end());
+            }
+            std::sort(expected.begin(), expected.end());
+            return static_cast<double>(threads) * operations_per_thread / std::max(seconds, 1e-9);
+        };
+
+        double locked_throughput = run([&](unsigned t) {
+            return mixed_operations(max_x, max_y, operations_per_thread, first_new_id + t * operations_per_thread, t,
+                                    [&](const RTree::Region &query) {
+                                        std::shared_lock<std::shared_mutex> lock(treeLock);
+                                        lockedTree.intersectionQuery(query);
+                                    },
+                                    [&](const RTree::Region &region, id_type id) {
+                                        std::unique_lock<std::shared_mutex> lock(treeLock);
+                                        lockedTree.insert(region, id);
+                                    },
+                                    [&](const RTree::Region &region, id_type id) {
+                                        std::unique_lock<std::shared_mutex> lock(treeLock);
+                                        lockedTree.remove(region, id);
+                                    });
+        });
+        const std::string suffix = " - " + std::to_string(threads) + " threads";
+        printTestResult("mixed workload contents - global lock" + suffix,
+                        sorted_ids(lockedTree.intersectionQuery(whole_space())) == expected);
+
+        double latched_throughput = run([&](unsigned t) {
+            return mixed_operations(max_x, max_y, operations_per_thread, first_new_id + t * operations_per_thread, t,
+                                    [&](const RTree::Region &query) { concurrentTree.intersectionQuery(query); },
+                                    [&](const RTree::Region &region, id_type id) { concurrentTree.insert(region, id); },
+                                    [&](const RTree::Region &region, id_type id) { concurrentTree.remove(region, id); });
+        });
+        printTestResult("mixed workload contents - node latches" + suffix,
+                        sorted_ids(concurrentTree.intersectionQuery(whole_space())) == expected);
+
+        double snapshot_throughput = run([&](unsigned t) {
+            return mixed_operations(max_x, max_y, operations_per_thread, first_new_id + t * operations_per_thread, t,
+                                    [&](const RTree::Region &query) { snapshotTree.intersectionQuery(query); },
+                                    [&](const RTree::Region &region, id_type id) { snapshotTree.insert(region, id); },
+                                    [&](const RTree::Region &region, id_type id) { snapshotTree.remove(region, id); });
+        });
+        printTestResult("mixed workload contents - snapshot" + suffix,
+                        sorted_ids(snapshotTree.intersectionQuery(whole_space())) == expected);
+
+        std::cout << " Mixed throughput - global lock " << threads << " threads: " << locked_throughput
+                  << " operations/s" << std::endl;
+        std::cout << " Mixed throughput - node latches " << threads << " threads: " << latched_throughput
+                  << " operations/s, " << latched_throughput / std::max(locked_throughput, 1e-9) << "x global lock"
+                  << std::endl;
+        std::cout << " Mixed throughput - snapshot " << threads << " threads: " << snapshot_throughput
+                  << " operations/s, " << snapshot_throughput / std::max(locked_throughput, 1e-9) << "x global lock"
+                  << std::endl;
+    }
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+
+void print_latency_percentiles(std::vector<long long> &latencies, const std::string &name) {
+    if (latencies.empty()) {
+        return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) { return latencies[static_cast<size_t>(p * (latencies.size() - 1))]; };
+    std::cout << " p50 query latency ns - " << name << ": " << percentile(0.50) << std::endl;
+    std::cout << " p99 query latency ns - " << name << ": " << percentile(0.99) << std::endl;
+    std::cout << " max query latency ns - " << name << ": " << latencies.back() << std::endl;
+}
+
+// Range query latency while points stream in: the single-threaded tree answering queries with no
+// ingest, a tree behind one reader/writer lock with a writer thread ingesting, and the snapshot tree
+// with the same writer
+void snapshot_read_latency(double max_x, double max_y, int points_count, int capacity, int ingest_count,
+                           double window_unit) {
+    std::vector<RTree::Point> points;
+    TestGenerator::generate_test_data(0, max_x, max_y, points_count + ingest_count, points);
+
+    std::vector<RTree::BulkEntry> bulkEntries;
+    std::vector<RTree::Region> ingest;
+    for (size_t i = 0; i < points.size(); ++i) {
+        double low[2] = {points[i].getCoordinate(0), points[i].getCoordinate(1)};
+        if (i < static_cast<size_t>(points_count)) {
+            bulkEntries.emplace_back(RTree::Region(low, low, 2), points[i].getId());
+        } else {
+            ingest.emplace_back(low, low, 2);
+        }
+    }
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<> distX(0.0, max_x - window_unit);
+    std::uniform_real_distribution<> distY(0.0, max_y - window_unit);
+    std::vector<RTree::Region> queries;
+    for (int q = 0; q < 20000; ++q) {
+        double low[2] = {distX(gen), distY(gen)};
+        double high[2] = {low[0] + window_unit, low[1] + window_unit};
+        queries.emplace_back(low, high, 2);
+    }
+
+    // Queries until the writer is done, at least one pass over the windows
+    auto measure = [&](auto &&query, const std::atomic<bool> &ingesting) {
+        std::vector<long long> latencies;
+        for (size_t q = 0; q < queries.size() || ingesting; ++q) {
+            auto startTime = std::chrono::high_resolution_clock::now();
+            query(queries[q % queries.size()]);
+            auto endTime = std::chrono::high_resolution_clock::now();
+            latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+        }
+        return latencies;
+    };
+
+    // Sorted ids both ingesting trees should hold once the writer is done
+    std::vector<id_type> expected;
+    for (const auto &entry : bulkEntries) {
+        expected.push_back(entry.second);
+    }
+    for (size_t i = 0; i < ingest.size(); ++i) {
+        expected.push_back(points_count + static_cast<id_type>(i));
+    }
+    std::sort(expected.begin(), expected.end());
+
+    RTree::QuadraticSplitStrategy quadraticSplitStrategy;
+    std::cout << "Query latency under ingest, total points: " << points_count << ", ingested: " << ingest_count
+              << ", capacity: " << capacity << std::endl;
+    {
+        RTree::RTree tree(2, capacity, &quadraticSplitStrategy);
+        tree.bulkLoad(bulkEntries);
+        std::atomic<bool> ingesting{false};
+        auto latencies = measure([&](const RTree::Region &query) { tree.intersectionQuery(query); }, ingesting);
+        print_latency_percentiles(latencies, "single-threaded, no ingest");
+    }
+    {
+        RTree::RTree tree(2, capacity, &quadraticSplitStrategy);
+        tree.bulkLoad(bulkEntries);
+        std::shared_mutex treeLock;
+        std::atomic<bool> ingesting{true};
+        std::thread writer([&]() {
+            for (size_t i = 0; i < ingest.size(); ++i) {
+                std::unique_lock<std::shared_mutex> lock(treeLock);
+                tree.insert(ingest[i], points_count + static_cast<id_type>(i));
+            }
+            ingesting = false;
+        });
+        auto latencies = measure([&](const RTree::Region &query) {
+            std::shared_lock<std::shared_mutex> lock(treeLock);
+            tree.intersectionQuery(query);
+        }, ingesting);
+        writer.join();
+        print_latency_percentiles(latencies, "global lock, ingesting");
+        printTestResult("ingested contents - global lock", sorted_ids(tree.intersectionQuery(whole_space())) == expected);
+    }
+    {
+        RTree::SnapshotRTree tree(2, capacity, &quadraticSplitStrategy);
+        tree.bulkLoad(bulkEntries);
+        std::atomic<bool> ingesting{true};
+        std::thread writer([&]() {
+            for (size_t i = 0; i < ingest.size(); ++i) {
+                tree.insert(ingest[i], points_count + static_cast<id_type>(i));
+            }
+            ingesting = false;
+        });
+        auto latencies = measure([&](const RTree::Region &query) { tree.intersectionQuery(query); }, ingesting);
+        writer.join();
+        print_latency_percentiles(latencies, "snapshot, ingesting");
+        printTestResult("ingested contents - snapshot", sorted_ids(tree.intersectionQuery(whole_space())) == expected);
+    }
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+
+// Bulk loads tree with points_count TestGenerator points of the given mode
+void load_join_points(int mode, double max_x, double max_y, int points_count, RTree::RTree &tree) {
+    std::vector<RTree::BulkEntry> entries;
+    {
+        std::vector<RTree::Point> points;
+        TestGenerator::generate_test_data(mode, max_x, max_y, points_count, points);
+        entries.reserve(points.size());
+        for (const auto & point : points) {
+            double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+            entries.emplace_back(RTree::Region(low, low, 2), point.getId());
+        }
+    }
+    tree.bulkLoad(entries);
+}
+
+// Uniformly placed windows of up to window_unit on each side, returned as well as loaded into tree
+std::vector<RTree::BulkEntry> load_join_windows(double max_x, double max_y, int windows_count, double window_unit,
+                                                RTree::RTree &tree) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<> x_dist(0, max_x), y_dist(0, max_y), size_dist(0, window_unit);
+    std::vector<RTree::BulkEntry> entries;
+    entries.reserve(windows_count);
+    for (int i = 0; i < windows_count; ++i) {
+        double low[2] = {x_dist(rng), y_dist(rng)};
+        double high[2] = {low[0] + size_dist(rng), low[1] + size_dist(rng)};
+        entries.emplace_back(RTree::Region(low, high, 2), i);
+    }
+    tree.bulkLoad(entries);
+    return entries;
+}
+
+// Pairs of points and windows that intersect, found by one window query per window on the point
+// tree, then by a spatial join of the point tree with a tree of the windows
+void spatial_join_benchmark(double max_x, double max_y, int points_count, int windows_count, int capacity,
+                            double window_unit) {
+    RTree::QuadraticSplitStrategy quadraticSplitStrategy;
+    RTree::RTree pointTree(2, capacity, &quadraticSplitStrategy);
+    load_join_points(0, max_x, max_y, points_count, pointTree);
+    RTree::RTree windowTree(2, capacity, &quadraticSplitStrategy);
+    const std::vector<RTree::BulkEntry> windowEntries =
+        load_join_windows(max_x, max_y, windows_count, window_unit, windowTree);
+
+    std::cout << "Spatial join, total points: " << points_count << ", windows: " << windows_count
+              << ", capacity: " << capacity << std::endl;
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    size_t nested_pairs = 0;
+    for (const auto & window : windowEntries) {
+        nested_pairs += pointTree.intersectionQuery(window.first).size();
+    }
+    long long nested_time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - startTime).count();
+
+    startTime = std::chrono::high_resolution_clock::now();
+    size_t join_pairs = 0;
+    RTree::spatialJoin(pointTree, windowTree, [&join_pairs](id_type, id_type) { ++join_pairs; });
+    long long join_time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - startTime).count();
+
+    printTestResult("spatial join pairs match window queries", nested_pairs == join_pairs);
+    std::cout << " Metric - join pairs: " << join_pairs << std::endl;
+    std::cout << " Metric - window query per window time: " << nested_time << std::endl;
+    std::cout << " Metric - spatial join time: " << join_time << std::endl;
+    std::cout << " Metric - spatial join speedup: " << static_cast<double>(nested_time) / std::max(join_time, 1LL)
+              << std::endl;
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+
+// Parallel spatial join of clustered points with uniform windows from 1 to N threads, against
+// the single threaded join
+void parallel_join_scaling(double max_x, double max_y, int points_count, int windows_count, int capacity,
+                           double window_unit) {
+    RTree::QuadraticSplitStrategy quadraticSplitStrategy;
+    RTree::RTree pointTree(2, capacity, &quadraticSplitStrategy);
+    load_join_points(2, max_x, max_y, points_count, pointTree);
+    RTree::RTree windowTree(2, capacity, &quadraticSplitStrategy);
+    load_join_windows(max_x, max_y, windows_count, window_unit, windowTree);
+
+    std::vector<unsigned> thread_counts = {1, 2, 4, 8, 16, 32, 64};
+    const unsigned hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    thread_counts.erase(std::remove_if(thread_counts.begin(), thread_counts.end(),
+                                       [&](unsigned threads) { return threads > hardware_threads; }),
+                        thread_counts.end());
+
+    std::cout << "Parallel spatial join, total points: " << points_count << ", windows: " << windows_count
+              << ", capacity: " << capacity << std::endl;
+
+    // Both collect the pairs, as the parallel join has to
+    auto startTime = std::chrono::high_resolution_clock::now();
+    std::vector<std::pair<id_type, id_type>> serial_pairs;
+    RTree::spatialJoin(pointTree, windowTree, [&serial_pairs](id_type point_id, id_type window_id)
+                       { serial_pairs.emplace_back(point_id, window_id); });
+    long long serial_time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - startTime).count();
+    const size_t serial_count = serial_pairs.size();
+    serial_pairs = {};
+    std::cout << " Metric - join pairs: " << serial_count << std::endl;
+    std::cout << " Metric - serial join time: " << serial_time << std::endl;
+
+    bool pairs_match = true;
+    for (unsigned threads : thread_counts) {
+        RTree::ThreadPool pool(threads);
+        startTime = std::chrono::high_resolution_clock::now();
+        const size_t pairs = RTree::spatialJoin(pointTree, windowTree, pool).size();
+        long long time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+        pairs_match = pairs_match && pairs == serial_count;
+        std::cout << " Metric - parallel join time " << threads << " threads: " << time << std::endl;
+        std::cout << " Metric - parallel join speedup " << threads << " threads: "
+                  << static_cast<double>(serial_time) / std::max(time, 1LL) << std::endl;
+    }
+    printTestResult("parallel spatial join pairs match serial join", pairs_match);
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+
+// Startup cost of a tree rebuilt by inserting every entry against one saved once and mapped,
+// and the window query time on each
+void persistence_benchmark(double max_x, double max_y, int points_count, int capacity, double window_unit) {
+    std::vector<RTree::Point> points;
+    TestGenerator::generate_test_data(0, max_x, max_y, points_count, points);
+    const std::string path = (std::filesystem::temp_directory_path() / "rtree_benchmark.rtree").string();
+
+    RTree::QuadraticSplitStrategy quadraticSplitStrategy;
+    RTree::RTree tree(2, capacity, &quadraticSplitStrategy);
+    auto startTime = std::chrono::high_resolution_clock::now();
+    for (const auto & point : points) {
+        double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+        tree.insert(RTree::Region(low, low, 2), point.getId());
+    }
+    long long build_time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - startTime).count();
+
+    startTime = std::chrono::high_resolution_clock::now();
+    RTree::saveTree(tree, path);
+    long long save_time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - startTime).count();
+
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<> x_dist(0, max_x), y_dist(0, max_y);
+    std::vector<RTree::Region> queries;
+    for (int i = 0; i < 10000; ++i) {
+        double low[2] = {x_dist(rng), y_dist(rng)};
+        double high[2] = {low[0] + window_unit, low[1] + window_unit};
+        queries.emplace_back(low, high, 2);
+    }
+
+    std::cout << "Persistence, total points: " << points.size() << ", capacity: " << capacity << std::endl;
+    {
+        startTime = std::chrono::high_resolution_clock::now();
+        RTree::MappedRTree mapped(path);
+        long long open_time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+
+        bool results_match = true;
+        long long tree_query_time = 0;
+        long long mapped_query_time = 0;
+        for (const auto & query : queries) {
+            startTime = std::chrono::high_resolution_clock::now();
+            const size_t tree_found = tree.intersectionQuery(query).size();
+            auto midTime = std::chrono::high_resolution_clock::now();
+            const size_t mapped_found = mapped.intersectionQuery(query).size();
+            auto endTime = std::chrono::high_resolution_clock::now();
+            tree_query_time += std::chrono::duration_cast<std::chrono::microseconds>(midTime - startTime).count();
+            mapped_query_time += std::chrono::duration_cast<std::chrono::microseconds>(endTime - midTime).count();
+            results_match = results_match && tree_found == mapped_found;
+        }
+
+        printTestResult("mapped tree results match", results_match);
+        std::cout << " Metric - build by insert time: " << build_time << std::endl;
+        std::cout << " Metric - save time: " << save_time << std::endl;
+        std::cout << " Metric - file size: " << std::filesystem::file_size(path) << std::endl;
+        std::cout << " Metric - map time: " << open_time << std::endl;
+        std::cout << " Metric - window query time - in memory: " << tree_query_time << std::endl;
+        std::cout << " Metric - window query time - mapped: " << mapped_query_time << std::endl;
+    }
+    std::filesystem::remove(path);
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+
+// Whether every window and 10nn query on the paged tree gives what it gives on the in-memory
+// reference holding the same entries; regions[id] is the box of entry id, nearest neighbors are
+// compared by distance as ties may come back in any order
+bool paged_matches(RTree::PagedRTree &paged, RTree::RTree &reference, const std::vector<RTree::Region> &regions,
+                   const std::vector<RTree::Region> &queries, const std::vector<RTree::Point> &query_points) {
+    for (const auto & query : queries) {
+        if (sorted_ids(paged.intersectionQuery(query)) != sorted_ids(reference.intersectionQuery(query))) {
+            return false;
+        }
+    }
+    for (const auto & point : query_points) {
+        std::vector<double> expected, found;
+        for (const RTree::Data *data : reference.nearestNeighbors(point, 10)) {
+            expected.push_back(data->getRegion().getMinDistance(point));
+        }
+        for (id_type id : paged.nearestNeighbors(point, 10)) {
+            found.push_back(regions[id].getMinDistance(point));
+        }
+        if (found != expected) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Disk-resident tree: page reads per insert while building, then page reads per window and
+// nearest-neighbor query after reopening it with buffer pools of growing size. Query results are
+// checked against an in-memory tree of the same points, and so is the tree as it is drained by
+// removes and reopened
+void paged_benchmark(double max_x, double max_y, int points_count, double window_unit) {
+    std::vector<RTree::Point> points;
+    TestGenerator::generate_test_data(0, max_x, max_y, points_count, points);
+    const std::string path = (std::filesystem::temp_directory_path() / "rtree_benchmark.pages").string();
+
+    std::vector<RTree::Region> regions;
+    std::vector<RTree::BulkEntry> bulkEntries;
+    for (const auto & point : points) {
+        double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+        regions.emplace_back(low, low, 2);
+        bulkEntries.emplace_back(regions.back(), point.getId());
+    }
+    RTree::QuadraticSplitStrategy quadraticSplitStrategy;
+    RTree::RTree reference(2, 64, &quadraticSplitStrategy);
+    reference.bulkLoad(bulkEntries);
+
+    std::cout << "Paged tree, total points: " << points.size() << std::endl;
+    {
+        RTree::PagedRTree tree(path, 2, 64 << 20);
+        auto startTime = std::chrono::high_resolution_clock::now();
+        for (const auto & point : points) {
+            double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+            tree.insert(RTree::Region(low, low, 2), point.getId());
+        }
+        tree.flush();
+        long long build_time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+        std::cout << " Metric - capacity: " << tree.getNodeCapacity() << std::endl;
+        std::cout << " Metric - pages: " << tree.getPageCount() << std::endl;
+        std::cout << " Metric - build time, 64MB pool: " << build_time << std::endl;
+        std::cout << " Metric - page reads per insert, 64MB pool: "
+                  << static_cast<double>(tree.getIOStats().reads) / points.size() << std::endl;
+    }
+
+    std::mt19937 rng(23);
+    std::uniform_real_distribution<> x_dist(0, max_x), y_dist(0, max_y);
+    std::vector<RTree::Region> queries;
+    std::vector<RTree::Point> query_points;
+    for (int i = 0; i < 10000; ++i) {
+        double low[2] = {x_dist(rng), y_dist(rng)};
+        double high[2] = {low[0] + window_unit, low[1] + window_unit};
+        queries.emplace_back(low, high, 2);
+        query_points.emplace_back(low, 2, i);
+    }
+
+    bool queries_match = true;
+    for (auto [budget, name] : {std::make_pair(size_t{1} << 20, "1MB"), std::make_pair(size_t{8} << 20, "8MB"),
+                                std::make_pair(size_t{64} << 20, "64MB")}) {
+        for (bool prefetch : {false, true}) {
+            RTree::PagedRTree tree(path, budget);
+            tree.setPrefetch(prefetch);
+            const std::string label = std::string(name) + " pool" + (prefetch ? ", prefetch" : "");
+
+            auto startTime = std::chrono::high_resolution_clock::now();
+            for (const auto & query : queries) {
+                tree.intersectionQuery(query);
+            }
+            long long window_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - startTime).count();
+            const uint64_t window_reads = tree.getIOStats().reads;
+
+            tree.resetIOStats();
+            startTime = std::chrono::high_resolution_clock::now();
+            for (const auto & point : query_points) {
+                tree.nearestNeighbors(point, 10);
+            }
+            long long knn_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - startTime).count();
+
+            std::cout << " Metric - window query time, " << label << ": " << window_time << std::endl;
+            std::cout << " Metric - page reads per window query, " << label << ": "
+                      << static_cast<double>(window_reads) / queries.size() << std::endl;
+            std::cout << " Metric - 10nn query time, " << label << ": " << knn_time << std::endl;
+            std::cout << " Metric - page reads per 10nn query, " << label << ": "
+                      << static_cast<double>(tree.getIOStats().reads) / query_points.size() << std::endl;
+
+            queries_match = queries_match && paged_matches(tree, reference, regions, queries, query_points);
+        }
+    }
+    printTestResult("paged queries match in-memory tree", queries_match);
+
+    // Removes half the points in random order, then the rest, reopening the file after each half
+    std::vector<size_t> order(points.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+    const size_t half = order.size() / 2;
+    bool removes_match = true;
+    for (auto [begin, end] : {std::make_pair(size_t{0}, half), std::make_pair(half, order.size())}) {
+        {
+            RTree::PagedRTree tree(path, size_t{1} << 20);
+            for (size_t i = begin; i < end; ++i) {
+                const RTree::BulkEntry &entry = bulkEntries[order[i]];
+                removes_match = removes_match && tree.remove(entry.first, entry.second) &&
+                                !tree.remove(entry.first, entry.second);
+                reference.remove(entry.first, entry.second);
+            }
+            removes_match = removes_match && paged_matches(tree, reference, regions, queries, query_points);
+        }
+        RTree::PagedRTree tree(path, size_t{1} << 20);
+        removes_match = removes_match && tree.size() == points.size() - end &&
+                        paged_matches(tree, reference, regions, queries, query_points);
+    }
+    printTestResult("paged removes match in-memory tree", removes_match);
+    bool drained;
+    {
+        RTree::PagedRTree tree(path, size_t{1} << 20);
+        drained = tree.size() == 0 && tree.getHeight() == 1 && tree.intersectionQuery(whole_space()).empty();
+        tree.insert(bulkEntries[0].first, bulkEntries[0].second);
+    }
+    {
+        RTree::PagedRTree tree(path, size_t{1} << 20);
+        printTestResult("drained paged tree takes inserts again",
+                        drained && tree.intersectionQuery(whole_space()) == std::vector<id_type>{bulkEntries[0].second});
+    }
+    std::filesystem::remove(path);
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+
+// Resident set size of the process, 0 where /proc is not available
+size_t resident_bytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Tree built by inserts against its frozen copy: memory, and the time of every query type on the
+// same inputs
+void freeze_benchmark(double max_x, double max_y, int points_count, int capacity, double window_unit) {
+    std::vector<RTree::Point> points;
+    TestGenerator::generate_test_data(0, max_x, max_y, points_count, points);
+
+    std::mt19937 rng(29);
+    std::uniform_real_distribution<> x_dist(0, max_x), y_dist(0, max_y);
+    std::uniform_int_distribution<size_t> point_dist(0, points.size() - 1);
+    std::vector<RTree::Region> queries;
+    std::vector<RTree::Point> query_points;
+    std::vector<RTree::Point> knn_points;
+    for (int i = 0; i < 10000; ++i) {
+        double low[2] = {x_dist(rng), y_dist(rng)};
+        double high[2] = {low[0] + window_unit, low[1] + window_unit};
+        queries.emplace_back(low, high, 2);
+        knn_points.emplace_back(low, 2, i);
+        query_points.push_back(points[point_dist(rng)]);
+    }
+
+    RTree::QuadraticSplitStrategy quadraticSplitStrategy;
+    std::cout << "Frozen tree, total points: " << points.size() << ", capacity: " << capacity << std::endl;
+
+    const size_t resident_before = resident_bytes();
+    RTree::RTree tree(2, capacity, &quadraticSplitStrategy);
+    for (const auto & point : points) {
+        double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+        tree.insert(RTree::Region(low, low, 2), point.getId());
+    }
+    const size_t tree_bytes = resident_bytes() - resident_before;
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    const RTree::FrozenRTree frozen = tree.freeze();
+    long long freeze_time = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::high_resolution_clock::now() - startTime).count();
+
+    auto time_queries = [](auto &&run) {
+        auto startTime = std::chrono::high_resolution_clock::now();
+        run();
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+    };
+
+    bool results_match = true;
+    size_t tree_found = 0, frozen_found = 0;
+    long long tree_window_time = time_queries([&] {
+        for (const auto & query : queries) tree_found += tree.intersectionQuery(query).size();
+    });
+    long long frozen_window_time = time_queries([&] {
+        for (const auto & query : queries) frozen_found += frozen.intersectionQuery(query).size();
+    });
+    results_match = results_match && tree_found == frozen_found;
+
+    tree_found = frozen_found = 0;
+    long long tree_point_time = time_queries([&] {
+        for (const auto & point : query_points) tree_found += tree.pointQuery(point).size();
+    });
+    long long frozen_point_time = time_queries([&] {
+        for (const auto & point : query_points) frozen_found += frozen.pointQuery(point).size();
+    });
+    results_match = results_match && tree_found == frozen_found;
+
+    std::vector<std::vector<RTree::Data *>> tree_neighbors;
+    std::vector<std::vector<id_type>> frozen_neighbors;
+    long long tree_knn_time = time_queries([&] {
+        for (const auto & point : knn_points) tree_neighbors.push_back(tree.nearestNeighbors(point, 10));
+    });
+    long long frozen_knn_time = time_queries([&] {
+        for (const auto & point : knn_points) frozen_neighbors.push_back(frozen.nearestNeighbors(point, 10));
+    });
+    for (size_t i = 0; i < knn_points.size(); ++i) {
+        results_match = results_match && tree_neighbors[i].size() == frozen_neighbors[i].size();
+    }
+
+    tree_found = frozen_found = 0;
+    long long tree_batch_time = time_queries([&] {
+        for (const auto & result : tree.intersectionQueryBatch(queries)) tree_found += result.size();
+    });
+    long long frozen_batch_time = time_queries([&] {
+        for (const auto & result : frozen.intersectionQueryBatch(queries)) frozen_found += result.size();
+    });
+    results_match = results_match && tree_found == frozen_found;
+
+    printTestResult("frozen tree results match", results_match);
+    std::cout << " Metric - freeze time: " << freeze_time << std::endl;
+    std::cout << " Metric - bytes per entry - tree: " << static_cast<double>(tree_bytes) / points.size() << std::endl;
+    std::cout << " Metric - bytes per entry - frozen: "
+              << static_cast<double>(frozen.getMemoryUsage()) / points.size() << std::endl;
+    std::cout << " Metric - window query time - tree: " << tree_window_time << std::endl;
+    std::cout << " Metric - window query time - frozen: " << frozen_window_time << std::endl;
+    std::cout << " Metric - point query time - tree: " << tree_point_time << std::endl;
+    std::cout << " Metric - point query time - frozen: " << frozen_point_time << std::endl;
+    std::cout << " Metric - 10NN query time - tree: " << tree_knn_time << std::endl;
+    std::cout << " Metric - 10NN query time - frozen: " << frozen_knn_time << std::endl;
+    std::cout << " Metric - batch window query time - tree: " << tree_batch_time << std::endl;
+    std::cout << " Metric - batch window query time - frozen: " << frozen_batch_time << std::endl;
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+
+// Frozen copies of one tree with exact, 16-bit and 8-bit node boxes: memory, query times, and the
+// node sizes and false positive rates construction_finished reports
+void quantized_node_benchmark(double max_x, double max_y, int points_count, int capacity, double window_unit) {
+    std::vector<RTree::Point> points;
+    TestGenerator::generate_test_data(0, max_x, max_y, points_count, points);
+
+    std::mt19937 rng(31);
+    std::uniform_real_distribution<> x_dist(0, max_x), y_dist(0, max_y);
+    std::vector<RTree::Region> queries;
+    std::vector<RTree::Point> query_points;
+    for (int i = 0; i < 10000; ++i) {
+        double low[2] = {x_dist(rng), y_dist(rng)};
+        double high[2] = {low[0] + window_unit, low[1] + window_unit};
+        queries.emplace_back(low, high, 2);
+        query_points.emplace_back(low, 2, i);
+    }
+
+    RTree::QuadraticSplitStrategy quadraticSplitStrategy;
+    RTree::RTree tree(2, capacity, &quadraticSplitStrategy);
+    for (const auto & point : points) {
+        double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+        tree.insert(RTree::Region(low, low, 2), point.getId());
+    }
+    tree.construction_finished();
+
+    std::cout << "Quantized node boxes, total points: " << points.size() << ", capacity: " << capacity << std::endl;
+    tree.print_construction_metrics("quadratic");
+
+    bool results_match = true;
+    size_t exact_found = 0;
+    for (auto [encoding, name] : {std::make_pair(RTree::BoxEncoding::Exact, "exact"),
+                                  std::make_pair(RTree::BoxEncoding::Quantized16, "16-bit"),
+                                  std::make_pair(RTree::BoxEncoding::Quantized8, "8-bit")}) {
+        const RTree::FrozenRTree frozen = tree.freeze(encoding);
+
+        size_t found = 0;
+        auto startTime = std::chrono::high_resolution_clock::now();
+        for (const auto & query : queries) {
+            found += frozen.intersectionQuery(query).size();
+        }
+        long long window_time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+
+        startTime = std::chrono::high_resolution_clock::now();
+        for (const auto & point : query_points) {
+            frozen.nearestNeighbors(point, 10);
+        }
+        long long knn_time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+
+        if (encoding == RTree::BoxEncoding::Exact) {
+            exact_found = found;
+        }
+        results_match = results_match && found == exact_found;
+        std::cout << " Metric - bytes per entry - " << name << ": "
+                  << static_cast<double>(frozen.getMemoryUsage()) / points.size() << std::endl;
+        std::cout << " Metric - window query time - " << name << ": " << window_time << std::endl;
+        std::cout << " Metric - 10NN query time - " << name << ": " << knn_time << std::endl;
+    }
+    printTestResult("quantized tree results match", results_match);
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+
+// Sliding window over a stream of points: every step removes the oldest point and inserts a new one
+void id_index_benchmark(double max_x, double max_y, int points_count, int capacity, int operations) {
+    std::vector<RTree::Point> points;
+    TestGenerator::generate_test_data(0, max_x, max_y, points_count, points);
+
+    std::mt19937 rng(37);
+    std::uniform_real_distribution<> x_dist(0, max_x), y_dist(0, max_y);
+    std::vector<std::pair<RTree::Region, id_type>> stream;
+    for (int i = 0; i < operations; ++i) {
+        double low[2] = {x_dist(rng), y_dist(rng)};
+        stream.emplace_back(RTree::Region(low, low, 2), points_count + i);
+    }
+
+    std::cout << "Id index, total points: " << points.size() << ", stream operations: " << operations << std::endl;
+    RTree::QuadraticSplitStrategy quadraticSplitStrategy;
+    RTree::RStarSplitStrategy rstarSplitStrategy;
+    for (auto [strategy, strategy_name] : {std::make_pair(static_cast<const RTree::SplitStrategy *>(&quadraticSplitStrategy), "quadratic"),
+                                           std::make_pair(static_cast<const RTree::SplitStrategy *>(&rstarSplitStrategy), "rstar")}) {
+        std::vector<size_t> final_counts;
+        for (bool indexed : {false, true}) {
+            RTree::RTree tree(2, capacity, strategy);
+            if (indexed) {
+                tree.enableIdIndex();
+            }
+            std::vector<std::pair<RTree::Region, id_type>> window;
+            for (const auto & point : points) {
+                double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+                window.emplace_back(RTree::Region(low, low, 2), point.getId());
+                tree.insert(window.back().first, window.back().second);
+            }
+
+            std::vector<long long> latencies;
+            latencies.reserve(operations);
+            long long remove_time = 0;
+            bool all_removed = true;
+            for (int i = 0; i < operations; ++i) {
+                const auto & oldest = window[i];
+                auto startTime = std::chrono::high_resolution_clock::now();
+                all_removed = tree.remove(oldest.first, oldest.second) && all_removed;
+                auto endTime = std::chrono::high_resolution_clock::now();
+                latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count());
+                remove_time += latencies.back();
+                window.push_back(stream[i]);
+                tree.insert(stream[i].first, stream[i].second);
+            }
+
+            const std::string name = std::string(strategy_name) + (indexed ? ", indexed" : "");
+            std::cout << " Metric - remove time us - " << name << ": " << remove_time / 1000 << std::endl;
+            std::sort(latencies.begin(), latencies.end());
+            std::cout << " p50 remove latency ns - " << name << ": " << latencies[latencies.size() / 2] << std::endl;
+            std::cout << " p99 remove latency ns - " << name << ": "
+                      << latencies[static_cast<size_t>(0.99 * (latencies.size() - 1))] << std::endl;
+            printTestResult("stream removes found - " + name, all_removed);
+
+            double low[2] = {0, 0}, high[2] = {max_x, max_y};
+            final_counts.push_back(tree.intersectionQuery(RTree::Region(low, high, 2)).size());
+        }
+        printTestResult("indexed tree matches - " + std::string(strategy_name),
+                        final_counts[0] == final_counts[1] && final_counts[1] == points.size());
+    }
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+// Every tick each object moves by a small random displacement, either as remove + insert or as one update
+void moving_objects_benchmark(double max_x, double max_y, int points_count, int capacity, int ticks, double max_step) {
+    std::vector<RTree::Point> points;
+    TestGenerator::generate_test_data(0, max_x, max_y, points_count, points);
+
+    std::mt19937 rng(41);
+    std::uniform_real_distribution<> step(-max_step, max_step);
+    std::vector<std::vector<RTree::Region>> positions(ticks + 1);
+    for (const auto & point : points) {
+        double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+        positions[0].emplace_back(low, low, 2);
+    }
+    for (int tick = 1; tick <= ticks; ++tick) {
+        for (const auto & region : positions[tick - 1]) {
+            double low[2] = {std::clamp(region.getLow(0) + step(rng), 0.0, max_x),
+                             std::clamp(region.getLow(1) + step(rng), 0.0, max_y)};
+            positions[tick].emplace_back(low, low, 2);
+        }
+    }
+
+    std::cout << "Moving objects, total points: " << points.size() << ", ticks: " << ticks
+              << ", max step: " << max_step << std::endl;
+    RTree::QuadraticSplitStrategy quadraticSplitStrategy;
+    std::vector<size_t> final_counts;
+    for (int variant = 0; variant < 3; ++variant) {
+        const bool use_update = variant > 0;
+        const bool indexed = variant == 2;
+        RTree::RTree tree(2, capacity, &quadraticSplitStrategy);
+        if (indexed) {
+            tree.enableIdIndex();
+        }
+        for (size_t i = 0; i < points.size(); ++i) {
+            tree.insert(positions[0][i], points[i].getId());
+        }
+
+        bool all_moved = true;
+        auto startTime = std::chrono::high_resolution_clock::now();
+        for (int tick = 1; tick <= ticks; ++tick) {
+            for (size_t i = 0; i < points.size(); ++i) {
+                if (use_update) {
+                    all_moved = tree.update(points[i].getId(), positions[tick - 1][i], positions[tick][i]) && all_moved;
+                } else {
+                    all_moved = tree.remove(positions[tick - 1][i], points[i].getId()) && all_moved;
+                    tree.insert(positions[tick][i], points[i].getId());
+                }
+            }
+        }
+        long long move_time = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::high_resolution_clock::now() - startTime).count();
+
+        double low[2] = {0, 0}, high[2] = {max_x / 2, max_y / 2};
+        final_counts.push_back(tree.intersectionQuery(RTree::Region(low, high, 2)).size());
+
+        const std::string name = !use_update ? "remove + insert" : indexed ? "update, indexed" : "update";
+        std::cout << " Metric - move time - " << name << ": " << move_time << std::endl;
+        std::cout << " Metric - moves per second - " << name << ": "
+                  << static_cast<double>(ticks) * points.size() * 1e6 / std::max<long long>(move_time, 1) << std::endl;
+        printTestResult("every object moved - " + name, all_moved);
+    }
+    printTestResult("moved trees match", final_counts[0] == final_counts[1] && final_counts[1] == final_counts[2]);
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+// Every round removes half the points at random and inserts as many new ones, so the tree keeps its
+// size while the removes thin out every node
+void delete_heavy_benchmark(double max_x, double max_y, int points_count, int capacity, int rounds,
+                            double window_unit) {
+    std::vector<RTree::Point> points;
+    TestGenerator::generate_test_data(0, max_x, max_y, points_count, points);
+
+    std::mt19937 query_rng(43);
+    std::uniform_real_distribution<> x_dist(0, max_x), y_dist(0, max_y);
+    std::vector<RTree::Region> queries;
+    for (int i = 0; i < 10000; ++i) {
+        double low[2] = {x_dist(query_rng), y_dist(query_rng)};
+        double high[2] = {low[0] + window_unit, low[1] + window_unit};
+        queries.emplace_back(low, high, 2);
+    }
+
+    std::cout << "Delete-heavy churn, total points: " << points.size() << ", rounds: " << rounds << std::endl;
+    RTree::QuadraticSplitStrategy quadraticSplitStrategy;
+    for (double minimum_fill : {0.0, 0.4}) {
+        RTree::RTree tree(2, capacity, &quadraticSplitStrategy);
+        tree.setMinimumFill(minimum_fill);
+        std::vector<std::pair<RTree::Region, id_type>> live;
+        for (const auto & point : points) {
+            double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+            live.emplace_back(RTree::Region(low, low, 2), point.getId());
+            tree.insert(live.back().first, live.back().second);
+        }
+
+        const std::string name = "minimum fill " + std::to_string(minimum_fill).substr(0, 3);
+        std::mt19937 rng(47);
+        id_type next_id = points_count;
+        bool all_removed = true;
+        for (int round = 0; round <= rounds; ++round) {
+            if (round > 0) {
+                std::shuffle(live.begin(), live.end(), rng);
+                const size_t removes = live.size() / 2;
+                for (size_t i = 0; i < removes; ++i) {
+                    all_removed = tree.remove(live.back().first, live.back().second) && all_removed;
+                    live.pop_back();
+                }
+                for (size_t i = 0; i < removes; ++i) {
+                    double low[2] = {x_dist(rng), y_dist(rng)};
+                    live.emplace_back(RTree::Region(low, low, 2), next_id++);
+                    tree.insert(live.back().first, live.back().second);
+                }
+            }
+
+            auto startTime = std::chrono::high_resolution_clock::now();
+            for (const auto & query : queries) {
+                tree.intersectionQuery(query);
+            }
+            long long window_time = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::high_resolution_clock::now() - startTime).count();
+            std::cout << " Metric - window query time round " << round << " - " << name << ": " << window_time
+                      << std::endl;
+            std::cout << " Metric - nodes round " << round << " - " << name << ": "
+                      << tree.freeze().getNodeCount() << std::endl;
+        }
+        std::cout << " Metric - height - " << name << ": " << tree.getHeight() << std::endl;
+        printTestResult("churn removes found - " + name, all_removed);
+    }
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+void insert_capacity_scaling(double max_x, double max_y, int points_count) {
+    std::vector<RTree::Point> points;
+    TestGenerator::generate_test_data(1, max_x, max_y, points_count, points);
+
+    // Wide nodes are where a rescan of every entry per insert used to dominate the insert time
+    std::cout << "Insert capacity scaling, total points: " << points.size() << std::endl;
+    RTree::LinearSplitStrategy linearSplitStrategy;
+    RTree::RStarSplitStrategy rstarSplitStrategy;
+    for (int capacity : {256, 512, 1024, 2048}) {
+        std::cout << "capacity: " << capacity << std::endl;
+        RTree::RTree linearTree(2, capacity, &linearSplitStrategy);
+        RTree::RTree rstarTree(2, capacity, &rstarSplitStrategy);
+        for (const auto & point : points) {
+            double low[2] = {point.getCoordinate(0), point.getCoordinate(1)};
+            linearTree.insert(RTree::Region(low, low, 2), point.getId());
+            rstarTree.insert(RTree::Region(low, low, 2), point.getId());
+        }
+        linearTree.construction_finished();
+        rstarTree.construction_finished();
+
+        linearTree.print_construction_metrics("linear capacity " + std::to_string(capacity));
+        rstarTree.print_construction_metrics("r-star capacity " + std::to_string(capacity));
+
+        double low[2] = {0, 0};
+        double high[2] = {max_x, max_y};
+        const RTree::Region everything(low, high, 2);
+        printTestResult("all inserted - capacity " + std::to_string(capacity),
+                        linearTree.intersectionQuery(everything).size() == points.size() &&
+                            rstarTree.intersectionQuery(everything).size() == points.size());
+    }
+    std::cout << "Benchmark Split @@" << std::endl;
+}
+
+int main(int argc, char *argv[])
 {
     constexpr int max_x = 1000;
     constexpr int max_y = 1000;
 
+    // The full-size benchmarks take many minutes and several GB. Without --full, those that check
+    // their results run on small inputs for the checks alone and the pure scaling runs are skipped.
+    const bool full = argc > 1 && std::string(argv[1]) == "--full";
+
     int points_count_to_test[] = {500, 1000, 10000, 50000, 100000};
     // int points_count_to_test[] = {50000, 60000, 70000, 80000, 90000, 100000};
     std::vector<RTree::Point> points;
     int modes [] = {0, 1, 2, 3, 4, 5};
     // int modes [] = {0, 1};
 
+    duplicate_boxes_check(20, 4);
+    simd_benchmark(max_x, max_y, 32, 20000);
+    simd_benchmark(max_x, max_y, 256, 2000);
+    if (full) {
+        bulk_load_scaling(max_x, max_y, 2000000, 32);
+        query_scaling(max_x, max_y, 1000000, 32, 5);
+    }
+    mixed_workload_scaling(max_x, max_y, 200000, 32, 50000);
+    snapshot_read_latency(max_x, max_y, full ? 200000 : 20000, 32, full ? 100000 : 10000, 10);
+    spatial_join_benchmark(max_x, max_y, full ? 1000000 : 20000, full ? 200000 : 4000, 32, 5);
+    parallel_join_scaling(max_x, max_y, full ? 10000000 : 20000, full ? 1000000 : 4000, 32, 5);
+    persistence_benchmark(max_x, max_y, full ? 1000000 : 20000, 32, 5);
+    paged_benchmark(max_x, max_y, full ? 1000000 : 20000, 5);
+    freeze_benchmark(max_x, max_y, full ? 1000000 : 20000, 32, 5);
+    quantized_node_benchmark(max_x, max_y, full ? 1000000 : 20000, 128, 5);
+    id_index_benchmark(max_x, max_y, 200000, 32, 200000);
+    moving_objects_benchmark(max_x, max_y, 100000, 32, 5, 0.5);
+    delete_heavy_benchmark(max_x, max_y, 200000, 32, 8, 5);
+    insert_capacity_scaling(max_x, max_y, 100000);
+
     for(int mode : modes) {
         for(int points_count: points_count_to_test) {
             points.clear();